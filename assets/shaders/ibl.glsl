@@ -0,0 +1,31 @@
+#pragma once
+// Image based lighting, uniforms set by EnvironmentLighting::apply
+
+uniform vec3 irradianceSH[9];      // irradiance / pi, see IBLBaker
+uniform samplerCube prefilteredMap; // GGX prefiltered, lod = roughness * prefilteredLevels
+uniform float prefilteredLevels;    // mip count - 1, the lod of roughness 1
+uniform sampler2D brdfLut;          // split-sum scale and bias of F0
+
+// Lambert diffuse for a unit normal, multiply by albedo
+vec3 iblDiffuse(vec3 n)
+{
+    vec3 result = irradianceSH[0] * 0.282095
+        + irradianceSH[1] * (0.488603 * n.y)
+        + irradianceSH[2] * (0.488603 * n.z)
+        + irradianceSH[3] * (0.488603 * n.x)
+        + irradianceSH[4] * (1.092548 * n.x * n.y)
+        + irradianceSH[5] * (1.092548 * n.y * n.z)
+        + irradianceSH[6] * (0.315392 * (3.0 * n.z * n.z - 1.0))
+        + irradianceSH[7] * (1.092548 * n.x * n.z)
+        + irradianceSH[8] * (0.546274 * (n.x * n.x - n.y * n.y));
+    return max(result, vec3(0.0));
+}
+
+// GGX specular for unit normal n and view vector v (towards the eye)
+vec3 iblSpecular(vec3 n, vec3 v, vec3 f0, float roughness)
+{
+    vec3 r = reflect(-v, n);
+    vec3 prefiltered = textureLod(prefilteredMap, r, roughness * prefilteredLevels).rgb;
+    vec2 brdf = texture(brdfLut, vec2(max(dot(n, v), 0.0), roughness)).rg;
+    return prefiltered * (f0 * brdf.x + brdf.y);
+}
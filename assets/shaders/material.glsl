@@ -0,0 +1,52 @@
+#pragma once
+// Material table and texture pages, bound by MaterialLibrary::bind.
+// The material index comes in as a vertex attribute, passed on flat:
+//     layout(location = 8) in int aMaterial;   // vertex shader
+//     flat out int vMaterial;                  // vMaterial = aMaterial;
+//     flat in int vMaterial;                   // fragment shader
+
+uniform sampler2DArray materialPage0;
+uniform sampler2DArray materialPage1;
+uniform sampler2DArray materialPage2;
+uniform sampler2DArray materialPage3;
+uniform samplerBuffer materialTable;   // 8 texels per material, see MaterialLibrary
+
+const int MATERIAL_DIFFUSE = 0;
+const int MATERIAL_SPECULAR = 1;
+const int MATERIAL_NORMAL = 2;
+
+struct Material
+{
+    vec4 baseColor;
+    vec4 params;
+};
+
+Material loadMaterial(int index)
+{
+    Material material;
+    material.baseColor = texelFetch(materialTable, index * 8);
+    material.params = texelFetch(materialTable, index * 8 + 1);
+    return material;
+}
+
+// Texture of one slot, or fallback when the material has none there.
+// Derivatives are taken before branching on the page, so every page is
+// filtered like a plain texture lookup. Normal maps come back as stored
+// (BC5 pages hold x and y only).
+vec4 sampleMaterial(int index, int slot, vec2 uv, vec4 fallback)
+{
+    vec4 location = texelFetch(materialTable, index * 8 + 2 + slot * 2);
+    vec4 rect = texelFetch(materialTable, index * 8 + 3 + slot * 2);
+    vec2 dx = dFdx(uv) * rect.xy;
+    vec2 dy = dFdy(uv) * rect.xy;
+    // atlas entries wrap inside their own rectangle
+    vec2 pageUv = location.z > 0.5 ? rect.zw + fract(uv) * rect.xy : uv;
+    vec3 coord = vec3(pageUv, location.y);
+
+    int page = int(location.x);
+    if (page == 0) return textureGrad(materialPage0, coord, dx, dy);
+    if (page == 1) return textureGrad(materialPage1, coord, dx, dy);
+    if (page == 2) return textureGrad(materialPage2, coord, dx, dy);
+    if (page == 3) return textureGrad(materialPage3, coord, dx, dy);
+    return fallback;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "engine/Model.h"
+class Shader;
+
+enum class LoadState { Queued, Loading, Uploading, Ready, Failed };
+
+// Handle to a Model that is loaded in the background
+class ModelHandle
+{
+public:
+    LoadState getState() const { return state.load(); }
+    bool isReady() const { return getState() == LoadState::Ready; }
+    const std::string& getPath() const { return path; }
+
+    // The loaded model, nullptr until Ready
+    Model* get() const { return isReady() ? model.get() : nullptr; }
+    // Draws nothing until the uploads are complete
+    void Draw(Shader& shader);
+
+    // Time from the load request until the model was published (ms)
+    double getLoadMs() const { return loadMs; }
+
+private:
+    friend class AsyncModelLoader;
+
+    std::string path;
+    ModelOptions options;
+    std::vector<std::string> skipNames;
+
+    std::atomic<LoadState> state{ LoadState::Queued };
+    std::unique_ptr<Model> model;
+    GLsync fence = nullptr;
+    std::chrono::steady_clock::time_point requested;
+    double loadMs = 0.0;
+};
+
+// Imports models and uploads their buffers/textures on a background thread
+// that owns a hidden GLFW context sharing objects with the main window.
+// Construct and destroy on the main thread.
+class AsyncModelLoader
+{
+public:
+    explicit AsyncModelLoader(GLFWwindow* mainWindow);
+    ~AsyncModelLoader();
+
+    // Prevent copying
+    AsyncModelLoader(const AsyncModelLoader&) = delete;
+    AsyncModelLoader& operator=(const AsyncModelLoader&) = delete;
+
+    // Queues a load and returns immediately
+    std::shared_ptr<ModelHandle> load(const std::string& path,
+        const ModelOptions& options = ModelOptions(),
+        const std::vector<std::string>& skipNames = {});
+
+    // Publishes models whose upload fence has signaled and deletes textures the
+    // TextureRegistry evicted, call once per frame
+    void poll();
+
+    // Loads that are queued, importing or waiting on their fence
+    size_t pendingCount() const;
+    // Main thread cost of the last poll (ms)
+    double getLastPollMs() const { return lastPollMs; }
+
+private:
+    GLFWwindow* uploadContext = nullptr;
+    std::thread worker;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::shared_ptr<ModelHandle>> queue;
+    std::vector<std::shared_ptr<ModelHandle>> inFlight;
+    size_t loading = 0;
+    bool stopping = false;
+    double lastPollMs = 0.0;
+
+    void workerLoop();
+};
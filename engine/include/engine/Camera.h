@@ -4,6 +4,7 @@
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include "engine/FrustumCuller.h"
 
 enum class CamMode { Free, Cinema };
 
@@ -63,6 +64,11 @@ public:
 	void updateMatrix(float nearPlane, float farPlane);
 	// Exports the camera matrix to a shader
 	void Matrix(class Shader& shader, const char* uniform) const;
+	// Writes view, projection, position and time to the shared FrameData block,
+	// once per frame for every shader declaring it
+	void UploadFrame(float time) const;
+	// World space frustum of the last updateMatrix
+	Frustum getFrustum() const;
 	// Updates stored window size
 	void setSize(int newWidth, int newHeight);
 	// Call from GLFW scroll callback
@@ -1,12 +1,22 @@
 #pragma once
 
 #include <glad/glad.h>
+#include <memory>
+#include <string>
+#include "engine/CubemapBaker.h"
 
 class Cubemap {
 public:
     GLuint ID = 0;
     int size = 0;
+    int levels = 1;
 
     Cubemap(int resolution);
+    // Uploads a CPU baked cubemap with all of its mip levels
+    explicit Cubemap(const CubemapImage& image);
+    // Environment from an equirect .hdr through the CPU bake and its cache
+    // file, no render passes; nullptr when the source cannot be read
+    static std::unique_ptr<Cubemap> fromEquirect(const std::string& hdrPath,
+        const CubemapBakeOptions& options = CubemapBakeOptions());
     void Bind(GLuint unit = 0) const;
 };
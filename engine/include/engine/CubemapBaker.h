@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+struct CubemapBakeOptions
+{
+    int size = 512;          // face resolution of level 0
+    int supersample = 1;     // n x n samples per texel
+    bool mipmaps = true;     // full chain down to 1x1 (2x2 box filter)
+};
+
+// Cubemap pixels on the CPU: RGB half floats, ready for a GL_RGB16F upload.
+// Faces follow GL order (+X, -X, +Y, -Y, +Z, -Z), rows bottom-up like
+// glTexImage2D expects.
+struct CubemapImage
+{
+    int size = 0;
+    int levels = 0;
+    std::vector<std::vector<uint16_t>> faces; // [level * 6 + face]
+
+    int levelSize(int level) const { return std::max(1, size >> level); }
+    const uint16_t* face(int level, int face) const { return faces[size_t(level) * 6 + face].data(); }
+    bool isValid() const { return size > 0 && faces.size() == size_t(levels) * 6; }
+};
+
+// CPU version of HDRConverter: projects an equirectangular HDR image onto the
+// six faces exactly as hdr2cubemap.frag does (same per-face view matrices,
+// same atan/asin mapping), with bilinear taps and optional supersampling.
+// Rows of faces run on the shared ThreadPool, four texels per SSE step.
+// Baked results live in a cache file next to the source, so environment setup
+// is one file read, and baking needs no GL context.
+class CubemapBaker
+{
+public:
+    // bump whenever the file layout or the projection changes
+    static constexpr uint32_t VERSION = 1;
+
+    // equirect: RGB floats, rows bottom-up (as HDRTexture uploads them)
+    static CubemapImage bake(const float* equirect, int width, int height,
+        const CubemapBakeOptions& options = CubemapBakeOptions());
+    // Loads the .hdr with stb_image and bakes it, false when it cannot be read
+    static bool bakeFile(const std::string& hdrPath, CubemapImage& out,
+        const CubemapBakeOptions& options = CubemapBakeOptions());
+
+    // Cache file next to the source, one per face size
+    static std::string cachePathFor(const std::string& hdrPath, const CubemapBakeOptions& options);
+    static bool write(const std::string& cachePath, const std::string& hdrPath,
+        const CubemapBakeOptions& options, const CubemapImage& image);
+    // Fails when missing, stale (source size/time or options changed) or malformed
+    static bool read(const std::string& cachePath, const std::string& hdrPath,
+        const CubemapBakeOptions& options, CubemapImage& out);
+    // Cache first, bake (and write the cache) on a miss
+    static bool loadOrBake(const std::string& hdrPath, CubemapImage& out,
+        const CubemapBakeOptions& options = CubemapBakeOptions());
+
+    // Unnormalized world direction through face coordinates u, v in [-1, 1],
+    // in the face layout of the bake (GL cube map convention)
+    static void texelDirection(int face, float u, float v, float dir[3]);
+    // Inverse of texelDirection: face and coordinates u, v in [-1, 1] hit by dir
+    static void directionToFace(const float dir[3], int& face, float& u, float& v);
+};
@@ -2,6 +2,7 @@
 
 #include <glad/glad.h>
 #include <vector>
+#include <cstddef>
 
 class EBO
 {
@@ -10,6 +11,9 @@ public:
 	GLuint ID;
 	// Constructor that generates a Elements Buffer Object and links it to indices
 	EBO(const std::vector<GLuint>& indices);
+	// Same, uploading straight from memory (e.g. a mapped cache file).
+	// With GL_UNSIGNED_SHORT the indices are narrowed to 16 bits on upload.
+	EBO(const GLuint* indices, size_t count, GLenum type = GL_UNSIGNED_INT);
 	// Destructor
 	~EBO() {
 		if (ID != 0) Delete();
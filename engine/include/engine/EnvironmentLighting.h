@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <memory>
+#include <string>
+#include "engine/Cubemap.h"
+#include "engine/IBLBaker.h"
+
+class Shader;
+
+// GPU side of IBLBaker: the prefiltered specular cubemap, the BRDF LUT and
+// the irradiance SH, bound for shaders that include ibl.glsl. Ambient light
+// then costs one SH evaluation plus one prefiltered lookup per pixel.
+// Construct on the render context: it enables GL_TEXTURE_CUBE_MAP_SEAMLESS there.
+class EnvironmentLighting
+{
+public:
+    explicit EnvironmentLighting(const IBLData& data);
+    ~EnvironmentLighting();
+    // IBLBaker::loadOrBake plus the upload; nullptr when the source cannot be read
+    static std::unique_ptr<EnvironmentLighting> fromEquirect(const std::string& hdrPath,
+        const IBLBakeOptions& options = IBLBakeOptions());
+
+    // Prevent copying (avoid double-delete)
+    EnvironmentLighting(const EnvironmentLighting&) = delete;
+    EnvironmentLighting& operator=(const EnvironmentLighting&) = delete;
+
+    // Binds both textures and sets the ibl.glsl uniforms on an active shader
+    void apply(const Shader& shader, GLuint specularUnit = 1, GLuint lutUnit = 2) const;
+
+    const Cubemap& getSpecular() const { return *specular; }
+    GLuint getBrdfLut() const { return brdfLut; }
+    const glm::vec3* getSH() const { return sh; }
+
+private:
+    std::unique_ptr<Cubemap> specular;
+    GLuint brdfLut = 0;
+    glm::vec3 sh[9];
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// View frustum as six inward-facing planes (xyz normal, w distance)
+struct Frustum
+{
+    enum { Left, Right, Bottom, Top, Near, Far };
+    glm::vec4 planes[6];
+
+    // Gribb/Hartmann extraction from a projection * view matrix
+    static Frustum fromMatrix(const glm::mat4& viewProjection);
+
+    bool intersectsAABB(const glm::vec3& min, const glm::vec3& max) const;
+    bool intersectsSphere(const glm::vec3& center, float radius) const;
+};
+
+// Batched frustum test over world-space AABBs stored as structure of arrays,
+// 8 (AVX) or 4 (SSE) boxes per step. Pure CPU, no GL state involved.
+class FrustumCuller
+{
+public:
+    void clear();
+    void reserve(size_t count);
+    // Returns the index of the box inside the batch
+    size_t add(const glm::vec3& min, const glm::vec3& max);
+    size_t size() const { return count; }
+
+    // visible[i] becomes 1 when box i intersects the frustum; returns the visible count
+    size_t cull(const Frustum& frustum, std::vector<uint8_t>& visible) const;
+    // Plain scalar version of cull, the reference for the SIMD path
+    size_t cullScalar(const Frustum& frustum, std::vector<uint8_t>& visible) const;
+
+private:
+    // centers and half extents, padded to a multiple of 8 with empty boxes
+    std::vector<float> cx, cy, cz, ex, ey, ez;
+    size_t count = 0;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <glad/glad.h>
+
+struct GLStateStats
+{
+    size_t issued = 0;         // state calls passed on to GL
+    size_t skipped = 0;        // no-op changes dropped
+    size_t queriesIssued = 0;  // glGet / glIsEnabled round trips
+    size_t queriesServed = 0;  // answered from the shadow copy
+};
+
+// Shadow copy of the GL state the engine touches: program, VAO, buffer and
+// framebuffer bindings, active unit and bound textures, depth/cull/blend state
+// and the viewport. Engine classes route these calls through here, so setting
+// a value that is already current costs nothing and queries need no glGet.
+//
+// The shadow is thread_local, as each thread drives its own context (see
+// AsyncModelLoader). Programs, buffers and textures are shared between those
+// contexts, so deleting one through here makes every thread re-learn its
+// program, buffer and texture bindings. Values start unknown and are learned
+// on first use. Code changing state behind the engine's back must call
+// invalidate afterwards.
+class GLState
+{
+public:
+    static void useProgram(GLuint program);
+    static void bindVertexArray(GLuint vertexArray);
+    // tracked for array, element array, copy read/write, uniform and pixel
+    // unpack buffers; other targets pass straight through
+    static void bindBuffer(GLenum target, GLuint buffer);
+    static void bindFramebuffer(GLuint framebuffer);
+
+    static void activeTexture(GLuint unit);
+    // binds to the active unit
+    static void bindTexture(GLenum target, GLuint texture);
+    // binds to unit, selecting it only if the binding actually changes
+    static void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    // GL_DEPTH_TEST, GL_CULL_FACE and GL_BLEND are cached, others pass through
+    static void setEnabled(GLenum capability, bool enabled);
+    static bool isEnabled(GLenum capability);
+    static void cullFace(GLenum mode);
+    static GLenum getCullFace();
+    static void depthFunc(GLenum func);
+    static GLenum getDepthFunc();
+    static void depthMask(bool write);
+    static bool getDepthMask();
+    static void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    static void getViewport(GLint out[4]);
+
+    // Deleting through these drops the bindings GL resets for deleted objects;
+    // other threads forget their shared bindings (names may be handed out again)
+    static void deleteProgram(GLuint program);
+    static void deleteVertexArray(GLuint vertexArray);
+    static void deleteBuffer(GLuint buffer);
+    static void deleteTexture(GLuint texture);
+    static void deleteFramebuffer(GLuint framebuffer);
+
+    // Forgets everything, the next call of each kind goes to GL again
+    static void invalidate();
+
+    // counters of the calling thread
+    static GLStateStats getStats();
+    static void resetStats();
+};
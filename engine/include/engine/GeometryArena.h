@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+#include "engine/VertexFormat.h"
+#include "engine/VAO.h"
+#include "engine/VBO.h"
+#include "engine/EBO.h"
+
+// Identifies a range suballocated from a GeometryArena
+using GeometryHandle = uint32_t;
+const GeometryHandle INVALID_GEOMETRY = ~0u;
+
+// Where one mesh currently lives inside the arena buffers (moves on compaction)
+struct GeometryBlock
+{
+    size_t vertexOffset = 0; // bytes, a multiple of the vertex stride
+    size_t vertexBytes = 0;
+    size_t indexOffset = 0;  // bytes, 4-byte aligned
+    size_t indexBytes = 0;
+    bool live = false;
+
+    // passed to glDrawElementsBaseVertex, indices stay relative to the mesh
+    GLint getBaseVertex(GLsizei stride) const { return static_cast<GLint>(vertexOffset / stride); }
+};
+
+struct GeometryArenaStats
+{
+    size_t vertexCapacity = 0; // bytes
+    size_t vertexUsed = 0;
+    size_t indexCapacity = 0;
+    size_t indexUsed = 0;
+    size_t allocations = 0;    // live blocks
+    size_t growths = 0;
+    size_t compactions = 0;
+};
+
+// One large VBO/EBO pair per vertex format, with a single VAO, that meshes
+// suballocate from. Freed ranges go to a free-list and get merged, and the
+// arena compacts itself once holes take up too much of the used space.
+// All calls must happen on the thread owning the GL context.
+class GeometryArena
+{
+public:
+    explicit GeometryArena(const VertexFormat& format,
+        size_t initialVertexBytes = 8u << 20, size_t initialIndexBytes = 4u << 20);
+    ~GeometryArena();
+
+    // Prevent copying
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    // Engine-wide arena of a vertex format, created on first use
+    static GeometryArena& forFormat(const VertexFormat& format);
+    // Destroys all shared arenas, call before the GL context goes away
+    // (meshes still using them must be gone by then)
+    static void destroyAll();
+
+    // Copies vertexCount vertices (in this arena's format) and indexBytes of
+    // index data into the arena, growing the buffers when needed
+    GeometryHandle allocate(const void* vertexData, size_t vertexCount,
+        const void* indexData, size_t indexBytes);
+    void release(GeometryHandle handle);
+    // Moves live blocks together, removing every hole
+    void compact();
+
+    const GeometryBlock& getBlock(GeometryHandle handle) const { return blocks[handle]; }
+    const VertexFormat& getFormat() const { return format; }
+    GLsizei getStride() const { return stride; }
+    GLuint getVertexArrayID() const { return vao->ID; }
+    GeometryArenaStats getStats() const;
+
+    // Binds the shared VAO (GLState skips it when already bound)
+    void Bind();
+    // Unbinds whichever VAO is bound
+    static void Unbind();
+
+private:
+    struct Range {
+        size_t offset, size;
+    };
+    // suballocation bookkeeping of one GL buffer
+    struct Space {
+        size_t capacity = 0;
+        size_t top = 0; // end of the highest allocation
+        std::vector<Range> freeList; // sorted by offset
+        size_t freeBytes = 0;        // inside freeList
+    };
+
+    VertexFormat format;
+    GLsizei stride;
+    std::unique_ptr<VAO> vao;
+    std::unique_ptr<VBO> vbo;
+    std::unique_ptr<EBO> ebo;
+    Space vertexSpace, indexSpace;
+
+    std::vector<GeometryBlock> blocks;
+    std::vector<GeometryHandle> freeHandles;
+    size_t growths = 0;
+    size_t compactions = 0;
+
+    // offset of size bytes, or SIZE_MAX if the buffer must grow first
+    static size_t takeRange(Space& space, size_t size);
+    static void giveRange(Space& space, size_t offset, size_t size);
+    // replaces a buffer with a larger one holding the same contents
+    void growVertices(size_t minCapacity);
+    void growIndices(size_t minCapacity);
+    void setupVertexArray();
+};
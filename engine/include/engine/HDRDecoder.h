@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Texel layouts HDRDecoder converts scanlines to
+enum class HDRPixelFormat
+{
+    Half,     // 4 halves per pixel (alpha 1), uploaded as GL_RGB16F
+    RGB9E5    // GL_UNSIGNED_INT_5_9_9_9_REV, uploaded as GL_RGB9_E5 (lossless for RGBE in range)
+};
+
+struct HDRLoadOptions
+{
+    HDRPixelFormat format = HDRPixelFormat::Half;
+    int bandRows = 64;    // scanlines per pixel unpack buffer upload
+};
+
+// Timings and memory of one HDRDecoder::benchmark run
+struct HDRDecodeBenchmark
+{
+    int width = 0;
+    int height = 0;
+    double stbMs = 0.0;          // stbi_loadf plus a float to half pass
+    double halfMs = 0.0;         // streamed, converted band by band
+    double rgb9e5Ms = 0.0;
+    size_t stbPeakBytes = 0;     // float image plus its half copy
+    size_t streamPeakBytes = 0;  // one band of RGBE plus its converted copy
+    double maxRelativeError = 0.0; // streamed halves against stb's floats
+};
+
+// Streaming reader for Radiance .hdr files (RGBE, flat or RLE scanlines,
+// old style runs included). Only one scanline is decoded at a time, so
+// callers convert and upload in bands instead of holding the whole image
+// as floats like stbi_loadf does. Nothing in this class touches GL.
+class HDRDecoder
+{
+public:
+    HDRDecoder() = default;
+    ~HDRDecoder();
+
+    // Prevent copying (owns the file)
+    HDRDecoder(const HDRDecoder&) = delete;
+    HDRDecoder& operator=(const HDRDecoder&) = delete;
+
+    // Reads the header; false (with a message) for anything but "-Y h +X w" or "+Y h +X w" RGBE
+    bool open(const std::string& path);
+    void close();
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    // true when the file stores the bottom row first ("+Y")
+    bool isBottomUp() const { return bottomUp; }
+    // scanlines read so far
+    int getRow() const { return row; }
+
+    // Next scanline in file order, width * 4 RGBE bytes
+    bool readScanline(uint8_t* rgbe);
+
+    // count RGBE pixels to 4 halves each (SSE2 when available), values clamped to 65504
+    static void toHalf(const uint8_t* rgbe, uint16_t* rgba, size_t count);
+    // count RGBE pixels to packed RGB9_E5 (a shift of the shared exponent)
+    static void toRGB9E5(const uint8_t* rgbe, uint32_t* out, size_t count);
+    // count RGBE pixels to 3 floats each, like stbi_loadf
+    static void toFloat(const uint8_t* rgbe, float* rgb, size_t count);
+
+    // Decodes the file with stb_image and streamed in both formats
+    static HDRDecodeBenchmark benchmark(const std::string& path, int bandRows = 64);
+
+private:
+    std::FILE* file = nullptr;
+    std::vector<uint8_t> buffer;
+    size_t position = 0;
+    size_t available = 0;
+    int width = 0;
+    int height = 0;
+    bool bottomUp = false;
+    int row = 0;
+
+    bool refill();
+    int nextByte() {
+        if (position == available && !refill()) return -1;
+        return buffer[position++];
+    }
+    bool readBytes(uint8_t* out, size_t count);
+    bool readLine(std::string& line);
+    bool readRunLength(uint8_t* rgbe);
+    bool readFlat(uint8_t* rgbe, const uint8_t first[4]);
+};
@@ -2,14 +2,19 @@
 
 #include <string>
 #include <glad/glad.h>
+#include "engine/HDRDecoder.h"
 
-// Loads an HDR equirectangular texture from disk
+// Loads an HDR equirectangular texture from disk. Scanlines are decoded by
+// HDRDecoder and uploaded in bands through a pixel unpack buffer, so only
+// one band is ever held on the CPU.
 class HDRTexture{
 public:
     GLuint ID;
     int width = 0;
     int height = 0;
+    // GL_RGB16F or GL_RGB9_E5
+    GLenum internalFormat = GL_RGB16F;
 
-    HDRTexture(const std::string& path);
+    HDRTexture(const std::string& path, const HDRLoadOptions& options = HDRLoadOptions());
     void Bind(GLuint unit = 0) const;
 };
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "engine/CubemapBaker.h"
+
+struct IBLBakeOptions
+{
+    CubemapBakeOptions environment;   // source cubemap, needs its mip chain
+    int specularSize = 128;           // face size of prefiltered level 0
+    int specularLevels = 6;           // roughness = level / (levels - 1)
+    int specularSamples = 256;        // GGX samples per texel and level
+    int lutSize = 128;
+    int lutSamples = 512;
+};
+
+// Everything image based lighting needs, computed once per environment.
+//  - sh: diffuse irradiance as 9 SH coefficients with the cosine lobe and
+//    the 1/pi of a Lambert BRDF folded in, so sum(sh[i] * Y_i(n)) * albedo
+//    is the diffuse term
+//  - specular: GGX prefiltered radiance, one roughness per mip level
+//  - brdfLut: split-sum scale and bias of F0, RG halves, x = NdotV and
+//    y = roughness, rows bottom-up
+struct IBLData
+{
+    glm::vec3 sh[9] = {};
+    CubemapImage specular;
+    int lutSize = 0;
+    std::vector<uint16_t> brdfLut;
+
+    bool isValid() const {
+        return specular.isValid() && lutSize > 0 && brdfLut.size() == size_t(lutSize) * lutSize * 2;
+    }
+};
+
+// CPU precompute for image based lighting on top of CubemapBaker, so it
+// runs (and can be checked) without a GL context. Every stage is spread over
+// the shared ThreadPool. Results are cached next to the source, keyed by a
+// hash of the .hdr contents rather than its timestamp.
+class IBLBaker
+{
+public:
+    // bump whenever the file layout or one of the integrals changes
+    static constexpr uint32_t VERSION = 2;
+
+    // Irradiance SH of the first level no larger than 64 (per texel solid angle)
+    static void projectSH(const CubemapImage& environment, glm::vec3 out[9]);
+    static glm::vec3 evaluateSH(const glm::vec3 sh[9], const glm::vec3& normal);
+
+    // Importance sampled GGX (N = V = R), sources mips picked from the sample pdf
+    static CubemapImage prefilterSpecular(const CubemapImage& environment, const IBLBakeOptions& options = IBLBakeOptions());
+    // Split-sum BRDF LUT, independent of the environment
+    static std::vector<uint16_t> integrateBRDF(int size, int samples);
+
+    static IBLData bake(const CubemapImage& environment, const IBLBakeOptions& options = IBLBakeOptions());
+
+    // FNV-1a of the file contents, false when it cannot be read
+    static bool hashFile(const std::string& path, uint64_t& hash);
+    static std::string cachePathFor(const std::string& hdrPath);
+    static bool write(const std::string& cachePath, uint64_t sourceHash,
+        const IBLBakeOptions& options, const IBLData& data);
+    // Fails when missing, for another source hash or options, or malformed
+    static bool read(const std::string& cachePath, uint64_t sourceHash,
+        const IBLBakeOptions& options, IBLData& out);
+    // Cache first; on a miss loads the environment (CubemapBaker cache) and bakes
+    static bool loadOrBake(const std::string& hdrPath, IBLData& out,
+        const IBLBakeOptions& options = IBLBakeOptions());
+};
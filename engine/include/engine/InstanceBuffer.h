@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "engine/VBO.h"
+
+// GPU stream of per-instance model matrices. Shaders read it as
+//     layout(location = 4) in mat4 aInstance;
+// (locations 4..7) and place vertices with aInstance * model * position.
+// Non-instanced draws leave those locations disabled so aInstance reads identity.
+class InstanceBuffer
+{
+public:
+    static const GLuint FIRST_ATTRIBUTE = 4;
+
+    explicit InstanceBuffer(size_t capacity = 0);
+
+    // Prevent copying
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+    // Replaces all transforms (orphaning the old storage), e.g. once per frame
+    void update(const glm::mat4* transforms, size_t count);
+    void update(const std::vector<glm::mat4>& transforms) { update(transforms.data(), transforms.size()); }
+
+    // For persistent buffers: changes the instance count, keeping existing
+    // transforms (new ones start as identity)
+    void resize(size_t count);
+    // Overwrites transforms [first, first + count) in place, e.g. only those that moved
+    void updateRange(size_t first, const glm::mat4* transforms, size_t count);
+    void set(size_t index, const glm::mat4& transform) { updateRange(index, &transform, 1); }
+
+    size_t getCount() const { return transformsCpu.size(); }
+    size_t getCapacity() const { return capacity; }
+    // CPU copy of the uploaded transforms
+    const std::vector<glm::mat4>& getTransforms() const { return transformsCpu; }
+
+    // Points locations 4..7 of the bound VAO at this buffer (divisor 1)
+    void link();
+    // Disables them again on the bound VAO and restores the identity default
+    static void unlink();
+    // Makes sure disabled instance attributes read identity (context state,
+    // tracked per thread like GLState)
+    static void setDefaultIdentity();
+
+private:
+    std::unique_ptr<VBO> vbo;
+    std::vector<glm::mat4> transformsCpu;
+    size_t capacity = 0;
+
+    // current attribute values are context state, and each thread drives its
+    // own context (see AsyncModelLoader)
+    static thread_local bool identitySet;
+};
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "engine/TextureBaker.h"
+
+class Shader;
+
+// Texture slots of a material, in the order material.glsl reads them
+enum class MaterialSlot
+{
+    Diffuse = 0,
+    Specular,
+    Normal,
+    Count
+};
+
+// Where one texture lives: a layer of a page, plus the uv rectangle inside
+// that layer (the full layer unless it was packed into the atlas)
+struct MaterialTextureRef
+{
+    int page = -1;
+    int layer = 0;
+    glm::vec2 scale = glm::vec2(1.0f);
+    glm::vec2 offset = glm::vec2(0.0f);
+
+    bool valid() const { return page >= 0; }
+};
+
+// One entry of the material table. Slots without a texture read the
+// fallback the shader passes to sampleMaterial.
+struct MaterialDesc
+{
+    glm::vec4 baseColor = glm::vec4(1.0f);
+    glm::vec4 params = glm::vec4(0.0f);   // free for the shader (e.g. shininess)
+    MaterialTextureRef textures[size_t(MaterialSlot::Count)];
+
+    MaterialTextureRef& texture(MaterialSlot slot) { return textures[size_t(slot)]; }
+};
+
+struct MaterialLibraryOptions
+{
+    int layersPerPage = 32;     // layers of one page at most
+    int atlasSize = 1024;       // square atlas layers, 0 keeps every texture in a page of its size
+    int atlasMaxTexture = 256;  // textures up to this size (both sides) go to the atlas
+    int atlasPadding = 8;       // replicated border, also bounds the atlas mip levels
+    GLuint firstUnit = 8;       // pages take MAX_PAGES units from here, the table the next one
+};
+
+struct MaterialStats
+{
+    size_t materials = 0;
+    size_t textures = 0;        // distinct textures added
+    size_t pages = 0;           // atlas included
+    size_t layers = 0;
+    size_t atlasTextures = 0;
+    size_t gpuBytes = 0;        // pages and table
+    size_t binds = 0;           // bind() calls
+};
+
+// Texture arrays plus a material table, so meshes with different materials
+// share one shader and one set of texture bindings and can be drawn back to
+// back (or in one instanced call) without rebinding anything.
+//  - Textures of the same size, format and mip count share a GL_TEXTURE_2D_ARRAY
+//    page, one texture per layer. Small ones are shelf-packed into an RGBA8 atlas page.
+//  - Materials are 8 RGBA32F texels of a texture buffer: base color, params and
+//    (page, layer, atlas flag) plus the uv rectangle of each slot. GL 3.3 only
+//    guarantees 65536 texels, so 8192 materials.
+//  - The vertex shader reads the material index from attribute 8: a constant per
+//    draw (Mesh::materialIndex) or a per instance stream (Mesh::setInstanceMaterials).
+// GLSL 3.30 only indexes sampler arrays with constants, so pages are MAX_PAGES
+// named samplers and material.glsl branches between them. Pages are built on the
+// CPU and uploaded by the first bind; textures added later open new pages.
+class MaterialLibrary
+{
+public:
+    static constexpr int MAX_PAGES = 4;
+    static constexpr GLuint MATERIAL_ATTRIBUTE = 8;
+    static constexpr int TEXELS_PER_MATERIAL = 2 + 2 * int(MaterialSlot::Count);
+
+    explicit MaterialLibrary(const MaterialLibraryOptions& options = MaterialLibraryOptions());
+    ~MaterialLibrary();
+
+    // Prevent copying (avoid double-delete)
+    MaterialLibrary(const MaterialLibrary&) = delete;
+    MaterialLibrary& operator=(const MaterialLibrary&) = delete;
+
+    // Adds the levels as they are (a block format needs a page of its own format);
+    // invalid when every page is taken
+    MaterialTextureRef addTexture(const BakedTexture& texture, bool allowAtlas = true);
+    // pixels: 1 to 4 channels, rows bottom-up like Texture; mips follow TextureBakeOptions::forType
+    MaterialTextureRef addTexture(const uint8_t* pixels, int width, int height, int channels,
+        const char* texType, bool allowAtlas = true);
+    // Loaded once per path: baked through TextureBaker when it is enabled (or for .dds), decoded otherwise
+    MaterialTextureRef addTexture(const std::string& path, const char* texType);
+
+    // Index for Mesh::materialIndex and the instance streams
+    int addMaterial(const MaterialDesc& material);
+    void updateMaterial(int index, const MaterialDesc& material);
+    const MaterialDesc& getMaterial(int index) const { return materials[size_t(index)]; }
+    size_t getMaterialCount() const { return materials.size(); }
+
+    // Uploads what changed, binds every page and the table and sets the
+    // material.glsl samplers on an active shader. Once per shader per frame.
+    void bind(const Shader& shader);
+
+    // Constant material index of the next non-instanced draws (context state, cached)
+    static void setDrawMaterial(int index);
+    // Feeds attribute 8 of the bound VAO from a buffer of GLint, one per instance
+    static void linkInstanceMaterials(GLuint buffer);
+    // Disables it again; the constant value has to be set anew afterwards
+    static void unlinkInstanceMaterials();
+
+    MaterialStats getStats() const;
+
+private:
+    struct Page
+    {
+        TextureFormat format = TextureFormat::RGBA8;
+        int width = 0, height = 0, levelCount = 1;
+        bool atlas = false;
+        // levels[layer][level], released once uploaded
+        std::vector<std::vector<std::vector<uint8_t>>> layers;
+        // shelf packing of the last atlas layer
+        int shelfX = 0, shelfY = 0, shelfHeight = 0;
+        GLuint ID = 0;
+        size_t gpuBytes = 0;
+        bool uploaded() const { return ID != 0; }
+    };
+
+    MaterialLibraryOptions options;
+    std::vector<Page> pages;
+    std::vector<MaterialDesc> materials;
+    std::unordered_map<std::string, MaterialTextureRef> pathCache;
+    GLuint tableBuffer = 0;
+    GLuint tableTexture = 0;
+    size_t tableCapacity = 0;
+    bool tableDirty = false;
+    size_t textureCount = 0;
+    size_t atlasTextureCount = 0;
+    size_t bindCount = 0;
+
+    // constant attribute value, context state: one per thread like GLState
+    static thread_local int currentDrawMaterial;
+
+    // page of this size and format with a free layer, -1 when all MAX_PAGES are taken
+    int findPage(TextureFormat format, int width, int height, int levelCount);
+    MaterialTextureRef addToAtlas(const uint8_t* rgba, int width, int height);
+    void uploadPage(Page& page);
+    void uploadTable();
+};
@@ -25,4 +25,8 @@ public:
 
     // Smooth time remapping (smoothstep)
     static float easeInOut(float t);
+
+    // Axis-aligned bounds of an AABB after an affine transform
+    static void transformAABB(const glm::vec3& min, const glm::vec3& max, const glm::mat4& m,
+                              glm::vec3& outMin, glm::vec3& outMax);
 };
\ No newline at end of file
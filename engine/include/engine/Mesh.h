@@ -8,6 +8,10 @@
 #include "engine/VAO.h"
 #include "engine/EBO.h"
 #include "engine/Texture.h"
+#include "engine/VertexFormat.h"
+#include "engine/MeshSimplifier.h"
+#include "engine/GeometryArena.h"
+#include "engine/InstanceBuffer.h"
 class Shader;
 
 class Mesh
@@ -19,18 +23,65 @@ public:
 	// Store model matrix for simple transformations
 	glm::mat4 modelMatrix = glm::mat4(1.0f);
 	GLenum drawMode = GL_TRIANGLES; // default, but can be changed per mesh
+	// Number of indices submitted by Draw
+	GLsizei indexCount = 0;
+	// GL_UNSIGNED_SHORT when the mesh has fewer than 65536 vertices
+	GLenum indexType = GL_UNSIGNED_INT;
+	// Model space bounds of this mesh
+	glm::vec3 aabbMin = glm::vec3(0.0f);
+	glm::vec3 aabbMax = glm::vec3(0.0f);
+	// Model space bounding sphere, centered on the AABB
+	glm::vec3 sphereCenter = glm::vec3(0.0f);
+	float sphereRadius = 0.0f;
+	// GPU vertex layout of vbo
+	VertexFormat format;
+	// Maps quantized positions back to model space (identity otherwise),
+	// applied by Model::Draw in front of the mesh's model matrix
+	glm::mat4 dequantizeMatrix = glm::mat4(1.0f);
+	// Size of the uploaded vertex and index data
+	size_t vertexBytes = 0;
+	size_t indexBytes = 0;
+	// Index ranges of each LOD inside the EBO, LOD 0 is the full mesh
+	std::vector<MeshLod> lods;
+	// LOD submitted by Draw, chosen by Model::Draw(shader, camera)
+	size_t currentLod = 0;
+	// Entry of a MaterialLibrary table, -1 for the textures list. Material
+	// meshes bind nothing themselves (the library is bound once for all of them)
+	// and pass the index to the shader as a vertex attribute.
+	int materialIndex = -1;
 
 	// Initializes the mesh
 	Mesh(const std::vector <Vertex>& vertices,
 		 const std::vector <GLuint>& indices,
 		 const std::vector<std::shared_ptr<Texture>>& textures);
+	// Initializes the mesh straight from memory, without keeping CPU copies.
+	// VAOs are not shared between GL contexts, so a mesh uploaded on a loader
+	// context defers its VAO until the first Draw on the render context.
+	// shortIndices stores the indices as 16-bit when every vertex fits.
+	Mesh(const Vertex* vertices, size_t vertexCount,
+		 const GLuint* indices, size_t indexCount,
+		 const std::vector<std::shared_ptr<Texture>>& textures,
+		 bool deferVertexArray = false, bool shortIndices = false);
+	// Initializes the mesh from vertices already encoded in vertexFormat
+	Mesh(const void* vertexData, size_t vertexCount, const VertexFormat& vertexFormat,
+		 const GLuint* indices, size_t indexCount,
+		 const std::vector<std::shared_ptr<Texture>>& textures,
+		 bool deferVertexArray = false, bool shortIndices = false);
+	// Initializes the mesh inside a shared GeometryArena (in the arena's
+	// vertex format) instead of its own VAO/VBO/EBO
+	Mesh(GeometryArena& arena, const void* vertexData, size_t vertexCount,
+		 const GLuint* indices, size_t indexCount,
+		 const std::vector<std::shared_ptr<Texture>>& textures,
+		 bool shortIndices = false);
 
 	~Mesh() {
-		vao.Delete();
-		vbo.Delete();
-		ebo.Delete();
+		if (arena) arena->release(arenaHandle);
 	}
 
+	// Prevent copying
+	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
+
 	// simple helpers
 	void setModelMatrix(const glm::mat4& m);
 	const glm::mat4& getModelMatrix() const;
@@ -39,12 +90,62 @@ public:
 	void setRotation(float angle, const glm::vec3& axis);
 	void setScale(const glm::vec3& scale);
 
+	// Uses index ranges of the uploaded indices as LODs (lods[0] is the full mesh)
+	void setLods(const std::vector<MeshLod>& levels);
+	// Number of indices Draw submits at the current LOD
+	GLsizei getDrawIndexCount() const;
+
+	// Draws the mesh once per transform (e.g. every node referencing it);
+	// an empty list goes back to a single plain draw
+	void setInstances(const glm::mat4* transforms, size_t count);
+	void setInstances(const std::vector<glm::mat4>& transforms) { setInstances(transforms.data(), transforms.size()); }
+	// Matrix applied in front of every instance transform (re-uploads on change)
+	void setInstanceParent(const glm::mat4& parent);
+	// 1 unless instances are set
+	GLsizei getInstanceCount() const;
+	const std::vector<glm::mat4>& getInstanceTransforms() const { return instanceTransforms; }
+	// Material index per instance, overriding materialIndex for instanced draws
+	// covering no more instances than indices; an empty list removes them
+	void setInstanceMaterials(const GLint* indices, size_t count);
+	void setInstanceMaterials(const std::vector<GLint>& indices) { setInstanceMaterials(indices.data(), indices.size()); }
+
 	// Draws the mesh
 	void Draw(Shader& shader);
+	// The two halves of Draw, so a RenderQueue can skip rebinding shared textures:
+	// binds textures and sets their sampler uniforms
+	void bindTextures(Shader& shader);
+	// issues the draw call with whatever textures are bound
+	void DrawGeometry();
+	// VAO the draw binds (the arena's when suballocated), 0 while deferred
+	GLuint getVertexArrayID() const;
+	// Draws the mesh once per transform of instances in a single call
+	// (the caller sets the "model" uniform, see InstanceBuffer)
+	void DrawInstanced(Shader& shader, InstanceBuffer& instances);
+	// Same, uploading the transforms into a buffer owned by the mesh
+	void DrawInstanced(Shader& shader, const glm::mat4* transforms, size_t count);
 
 private:
-	// to be used by Draw
-	VAO vao;
-    VBO vbo;
-    EBO ebo;
+	// to be used by Draw, unused when the mesh lives in an arena
+	std::unique_ptr<VAO> vao;
+	std::unique_ptr<VBO> vbo;
+	std::unique_ptr<EBO> ebo;
+	GeometryArena* arena = nullptr;
+	GeometryHandle arenaHandle = INVALID_GEOMETRY;
+	// per-instance transforms, kept on the CPU for bounds and LOD selection
+	std::unique_ptr<InstanceBuffer> instanceBuffer;
+	std::vector<glm::mat4> instanceTransforms;
+	glm::mat4 instanceParent = glm::mat4(1.0f);
+	// upload target of DrawInstanced with a transform list
+	std::unique_ptr<InstanceBuffer> scratchInstances;
+	// per-instance material indices (see MaterialLibrary)
+	std::unique_ptr<VBO> instanceMaterials;
+	size_t instanceMaterialCount = 0;
+
+	// writes instanceParent * instanceTransforms into the instance buffer
+	void uploadInstances();
+	// issues the draw call, instanced when instances is set
+	void submit(InstanceBuffer* instances, GLsizei instanceCount);
+
+	// links the vertex layout of vbo into vao
+	void setupVertexArray();
 };
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "engine/VBO.h"
+#include "engine/MappedFile.h"
+#include "engine/MeshSimplifier.h"
+
+// Texture requested by a mesh, resolved into a Texture once GL is available
+struct MeshTextureRef
+{
+    const char* type = "diffuse"; // static string ("diffuse", "specular", "normal")
+    std::string key;              // material path, "*N" for embedded textures or a full path
+    bool fallback = false;        // key is a full path found in the fallback folder
+    GLuint slot = 0;
+};
+
+// CPU side result of importing one mesh, ready to upload
+struct MeshData
+{
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    glm::vec3 aabbMin = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 aabbMax = glm::vec3(-std::numeric_limits<float>::max());
+    std::vector<MeshTextureRef> textures;
+    // LOD index ranges inside indices, empty when only the full mesh exists
+    std::vector<MeshLod> lods;
+    // node transforms referencing this mesh (hierarchy-preserving imports)
+    std::vector<glm::mat4> instances;
+};
+
+// Non-owning view of a mesh stored inside a mapped cache file
+struct CachedMesh
+{
+    const Vertex* vertices = nullptr;
+    size_t vertexCount = 0;
+    const GLuint* indices = nullptr;
+    size_t indexCount = 0;
+    glm::vec3 aabbMin = glm::vec3(0.0f);
+    glm::vec3 aabbMax = glm::vec3(0.0f);
+    std::vector<MeshTextureRef> textures;
+    std::vector<MeshLod> lods;
+    std::vector<glm::mat4> instances;
+};
+
+// Compressed image bytes of an embedded ("*N") texture
+struct EmbeddedTexture
+{
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+};
+
+// Identifies the import that produced a cache file
+struct MeshCacheKey
+{
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    uint64_t settingsHash = 0; // source path + skipped mesh names
+    uint32_t importFlags = 0;
+};
+
+// Versioned binary cache of imported meshes, read back through a file mapping
+class MeshCache
+{
+public:
+    // bump whenever the file layout or the import pipeline output changes
+    static constexpr uint32_t VERSION = 3;
+
+    // Cache file stored next to the source asset, named after the key's
+    // import settings so differently loaded copies keep separate caches
+    static std::string cachePathFor(const std::string& sourcePath, const MeshCacheKey& key);
+    // Builds the key from the source file state, returns false if it cannot be read.
+    // pipelineFlags covers engine-side processing that changes the stored geometry.
+    static bool makeKey(const std::string& sourcePath, uint32_t importFlags,
+        const std::vector<std::string>& skipNames, MeshCacheKey& key,
+        uint32_t pipelineFlags = 0);
+    // Writes the meshes and embedded textures, replacing any previous cache file
+    static bool write(const std::string& cachePath, const MeshCacheKey& key,
+        const std::vector<MeshData>& meshes,
+        const std::vector<EmbeddedTexture>& embedded);
+
+    // Maps a cache file, fails if it is missing, stale or malformed (including
+    // indices past their mesh's vertex count)
+    bool open(const std::string& cachePath, const MeshCacheKey& key);
+    void close();
+
+    // Views stay valid until the cache is closed or destroyed
+    const std::vector<CachedMesh>& getMeshes() const { return meshes; }
+    const std::vector<EmbeddedTexture>& getEmbeddedTextures() const { return embedded; }
+
+private:
+    MappedFile file;
+    std::vector<CachedMesh> meshes;
+    std::vector<EmbeddedTexture> embedded;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <glad/glad.h>
+#include "engine/VBO.h"
+
+// Post-transform vertex cache behaviour of an index buffer
+struct VertexCacheStats
+{
+    size_t triangles = 0;
+    size_t transformed = 0; // cache misses
+    float acmr = 0.0f;      // average cache miss ratio: misses per triangle (0.5 .. 3)
+    float atvr = 0.0f;      // average transform to vertex ratio: misses per vertex (1 is ideal)
+};
+
+// CPU index/vertex reordering for triangle lists, meant to run at import time
+class MeshOptimizer
+{
+public:
+    // Simulates a FIFO post-transform cache of cacheSize entries
+    static VertexCacheStats analyzeVertexCache(const GLuint* indices, size_t indexCount,
+        size_t vertexCount, unsigned cacheSize = 16);
+
+    // Reorders triangles for vertex cache locality (Forsyth's linear-speed algorithm)
+    static void optimizeVertexCache(std::vector<GLuint>& indices, size_t vertexCount);
+    // Reorders clusters of the cache-optimized list so outward-facing ones draw
+    // first. threshold bounds the ACMR loss allowed when splitting clusters.
+    static void optimizeOverdraw(std::vector<GLuint>& indices,
+        const std::vector<Vertex>& vertices, float threshold = 1.05f);
+    // Reorders vertices by first use and remaps indices, unused vertices are dropped
+    static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+
+    // All three passes in the recommended order
+    static void optimize(std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+
+    // Whether 16-bit indices can address every vertex (0xFFFF is left free
+    // so it never collides with a primitive restart index)
+    static bool fitsShortIndices(size_t vertexCount) { return vertexCount < 65536; }
+};
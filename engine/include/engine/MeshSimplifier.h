@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cfloat>
+#include <glad/glad.h>
+#include "engine/VBO.h"
+
+// One level of detail: a range of the mesh's index buffer
+struct MeshLod
+{
+    GLuint indexOffset = 0; // in indices, not bytes
+    GLuint indexCount = 0;
+    float error = 0.0f;     // geometric deviation from LOD 0 in model units
+};
+
+// Quadric error metric edge-collapse simplifier. Vertices are never moved or
+// created, simplified meshes only reference fewer of them, so every LOD of a
+// mesh shares one vertex buffer.
+class MeshSimplifier
+{
+public:
+    static constexpr size_t MAX_LODS = 8;
+
+    // Collapses edges until at most targetIndexCount indices remain or the next
+    // collapse would exceed maxError. Open borders stay locked, attribute seams
+    // only collapse along themselves. resultError receives the largest error.
+    static std::vector<GLuint> simplify(const std::vector<Vertex>& vertices,
+        const std::vector<GLuint>& indices, size_t targetIndexCount,
+        float maxError = FLT_MAX, float* resultError = nullptr);
+
+    // Appends coarser levels to indices, each keeping about `reduction` of the
+    // previous level's triangles. lods receives the full mesh as LOD 0 first.
+    // With optimizeLevels each new level is reordered for the vertex cache.
+    static void buildLodChain(const std::vector<Vertex>& vertices, std::vector<GLuint>& indices,
+        std::vector<MeshLod>& lods, size_t maxLevels = 4, float reduction = 0.5f,
+        bool optimizeLevels = false);
+};
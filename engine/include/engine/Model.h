@@ -10,8 +10,61 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp> 
 #include "engine/Mesh.h"
+#include "engine/MeshCache.h"
 #include "engine/MathUtils.h"
+#include "engine/FrustumCuller.h"
+#include "engine/SceneBVH.h"
+#include "engine/RenderQueue.h"
 class Shader;
+class Camera;
+class OcclusionCuller;
+
+// Loading behaviour of a Model
+struct ModelOptions
+{
+    // Reuse/write a binary mesh cache next to the asset to skip Assimp on warm loads
+    bool useMeshCache = true;
+    // Convert meshes on the shared ThreadPool, GL uploads stay on the calling thread
+    bool parallelImport = true;
+    // Leave VAO creation to the first Draw (set when uploading on a shared context)
+    bool deferVertexArrays = false;
+    // Keep the node hierarchy instead of baking node transforms into vertices:
+    // each aiMesh is stored once and drawn instanced for every node using it.
+    // Shaders must read the instance matrix (see InstanceBuffer).
+    bool preserveHierarchy = false;
+    // Suballocate meshes from the shared GeometryArena of their vertex format
+    // (one VAO for all of them). Ignored with deferVertexArrays, as arenas
+    // live on the render context only.
+    bool useGeometryArena = false;
+    // GPU vertex layout, e.g. VertexFormat::compact() to halve VBO size
+    VertexFormat vertexFormat = VertexFormat::standard();
+    // Reorder triangles and vertices for the post-transform cache, overdraw
+    // and fetch locality at import (stored optimized in the mesh cache), and
+    // upload 16-bit indices for meshes with at most 65535 vertices
+    bool optimizeIndices = false;
+    // Build a QEM-simplified LOD chain per mesh at import (stored in the mesh cache)
+    bool generateLods = false;
+    // Levels including the full mesh, each keeping lodReduction of the previous triangles
+    size_t lodLevels = 4;
+    float lodReduction = 0.5f;
+    // Keep a coarse CPU copy of the geometry for OcclusionCuller::addOccluder
+    // (the coarsest LOD, or a simplified mesh of at most occluderTriangles)
+    bool occluder = false;
+    size_t occluderTriangles = 512;
+};
+
+// LOD selection results, accumulated by every Model::Draw until reset
+struct LodStats
+{
+    size_t meshesDrawn = 0;
+    size_t trianglesDrawn = 0; // at the selected LODs
+    size_t trianglesFull = 0;  // had every mesh been drawn at LOD 0
+    size_t lodSwitches = 0;
+    size_t instancesDrawn = 0;
+    size_t meshesCulled = 0;   // outside the camera frustum
+    size_t meshesOccluded = 0; // hidden behind occluders
+    size_t meshesPerLod[MeshSimplifier::MAX_LODS] = {};
+};
 
 class Model
 {
@@ -19,6 +72,13 @@ public:
     // constructors
     explicit Model(const std::string& path);
     Model(const std::string& path, const std::vector<std::string>& skipNames);
+    Model(const std::string& path, const ModelOptions& options,
+          const std::vector<std::string>& skipNames = {});
+    // leaves the SceneBVH it was inserted into
+    ~Model();
+
+    // Assimp post-processing applied on import (part of the mesh cache key)
+    static unsigned int importFlags(bool preserveHierarchy = false);
 
     // Prevent copying
     Model(const Model&) = delete;
@@ -46,9 +106,46 @@ public:
     glm::vec3 getAABBMax() const { return aabbMax; }
     glm::vec3 getAABBCenter() const { return (aabbMin + aabbMax) * 0.5f; }
     glm::vec3 getAABBSize() const { return (aabbMax - aabbMin); }
+    // the same box transformed by getModelMatrix (world space)
+    void getWorldAABB(glm::vec3& outMin, glm::vec3& outMax) const;
 
-    // draw the model's meshes
+    // draw the model's meshes at their current LOD
     void Draw(Shader& shader);
+    // skips meshes outside the camera frustum (and hidden behind the
+    // occluders rasterized into occlusion), picks each remaining mesh's LOD
+    // from its projected error on screen, then draws
+    void Draw(Shader& shader, const Camera& camera, const OcclusionCuller* occlusion = nullptr);
+    // Same culling and LOD selection, but queues one packet per visible mesh
+    // instead of drawing (depth is the camera distance to the mesh bounds)
+    void Submit(RenderQueue& queue, Shader& shader, const Camera& camera,
+        const OcclusionCuller* occlusion = nullptr, RenderPass pass = RenderPass::Opaque);
+
+    // Draws one copy of the model per transform, replacing the model's own
+    // TRS, with a single instanced draw per mesh (at the meshes' current LOD)
+    void DrawInstanced(Shader& shader, const glm::mat4* transforms, size_t count);
+    void DrawInstanced(Shader& shader, const std::vector<glm::mat4>& transforms) {
+        DrawInstanced(shader, transforms.data(), transforms.size());
+    }
+    // Same with a persistent buffer the caller updates incrementally
+    void DrawInstanced(Shader& shader, InstanceBuffer& instances);
+
+    // LOD switches once its geometric error covers pixelError pixels; hysteresis
+    // widens that band both ways so meshes do not flicker between levels
+    void setLodThreshold(float pixelError, float hysteresis = 0.25f);
+    // Frustum culling in Draw(shader, camera), on by default
+    void setFrustumCulling(bool enabled) { frustumCulling = enabled; }
+
+    // per-frame statistics, call resetLodStats once per frame
+    static LodStats getLodStats();
+    static void resetLodStats();
+
+    // true once geometry was imported or read from the mesh cache
+    bool isLoaded() const { return loaded; }
+    // GPU memory used by vertex and index buffers
+    size_t getGeometryBytes() const;
+    // model space occluder triangles, empty unless loaded with ModelOptions::occluder
+    const std::vector<glm::vec3>& getOccluderPositions() const { return occluderPositions; }
+    const std::vector<GLuint>& getOccluderIndices() const { return occluderIndices; }
 
 private:
     // local transform
@@ -56,12 +153,35 @@ private:
     glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);  // Identity quaternion
     glm::vec3 scale = glm::vec3(1.0f);
 
+    // scene index tracking this model, updated by the TRS setters
+    friend class SceneBVH;
+    SceneBVH* sceneIndex = nullptr;
+    SceneProxy sceneProxy = INVALID_PROXY;
+    void transformChanged();
+
     // model space bounds
     glm::vec3 aabbMin = glm::vec3(std::numeric_limits<float>::max());
     glm::vec3 aabbMax = glm::vec3(-std::numeric_limits<float>::max());
 
 	// the shared asset data
-    std::unordered_map<std::string, std::shared_ptr<Texture>> textureCache;
+    ModelOptions options;
+    bool loaded = false;
+    float lodPixelError = 1.0f;
+    float lodHysteresis = 0.25f;
+    bool frustumCulling = true;
+    // world space mesh bounds of the current Draw, and their visibility
+    FrustumCuller culler;
+    std::vector<uint8_t> meshVisible;
+    std::vector<glm::vec3> meshWorldMin, meshWorldMax;
+    std::vector<size_t> visibleMeshes;
+    std::vector<glm::vec3> occluderPositions;
+    std::vector<GLuint> occluderIndices;
+    // upload targets of DrawInstanced: the transform list, and copies x node
+    // instances for meshes that are instanced inside the model already
+    std::unique_ptr<InstanceBuffer> instanceScratch;
+    std::unique_ptr<InstanceBuffer> nestedScratch;
+    std::vector<glm::mat4> nestedTransforms;
+    std::vector<EmbeddedTexture> embeddedTextures; // valid only while loading
 	std::string modelPath;
     std::string directory;
     std::string texturesDir;
@@ -73,13 +193,47 @@ private:
 
 	// procedure to load model
     void loadModel(const std::string& path);
-    void processNode(aiNode* node, const aiScene* scene);
-    std::shared_ptr<Mesh> processMesh(aiMesh* mesh, const aiScene* scene);
-    
-	// Texture loading
-    std::shared_ptr<Texture> LoadTexture(const aiString& path,
-        const char* typeName, const aiScene* scene,GLuint slot);
-
-    void AttachTextures(std::vector<std::shared_ptr<Texture>>& textures,
-        aiMaterial* material, const aiScene* scene);
+    // gathers the meshes to import in traversal order
+    void processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& out);
+    // same, keeping node transforms: each aiMesh once, plus every transform using it
+    void processNodeInstanced(aiNode* node, const aiScene* scene, const glm::mat4& parent,
+        std::unordered_map<aiMesh*, size_t>& seen, std::vector<aiMesh*>& out,
+        std::vector<std::vector<glm::mat4>>& instances);
+    // CPU only conversion, safe to run on worker threads
+    MeshData processMesh(aiMesh* mesh);
+    // GPU upload of imported (or cached) geometry
+    void createMesh(const Vertex* vertices, size_t vertexCount,
+        const GLuint* indices, size_t indexCount,
+        const glm::vec3& meshMin, const glm::vec3& meshMax,
+        const std::vector<MeshLod>& lods,
+        const std::vector<glm::mat4>& instances,
+        const std::vector<std::shared_ptr<Texture>>& textures);
+
+    // appends a coarse copy of one mesh (placed by its node transforms) to the occluder geometry
+    void addOccluderGeometry(const Vertex* vertices, size_t vertexCount,
+        const GLuint* indices, size_t indexCount, const std::vector<MeshLod>& lods,
+        const std::vector<glm::mat4>& instances);
+    // world space AABB of a mesh, covering all of its node instances
+    void meshWorldBounds(const Mesh& mesh, const glm::mat4& meshMatrix,
+        glm::vec3& outMin, glm::vec3& outMax) const;
+    // LOD choice for one mesh, meshMatrix maps it to world space
+    void selectLod(Mesh& mesh, const glm::mat4& meshMatrix,
+        const glm::vec3& cameraPos, float pixelsPerUnit);
+    // culls and selects LODs for a camera, leaving the survivors in visibleMeshes
+    void prepareVisible(const Camera& camera, const OcclusionCuller* occlusion);
+    // "model" uniform of a mesh, updating node instances to follow meshMatrix
+    glm::mat4 meshUniform(Mesh& mesh, const glm::mat4& meshMatrix);
+    void countDrawn(const Mesh& mesh);
+    // shared by both Draw overloads
+    void drawMesh(Shader& shader, Mesh& mesh, const glm::mat4& meshMatrix);
+
+	// Texture loading, shared engine-wide through the TextureRegistry.
+    // All meshes are resolved in one batch so decoding runs in parallel.
+    std::vector<std::vector<std::shared_ptr<Texture>>> LoadTextures(
+        const std::vector<const std::vector<MeshTextureRef>*>& perMesh);
+
+    // Material texture references of one mesh (calling thread only, it logs)
+    void AttachTextures(std::vector<MeshTextureRef>& textures, aiMaterial* material);
+    // Textures guessed from texturesDir for meshes whose material has none
+    std::vector<MeshTextureRef> FindFallbackTextures() const;
 };
\ No newline at end of file
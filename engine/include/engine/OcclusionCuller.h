@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+class Model;
+
+struct OcclusionStats
+{
+    size_t occluderTriangles = 0;   // submitted this frame
+    size_t rasterizedTriangles = 0; // left after near plane and screen rejection
+    size_t tested = 0;              // isVisible calls
+    size_t occluded = 0;
+    double rasterMs = 0.0;          // transform, rasterization and pyramid build
+};
+
+// CPU occlusion culling: occluder triangles are rasterized into a small depth
+// buffer (horizontal bands on the shared ThreadPool, 4 pixels per SSE step),
+// reduced into a max-depth pyramid, and occludee boxes are tested against the
+// pyramid level their screen rectangle covers in a few texels. No GL involved.
+//
+// Per frame: beginFrame, addOccluder..., rasterize, then isVisible queries.
+class OcclusionCuller
+{
+public:
+    explicit OcclusionCuller(int width = 256, int height = 128);
+
+    // Clears the depth buffer and occluder list for this camera matrix
+    void beginFrame(const glm::mat4& viewProjection);
+    // Queues triangles (model space positions) drawn with transform, the
+    // arrays must stay alive until rasterize
+    void addOccluder(const glm::vec3* positions, const uint32_t* indices, size_t indexCount,
+        const glm::mat4& transform);
+    // Queues the occluder geometry of a Model loaded with ModelOptions::occluder
+    void addOccluder(const Model& model);
+    void rasterize();
+
+    // false when the world space box is hidden behind the rasterized occluders.
+    // Boxes crossing the near plane always count as visible. Call from one
+    // thread at a time (statistics are not atomic).
+    bool isVisible(const glm::vec3& worldMin, const glm::vec3& worldMax) const;
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    // Normalized [0, 1] depth per pixel, 1 where nothing was drawn (row 0 at the bottom)
+    const std::vector<float>& getDepth() const { return depth; }
+    OcclusionStats getStats() const { return stats; }
+
+    // Small scenes with known answers (CPU only): a box behind a wall is hidden,
+    // a box beside an occluder that crosses the near plane stays visible
+    static bool selfTest();
+
+private:
+    struct Occluder {
+        const glm::vec3* positions;
+        const uint32_t* indices;
+        size_t indexCount;
+        glm::mat4 transform;
+        size_t firstTriangle; // into triangles
+    };
+    // screen space triangle as three edge functions a*x + b*y + c (all >= 0
+    // inside) and a depth plane, over an inclusive pixel rectangle
+    struct Triangle {
+        float ea[3], eb[3], ec[3];
+        float za, zb, zc;
+        int minX, maxX, minY, maxY;
+        bool valid;
+    };
+
+    int width, height; // width is a multiple of 4
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    std::vector<float> depth;
+    // max-depth pyramid, level 0 is a copy of depth, each next level halves it
+    std::vector<std::vector<float>> pyramid;
+    std::vector<glm::ivec2> pyramidSize;
+    std::vector<Occluder> occluders;
+    std::vector<Triangle> triangles;
+    mutable OcclusionStats stats;
+
+    bool setupTriangle(const glm::vec4 clip[3], Triangle& out) const;
+    void rasterizeBand(int rowBegin, int rowEnd);
+    void buildPyramid();
+};
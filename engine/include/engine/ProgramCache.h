@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+
+struct ProgramCacheStats
+{
+    size_t hits = 0;         // programs created from a cached binary
+    size_t misses = 0;       // no (or a stale) cache file
+    size_t rejected = 0;     // binary refused by the driver, rebuilt from source
+    size_t stored = 0;
+    double binaryMs = 0.0;   // spent creating programs from binaries
+    double compileMs = 0.0;  // spent compiling and linking from source
+};
+
+// On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary,
+// core in GL 4.1 or through ARB_get_program_binary; glad's 3.3 loader lacks them,
+// so they are fetched with glfwGetProcAddress). The key hashes the sources
+// together with the GL vendor, renderer and version strings, so a driver
+// update simply misses. Binaries the driver still refuses fall back to source.
+class ProgramCache
+{
+public:
+    // bump whenever the file layout changes
+    static constexpr uint32_t VERSION = 1;
+
+    // Needs a current context; false when the driver exposes no binary formats
+    static bool isSupported();
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+    // Folder holding the cache files (default "shader_cache/")
+    static void setDirectory(const std::string& directory);
+    static const std::string& getDirectory();
+
+    static uint64_t keyFor(const std::string& vertexSource, const std::string& fragmentSource);
+    // New program from the cached binary of key, or 0 on a miss or rejection
+    static GLuint load(uint64_t key);
+    // Call before glLinkProgram on programs that will be stored
+    static void prepare(GLuint program);
+    static bool store(uint64_t key, GLuint program);
+
+    // Lets drivers with KHR/ARB_parallel_shader_compile use all their threads
+    static void enableParallelCompile();
+
+    static ProgramCacheStats getStats();
+    static void addCompileTime(double ms);
+    static void resetStats();
+};
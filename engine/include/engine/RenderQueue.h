@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+class Mesh;
+class Shader;
+
+// Passes execute in this order
+enum class RenderPass : uint8_t
+{
+    Opaque = 0,      // front to back inside a state group, for early-Z
+    Transparent = 1, // back to front before any state grouping
+    Overlay = 2      // submission order within equal state
+};
+
+// One queued mesh draw
+struct DrawPacket
+{
+    Mesh* mesh = nullptr;
+    Shader* shader = nullptr;
+    glm::mat4 transform = glm::mat4(1.0f); // set as the "model" uniform
+    float depth = 0.0f;                    // distance to the camera
+    RenderPass pass = RenderPass::Opaque;
+};
+
+// State changes of the executed order, next to what the submission order would have cost
+struct RenderQueueStats
+{
+    size_t packets = 0;
+    size_t drawCalls = 0;
+    size_t programChanges = 0;
+    size_t textureChanges = 0;
+    size_t vaoChanges = 0;
+    size_t programChangesUnsorted = 0;
+    size_t textureChangesUnsorted = 0;
+    size_t vaoChangesUnsorted = 0;
+    double sortMs = 0.0;
+};
+
+// Collects draw packets for a frame, orders them by a 64-bit key with an LSD
+// radix sort, then draws them binding programs and textures only on change.
+// Transforms of shaders declaring ObjectData go up in one batch per execute.
+//
+// Key layout, most significant first:
+//   opaque / overlay: pass:2 | program:10 | texture set:14 | vao:14 | depth:24
+//   transparent:      pass:2 | ~depth:24  | program:10 | texture set:14 | vao:14
+// Program, texture set and VAO ids are dense per frame, so the bit fields
+// only saturate past 1024 programs / 16384 sets; execute still compares the
+// real objects, so saturation only costs extra state changes.
+class RenderQueue
+{
+public:
+    // Empties the queue, call once per frame before submitting
+    void clear();
+    void submit(const DrawPacket& packet);
+    void submit(Mesh& mesh, Shader& shader, const glm::mat4& transform, float depth,
+        RenderPass pass = RenderPass::Opaque);
+
+    // Sorts the queued packets (execute sorts on its own when needed)
+    void sort();
+    // Draws every packet, or those of one pass (blend state between passes is the caller's)
+    void execute();
+    void execute(RenderPass pass);
+
+    size_t size() const { return packets.size(); }
+    RenderQueueStats getStats() const { return stats; }
+
+    static uint64_t makeKey(RenderPass pass, uint32_t program, uint32_t textureSet,
+        uint32_t vertexArray, float depth);
+
+private:
+    struct Queued {
+        DrawPacket packet;
+        uint64_t textureSet; // hash of the mesh's texture ids
+        GLuint vertexArray;
+    };
+
+    std::vector<Queued> packets;
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> order; // packet indices in key order
+    std::vector<uint64_t> keyScratch;
+    std::vector<uint32_t> orderScratch;
+    std::vector<uint8_t> objectScratch; // ObjectData blocks of one executed range
+    bool sorted = true;
+    RenderQueueStats stats;
+
+    // dense ids of the current frame
+    std::unordered_map<GLuint, uint32_t> programIds;
+    std::unordered_map<uint64_t, uint32_t> textureSetIds;
+    std::unordered_map<GLuint, uint32_t> vertexArrayIds;
+
+    void executeRange(size_t begin, size_t end);
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "engine/FrustumCuller.h"
+class Model;
+
+// Identifies a leaf of a SceneBVH, stable until the leaf is removed
+using SceneProxy = int32_t;
+const SceneProxy INVALID_PROXY = -1;
+
+struct SceneRayHit
+{
+    SceneProxy proxy = INVALID_PROXY;
+    Model* model = nullptr;
+    float distance = 0.0f; // along the ray to the entry of the leaf box
+};
+
+struct SceneBVHStats
+{
+    size_t leaves = 0;
+    size_t nodes = 0;
+    int height = 0;
+    size_t refits = 0;     // moves absorbed by the fat box or the parent box
+    size_t reinserts = 0;  // moves that had to restructure the tree
+};
+
+// Timings of one SceneBVH::benchmark run, in milliseconds per query
+struct SceneBVHBenchmark
+{
+    size_t objects = 0;
+    double buildMs = 0.0;
+    double updateMs = 0.0;        // moving 10% of the objects
+    double frustumMs = 0.0, frustumBruteMs = 0.0;
+    double sphereMs = 0.0, sphereBruteMs = 0.0;
+    double rayMs = 0.0, rayBruteMs = 0.0;
+    bool matchesBruteForce = false;
+};
+
+// Dynamic AABB tree over world-space bounds of Models (or any box).
+// Leaves store a box enlarged by a margin, so small moves do not touch the
+// tree; inserts pick the sibling with the least surface area growth and
+// keep the tree balanced with rotations on the way up.
+class SceneBVH
+{
+public:
+    explicit SceneBVH(float margin = 0.1f);
+    // Models still registered are detached, not destroyed
+    ~SceneBVH();
+
+    // Prevent copying
+    SceneBVH(const SceneBVH&) = delete;
+    SceneBVH& operator=(const SceneBVH&) = delete;
+
+    // Tracks a Model: its TRS setters keep the leaf up to date from then on
+    SceneProxy insert(Model& model);
+    // Raw box leaf, model may be null
+    SceneProxy insert(const glm::vec3& min, const glm::vec3& max, Model* model = nullptr);
+    void remove(SceneProxy proxy);
+    // New bounds of a leaf; returns true when the tree had to be restructured
+    // (false for stale or invalid proxies, which are ignored)
+    bool update(SceneProxy proxy, const glm::vec3& min, const glm::vec3& max);
+
+    // Leaves whose box intersects the frustum / sphere, appended to out
+    void queryFrustum(const Frustum& frustum, std::vector<SceneProxy>& out) const;
+    void querySphere(const glm::vec3& center, float radius, std::vector<SceneProxy>& out) const;
+    // Nearest leaf box hit by the ray within maxDistance (dir need not be normalized,
+    // distances are in units of dir)
+    bool raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDistance, SceneRayHit& hit) const;
+
+    Model* getModel(SceneProxy proxy) const { return nodes[proxy].model; }
+    // Fat box stored for the leaf
+    void getBounds(SceneProxy proxy, glm::vec3& outMin, glm::vec3& outMax) const;
+    size_t size() const { return leafCount; }
+    void clear();
+    SceneBVHStats getStats() const;
+
+    // Random boxes queried through the tree and by brute force (CPU only)
+    static SceneBVHBenchmark benchmark(size_t objectCount, unsigned seed = 1);
+
+private:
+    static constexpr int32_t NULL_NODE = -1;
+
+    struct Node {
+        glm::vec3 min, max;
+        int32_t parent = NULL_NODE; // next free node while unused
+        int32_t left = NULL_NODE;
+        int32_t right = NULL_NODE;
+        int32_t height = -1;        // 0 for leaves, -1 when free
+        Model* model = nullptr;
+        bool isLeaf() const { return left == NULL_NODE; }
+    };
+
+    std::vector<Node> nodes;
+    int32_t root = NULL_NODE;
+    int32_t freeList = NULL_NODE;
+    size_t leafCount = 0;
+    float margin;
+    size_t refits = 0;
+    size_t reinserts = 0;
+
+    int32_t allocateNode();
+    void freeNode(int32_t index);
+    void insertLeaf(int32_t leaf);
+    void removeLeaf(int32_t leaf);
+    // refits bounds and heights from index up to the root, rotating where unbalanced
+    void fixUpwards(int32_t index);
+    int32_t balance(int32_t index);
+};
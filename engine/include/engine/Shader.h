@@ -2,34 +2,70 @@
 
 #include <glad/glad.h>
 #include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
 #include <glm/glm.hpp>     // glm::mat4 support
-#include <unordered_map>   // cache
+#include "engine/UniformTable.h" // cache
 
 std::string get_file_contents(const std::string& filename);
 
+// GLSL of one program, already in memory
+struct ShaderSource {
+	std::string vertex;
+	std::string fragment;
+	std::string name; // shown in compile errors
+	// Reads both stages from disk, resolving #include and adding defines
+	// ("NAME" or "NAME value", see ShaderPreprocessor)
+	static ShaderSource fromFiles(const std::string& vertexFile, const std::string& fragmentFile,
+		const std::vector<std::string>& defines = {});
+};
+
 class Shader {
 public:
 	// Reference ID of the Shader Program
 	GLuint ID;
 	// Constructor that build the Shader Program from 2 different shaders
 	Shader(const std::string& vertexFile, const std::string& fragmentFile);
+	// Same from sources in memory. Both go through the program binary cache
+	// (see ProgramCache) and only compile when it misses.
+	explicit Shader(const ShaderSource& source);
+	// Submits every program before checking any of them, so drivers that
+	// compile in parallel overlap the work
+	static std::vector<std::unique_ptr<Shader>> compileBatch(const std::vector<ShaderSource>& sources);
 
 	// Activates the Shader Program
 	void Activate();
 	// Deletes the Shader Program
 	void Delete();
 
-	// Uniform helper methods
-	void setBool(const std::string& name, bool value) const;
-	void setInt(const std::string& name, int value) const;
-	void setFloat(const std::string& name, float value) const;
-	void setMat4(const std::string& name, const float* mat) const;
-	void setMat4(const std::string& name, const glm::mat4& m) const;
-	void setVec2(const std::string& name, const glm::vec2 v) const;
+	// Uniform helper methods (literal names are hashed at compile time)
+	void setBool(const UniformName& name, bool value) const;
+	void setInt(const UniformName& name, int value) const;
+	void setFloat(const UniformName& name, float value) const;
+	void setMat4(const UniformName& name, const float* mat) const;
+	void setMat4(const UniformName& name, const glm::mat4& m) const;
+	void setVec2(const UniformName& name, const glm::vec2 v) const;
 	//void setVec3(const std::string& name, float x, float y, float z) const;
-	void setVec3(const std::string& name, const glm::vec3& v) const;
+	void setVec3(const UniformName& name, const glm::vec3& v) const;
 	//void setVec4(const std::string& name, float x, float y, float z, float w) const;
-	void setVec4(const std::string& name, const glm::vec4& v) const;
+	void setVec4(const UniformName& name, const glm::vec4& v) const;
+
+	// Resolves a uniform once, for the hot paths setting it by handle
+	UniformHandle getHandle(const UniformName& name) const;
+	void setBool(UniformHandle handle, bool value) const;
+	void setInt(UniformHandle handle, int value) const;
+	void setFloat(UniformHandle handle, float value) const;
+	void setMat4(UniformHandle handle, const glm::mat4& m) const;
+	void setVec2(UniformHandle handle, const glm::vec2 v) const;
+	void setVec3(UniformHandle handle, const glm::vec3& v) const;
+	void setVec4(UniformHandle handle, const glm::vec4& v) const;
+
+	// Engine uniform blocks declared by the program (see UniformBuffer.h)
+	bool hasFrameBlock() const { return frameBlock; }
+	bool hasObjectBlock() const { return objectBlock; }
+	// Per-object transform: streamed as ObjectData when declared, else the "model" uniform
+	void setModelMatrix(const glm::mat4& m) const;
 
 	~Shader() {
 		if (ID != 0) Delete();
@@ -41,8 +77,23 @@ public:
 
 private:
 	// cache of uniform locations to reduce calls
-	mutable std::unordered_map<std::string, GLint> uniformCache;
-	GLint getUniformLocation(const std::string& name) const;
-	// error handler
-	void checkCompileErrors(GLuint shader, const std::string& type);
+	mutable UniformTable uniformCache;
+	GLint getUniformLocation(const UniformName& name) const;
+	bool frameBlock = false;
+	bool objectBlock = false;
+	// attaches FrameData / ObjectData to their fixed binding points
+	void bindUniformBlocks();
+	// Build in two steps: submit issues compile and link without waiting,
+	// finish queries the results and stores the binary
+	struct Deferred {};
+	Shader(const ShaderSource& source, Deferred);
+	void submit(const ShaderSource& source);
+	void finish();
+	GLuint pendingVertex = 0;
+	GLuint pendingFragment = 0;
+	uint64_t cacheKey = 0;
+	double submitMs = 0.0;
+	std::string name;
+	// error handler, true when compiled / linked
+	bool checkCompileErrors(GLuint shader, const std::string& type);
 };
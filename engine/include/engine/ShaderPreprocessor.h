@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// GLSL preprocessing done before the driver sees the source:
+//  - #include "file" is replaced by the file, searched next to the including
+//    file, then in the include directories (ENGINE_SHADER_DIR by default).
+//    Every file is pasted once per program, so headers need no guards and
+//    "#pragma once" lines are dropped.
+//  - defines ("NAME" or "NAME value") are inserted right after #version.
+// #line directives keep compiler errors pointing at the original lines; the
+// source string number indexes the files list of the result.
+class ShaderPreprocessor
+{
+public:
+    struct Result {
+        std::string source;
+        std::vector<std::string> files; // [0] is the root file
+    };
+
+    // Loads and processes a file, throws std::runtime_error when a file is missing
+    static Result processFile(const std::string& path, const std::vector<std::string>& defines = {});
+    // Processes source text; path only anchors relative includes
+    static Result process(const std::string& source, const std::string& path,
+        const std::vector<std::string>& defines = {});
+    // Inserts defines after the #version line of already processed source
+    static std::string injectDefines(const std::string& source, const std::vector<std::string>& defines);
+
+    static void addIncludeDirectory(const std::string& directory);
+    static const std::vector<std::string>& getIncludeDirectories();
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+#include "engine/Shader.h"
+#include "engine/ShaderPreprocessor.h"
+
+// Permutations of one vertex/fragment pair, keyed by a feature bitmask.
+// Bit i of a mask adds "#define features[i]" to both stages, so hot paths
+// use #ifdef instead of runtime branches and drop inputs they do not read.
+// Includes are resolved once; each permutation compiles the first time it is
+// requested (through the program binary cache) and is reused afterwards.
+class ShaderVariantCache
+{
+public:
+    static constexpr size_t MAX_FEATURES = 32;
+
+    // features are "NAME" or "NAME value", at most MAX_FEATURES
+    ShaderVariantCache(const std::string& vertexFile, const std::string& fragmentFile,
+        std::vector<std::string> features);
+
+    // Prevent copying (shaders are owned)
+    ShaderVariantCache(const ShaderVariantCache&) = delete;
+    ShaderVariantCache& operator=(const ShaderVariantCache&) = delete;
+
+    // Variant of mask, compiled on first use
+    Shader& get(uint32_t mask);
+    // Builds the masks not compiled yet in one batch, e.g. behind a loading screen
+    void precompile(const std::vector<uint32_t>& masks);
+    // Bit of a feature (by its NAME), 0 when unknown
+    uint32_t bit(const std::string& feature) const;
+
+    size_t size() const { return variants.size(); }
+    // Deletes all compiled variants (sources stay loaded)
+    void clear() { variants.clear(); }
+
+private:
+    std::string name;
+    ShaderPreprocessor::Result vertexBase, fragmentBase;
+    std::vector<std::string> features;
+    std::unordered_map<uint32_t, std::unique_ptr<Shader>> variants;
+
+    ShaderSource sourceFor(uint32_t mask) const;
+};
@@ -1,7 +1,13 @@
 #pragma once
 
 #include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include "engine/UniformTable.h"
 class Shader;
+struct DecodedImage;
+struct BakedTexture;
+enum class TextureFormat : uint32_t;
 
 class Texture
 {
@@ -9,9 +15,18 @@ public:
 	GLuint ID;
 	const char* type;
 	GLuint slot;
+	// Image size, 0 if loading failed
+	int width = 0;
+	int height = 0;
+	int channels = 0;
 	Texture(const char* image, const char* texType, GLuint slot, GLenum pixelType);
 	// for embedded textures:
 	Texture(const unsigned char* data, size_t size, const char* texType, GLuint slot, GLenum pixelType);
+	// for images decoded ahead of time, only uploads
+	Texture(const DecodedImage& image, const char* texType, GLuint slot, GLenum pixelType);
+	// for baked levels (see TextureBaker), block compressed when the driver
+	// has the format, decoded to RGBA8 on the CPU otherwise
+	Texture(const BakedTexture& baked, const char* texType, GLuint slot);
 
 	~Texture() {
 		if (ID != 0) Delete();
@@ -22,11 +37,26 @@ public:
 	Texture& operator=(const Texture&) = delete;
 
 	// Assigns a texture unit to a texture
-	void texUnit(Shader& shader, const char* uniform, GLuint unit);
+	void texUnit(Shader& shader, const UniformName& uniform, GLuint unit);
 	// Binds a texture
 	void Bind();
+	// Binds a texture to an explicit texture unit
+	void Bind(GLuint unit);
+	// Approximate GPU memory used, including the mip chain
+	size_t getByteSize() const;
+	// GL internal format of a block format, 0 when the driver cannot sample it.
+	// Unorm like the decoded path, so shaders see the same values either way
+	// (sRGB only steers the mip filtering).
+	static GLenum compressedFormat(TextureFormat format);
 	// Unbinds a texture
 	void Unbind();
 	// Deletes a texture
 	void Delete();
+
+private:
+	// bytes uploaded, all levels
+	size_t byteSize = 0;
+
+	void upload(const DecodedImage& image, GLenum pixelType);
+	void uploadBaked(const BakedTexture& baked);
 };
\ No newline at end of file
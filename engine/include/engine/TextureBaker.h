@@ -0,0 +1,108 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+// Block formats produced by TextureBaker (RGBA8 keeps the pixels as they are)
+enum class TextureFormat : uint32_t
+{
+    RGBA8 = 0,
+    BC1,    // RGB, 8 bytes per 4x4 block
+    BC3,    // RGBA, BC1 color plus a BC4 alpha block
+    BC5,    // RG, two BC4 blocks (tangent space normals, z rebuilt in the shader)
+    BC7,    // RGBA, mode 6 only (one subset, 7777 endpoints with p-bits)
+    Count
+};
+
+struct TextureBakeOptions
+{
+    TextureFormat format = TextureFormat::BC7;
+    bool srgb = true;        // color data: mips are filtered in linear light
+    bool normalMap = false;  // mips average the vectors and renormalize
+    bool mipmaps = true;     // full chain down to 1x1
+
+    // Defaults per Texture type: "diffuse" sRGB BC7, "normal" BC5, anything else linear BC7
+    static TextureBakeOptions forType(const char* texType);
+};
+
+// Upload-ready levels. Rows are bottom-up like every other Texture, blocks
+// cover 4x4 pixels and clamp at the edges of levels smaller than a block.
+struct BakedTexture
+{
+    TextureFormat format = TextureFormat::RGBA8;
+    bool srgb = false;
+    int width = 0;
+    int height = 0;
+    std::vector<std::vector<uint8_t>> levels;
+
+    int levelWidth(int level) const { return std::max(1, width >> level); }
+    int levelHeight(int level) const { return std::max(1, height >> level); }
+    bool isValid() const { return width > 0 && height > 0 && !levels.empty(); }
+    size_t getByteSize() const;
+};
+
+// Timings and quality of one TextureBaker::benchmark run, per format
+struct TextureBakeBenchmark
+{
+    int size = 0;
+    double mipMs = 0.0;
+    double encodeMs[size_t(TextureFormat::Count)] = {};
+    double psnr[size_t(TextureFormat::Count)] = {};  // level 0, decoded on the CPU
+    size_t bytes[size_t(TextureFormat::Count)] = {};
+};
+
+// Offline style texture baking done at load time: mips on the CPU (gamma
+// correct, SSE filtered), block compression on the shared ThreadPool and a
+// DDS container (DX10 header) cached next to the source image. Texture
+// uploads the levels with glCompressedTexImage2D, or decodes them here when
+// the driver lacks the format. Nothing in this class touches GL.
+class TextureBaker
+{
+public:
+    // bump whenever the encoders or the container layout change
+    static constexpr uint32_t VERSION = 3;
+
+    // Off by default: BC5 normal maps need z rebuilt in the shader
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    // RGBA8 mip chain of an RGBA8 image, level 0 included
+    static std::vector<std::vector<uint8_t>> generateMips(const uint8_t* rgba, int width, int height,
+        const TextureBakeOptions& options);
+    // pixels: 1 to 4 channels per pixel, rows as Texture uploads them
+    static BakedTexture bake(const uint8_t* pixels, int width, int height, int channels,
+        const TextureBakeOptions& options);
+    // Loads the image with stb_image (flipped like Texture) and bakes it
+    static bool bakeFile(const std::string& path, BakedTexture& out, const TextureBakeOptions& options);
+
+    // One 4x4 block: 64 bytes of RGBA8 in, blockBytes(format) out
+    static void encodeBlock(TextureFormat format, const uint8_t rgba[64], uint8_t* out);
+    static void decodeBlock(TextureFormat format, const uint8_t* block, uint8_t rgba[64]);
+    static size_t blockBytes(TextureFormat format);
+    // Level back to RGBA8 (BC5 gives (r, g, 0, 255), like GL's RG formats)
+    static std::vector<uint8_t> decodeLevel(const BakedTexture& texture, int level);
+    // PSNR of level 0 against the source RGBA8, over the channels the format keeps
+    static double measurePSNR(const BakedTexture& texture, const uint8_t* rgba);
+
+    // Cache file next to the source
+    static std::string cachePathFor(const std::string& path);
+    // true for .dds paths
+    static bool isContainer(const std::string& path);
+    // Rows stay bottom-up and the header says so, so the file loads without a
+    // flip (other tools show it upside down). Files without that mark are
+    // top-down and get flipped block by block on read.
+    static bool writeDDS(const std::string& ddsPath, const BakedTexture& texture,
+        const std::string& sourcePath = std::string(), const TextureBakeOptions& options = TextureBakeOptions());
+    // With a source path the file must also be a baked cache of that source,
+    // still fresh (size and time) and baked with the same options
+    static bool readDDS(const std::string& ddsPath, BakedTexture& out,
+        const std::string& sourcePath = std::string(), const TextureBakeOptions& options = TextureBakeOptions());
+    // .dds paths are read as is; other images go through the cache, baking on a miss
+    static bool loadOrBake(const std::string& path, BakedTexture& out, const TextureBakeOptions& options);
+
+    // Bakes a synthetic size x size image with every format
+    static TextureBakeBenchmark benchmark(int size = 512, unsigned seed = 1);
+};
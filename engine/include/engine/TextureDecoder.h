@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+class ThreadPool;
+
+// Encoded image to decode, either a file or bytes already in memory
+struct TextureRequest
+{
+    std::string path;
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    bool flipVertically = true;
+};
+
+// 8-bit pixels decoded on the CPU, ready for upload
+struct DecodedImage
+{
+    std::unique_ptr<unsigned char, void (*)(void*)> pixels{ nullptr, nullptr };
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    // decoded from memory (embedded textures keep their linear filtering)
+    bool fromMemory = false;
+
+    bool isValid() const { return pixels != nullptr; }
+};
+
+// Thread-safe stb_image decoding, the flip flag is applied per call
+class TextureDecoder
+{
+public:
+    static DecodedImage decode(const TextureRequest& request);
+    // Decodes every request on the pool, results keep the request order
+    static std::vector<DecodedImage> decodeBatch(const std::vector<TextureRequest>& requests,
+        ThreadPool& pool);
+    static std::vector<DecodedImage> decodeBatch(const std::vector<TextureRequest>& requests);
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glad/glad.h>
+#include "engine/Texture.h"
+
+// Counters reported by the TextureRegistry
+struct TextureStats
+{
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t residentCount = 0;
+    size_t residentBytes = 0;
+};
+
+// One entry of a batch load: a file path, or encoded bytes in memory
+struct TextureLoad
+{
+    std::string path;
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    const char* type = "diffuse";
+    GLuint slot = 0;
+};
+
+// Engine-wide texture cache shared by every Model and direct Texture user.
+// Files are keyed by canonical path, embedded images by a hash of their bytes.
+// Entries are reference counted through the shared_ptr handed out; only
+// textures nobody holds any more are evicted (least recently used first)
+// when the resident size goes over the budget.
+// Evicting only retires a texture: loads run on worker contexts too, so the
+// GL names are deleted by flushEvictions() on the render thread between
+// frames. Call shutdown() before the GL context is destroyed.
+class TextureRegistry
+{
+public:
+    static TextureRegistry& instance();
+    // Only forgets what shutdown() left behind, there is no context to delete it in
+    ~TextureRegistry();
+
+    // Prevent copying
+    TextureRegistry(const TextureRegistry&) = delete;
+    TextureRegistry& operator=(const TextureRegistry&) = delete;
+
+    // Loads an image file, or returns the shared copy
+    std::shared_ptr<Texture> load(const std::string& path, const char* type, GLuint slot = 0);
+    // Loads an encoded image from memory (e.g. embedded "*N" textures)
+    std::shared_ptr<Texture> loadFromMemory(const unsigned char* data, size_t size,
+        const char* type, GLuint slot = 0);
+    // Resolves many textures at once: misses are decoded in parallel on the
+    // shared ThreadPool, then uploaded back to back on the calling thread.
+    // Results keep the input order, nullptr for entries with no source.
+    std::vector<std::shared_ptr<Texture>> loadBatch(const std::vector<TextureLoad>& loads);
+
+    // GPU memory budget in bytes, 0 means unlimited
+    void setBudget(size_t bytes);
+    size_t getBudget() const;
+    // Evicts unreferenced textures until under budget
+    void trim();
+    // Evicts every unreferenced texture
+    void purgeUnused();
+    // Deletes the textures evicted since the last call. Render thread only,
+    // at a frame boundary (AsyncModelLoader::poll does it).
+    void flushEvictions();
+    // Drops every entry and deletes what nobody else holds. Render thread,
+    // before the GL context is destroyed.
+    void shutdown();
+
+    TextureStats getStats() const;
+    void resetStats();
+
+private:
+    TextureRegistry() = default;
+
+    struct Entry {
+        std::shared_ptr<Texture> texture;
+        size_t bytes = 0;
+        uint64_t lastUse = 0;
+    };
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    // evicted, waiting for flushEvictions
+    std::vector<std::shared_ptr<Texture>> retired;
+    uint64_t useCounter = 0;
+    size_t budget = 0;
+    TextureStats stats;
+
+    static std::string keyFor(const TextureLoad& load);
+    std::shared_ptr<Texture> find(const std::string& key);
+    void insert(const std::string& key, const std::shared_ptr<Texture>& texture);
+    void evict(size_t targetBytes);
+};
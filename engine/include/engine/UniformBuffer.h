@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// C++ mirrors of the engine's std140 uniform blocks. Shaders declare
+//
+//     layout(std140) uniform FrameData {
+//         mat4 view;
+//         mat4 projection;
+//         mat4 viewProj;
+//         vec3 cameraPosition;
+//         float time;
+//     };
+//     layout(std140) uniform ObjectData {
+//         mat4 model;
+//         mat4 normalMatrix; // inverse transpose of model, upper 3x3 used
+//     };
+//
+// and Shader binds them to the fixed binding points below after linking.
+// Either block is optional; shaders without ObjectData keep the "model" uniform.
+struct FrameUniforms
+{
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::mat4 viewProj = glm::mat4(1.0f);
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    float time = 0.0f; // packs into the vec3's 16-byte slot
+};
+
+struct ObjectUniforms
+{
+    glm::mat4 model = glm::mat4(1.0f);
+    glm::mat4 normalMatrix = glm::mat4(1.0f);
+
+    static ObjectUniforms fromModel(const glm::mat4& model) {
+        ObjectUniforms block;
+        block.model = model;
+        block.normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(model))));
+        return block;
+    }
+};
+
+// std140: mat4 columns are vec4s, a vec3 takes 16 bytes unless a scalar follows
+static_assert(sizeof(glm::mat4) == 64 && sizeof(glm::vec3) == 12, "glm must not pad its types");
+static_assert(offsetof(FrameUniforms, view) == 0, "FrameData layout");
+static_assert(offsetof(FrameUniforms, projection) == 64, "FrameData layout");
+static_assert(offsetof(FrameUniforms, viewProj) == 128, "FrameData layout");
+static_assert(offsetof(FrameUniforms, cameraPosition) == 192, "FrameData layout");
+static_assert(offsetof(FrameUniforms, time) == 204, "FrameData layout");
+static_assert(sizeof(FrameUniforms) == 208, "FrameData size must be a multiple of 16");
+static_assert(offsetof(ObjectUniforms, model) == 0, "ObjectData layout");
+static_assert(offsetof(ObjectUniforms, normalMatrix) == 64, "ObjectData layout");
+static_assert(sizeof(ObjectUniforms) == 128, "ObjectData size must be a multiple of 16");
+
+struct UniformBufferStats
+{
+    size_t uploads = 0;      // glBufferSubData calls
+    size_t bytes = 0;        // uploaded
+    size_t rangeBinds = 0;   // glBindBufferRange calls
+    size_t orphans = 0;      // ring wrap-arounds
+};
+
+// GL uniform buffer attached to one binding point. Besides whole-buffer
+// updates it works as a ring of blocks: stream appends a block and binds only
+// that range, orphaning the storage when the ring wraps so the GPU never
+// waits on an upload.
+class UniformBuffer
+{
+public:
+    static constexpr GLuint FRAME_BINDING = 0;
+    static constexpr GLuint OBJECT_BINDING = 1;
+    static constexpr const char* FRAME_BLOCK = "FrameData";
+    static constexpr const char* OBJECT_BLOCK = "ObjectData";
+
+    GLuint ID = 0;
+
+    UniformBuffer(GLsizeiptr size, GLuint binding);
+    ~UniformBuffer();
+
+    // Prevent copying
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    // Overwrites [offset, offset + size) and binds the whole buffer
+    void update(const void* data, GLsizeiptr size, GLintptr offset = 0);
+    template <typename T>
+    void update(const T& block) { update(&block, sizeof(T)); }
+
+    // Appends one block to the ring and binds it, returns its offset
+    GLintptr stream(const void* data, GLsizeiptr size);
+    // Appends count blocks in one upload; data holds them alignedSize(blockSize)
+    // apart. Returns the offset of the first, bind each with bindRange.
+    GLintptr streamBatch(const void* data, GLsizeiptr blockSize, size_t count);
+    void bindRange(GLintptr offset, GLsizeiptr size);
+
+    GLsizeiptr getSize() const { return size; }
+    GLuint getBinding() const { return binding; }
+    UniformBufferStats getStats() const { return stats; }
+
+    // size rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    static GLsizeiptr alignedSize(GLsizeiptr size);
+
+    // Shared FrameData / ObjectData buffers, created on first use
+    static UniformBuffer& frame();
+    static UniformBuffer& objects();
+    static void updateFrame(const FrameUniforms& frameData) { frame().update(frameData); }
+    // Streams one ObjectData block (normal matrix derived from model)
+    static void streamObject(const glm::mat4& model);
+    // Deletes the shared buffers, call before the context goes away
+    static void destroyShared();
+
+private:
+    GLsizeiptr size;
+    GLuint binding;
+    GLintptr head = 0; // next free ring offset
+    UniformBufferStats stats;
+
+    void orphan(GLsizeiptr newSize);
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+// 64-bit FNV-1a of a uniform name. constexpr, so literal names fold at
+// compile time (guaranteed for constexpr UniformName constants).
+constexpr uint64_t hashUniformName(const char* name) {
+    uint64_t hash = 1469598103934665603ull;
+    for (; *name; ++name) {
+        hash ^= static_cast<unsigned char>(*name);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// A uniform name with its hash. Converts implicitly from literals and
+// std::string, the text is only read when the location is not cached yet.
+struct UniformName
+{
+    uint64_t hash;
+    const char* name;
+
+    constexpr UniformName(const char* text) : hash(hashUniformName(text)), name(text) {}
+    UniformName(const std::string& text) : UniformName(text.c_str()) {}
+    constexpr UniformName(uint64_t precomputed, const char* text) : hash(precomputed), name(text) {}
+};
+
+// Location resolved once, set without any lookup
+struct UniformHandle
+{
+    GLint location = -1;
+
+    constexpr UniformHandle() = default;
+    constexpr explicit UniformHandle(GLint loc) : location(loc) {}
+    bool valid() const { return location >= 0; }
+};
+
+// Timings of one UniformTable::benchmark run, in nanoseconds per lookup
+struct UniformLookupBenchmark
+{
+    size_t names = 0;
+    double stringMapNs = 0.0;   // std::unordered_map<std::string, GLint> from a literal
+    double tableNs = 0.0;       // this table, name hashed per call
+    double literalNs = 0.0;     // this table, hash folded at compile time
+    double handleNs = 0.0;      // pre-resolved handle
+};
+
+// Flat open-addressing map from name hash to location: linear probing over a
+// power-of-two array kept at most half full, so lookups touch one or two
+// adjacent entries and never allocate. Names are kept only to report the
+// (unlikely) case of two names sharing a hash.
+class UniformTable
+{
+public:
+    // location of hash, or nullptr when not cached yet
+    const GLint* find(uint64_t hash) const;
+    void insert(const UniformName& name, GLint location);
+    void clear();
+    size_t size() const { return count; }
+
+    // Compares the lookup paths over nameCount made-up names
+    static UniformLookupBenchmark benchmark(size_t nameCount = 16, size_t lookups = 1000000);
+
+private:
+    struct Entry {
+        uint64_t hash = 0; // 0 marks an empty slot
+        GLint location = -1;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<std::string> names; // parallel to entries
+    size_t count = 0;
+
+    static uint64_t slotHash(uint64_t hash) { return hash ? hash : 1; }
+    void grow();
+};
@@ -20,6 +20,9 @@ public:
 
 	// Links a VBO to the VAO using a certain layout for float attributes
 	void LinkVBO(VBO& VBO, GLuint layout, GLint numComponents, GLsizei stride, const void* offset);
+	// Links a VBO attribute of any component type (packed/normalized formats)
+	void LinkAttrib(VBO& VBO, GLuint layout, GLint numComponents, GLenum type,
+		GLboolean normalized, GLsizei stride, const void* offset);
 
 	// Binds the VAO
 	void Bind();
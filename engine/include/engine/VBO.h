@@ -3,6 +3,7 @@
 #include <glm/glm.hpp>
 #include <glad/glad.h>
 #include <vector>
+#include <cstddef>
 
 struct Vertex
 {
@@ -19,6 +20,10 @@ public:
 	GLuint ID;
 	// Constructor that generates a Vertex Buffer Object and links it to vertices
 	VBO(const std::vector<Vertex>& vertices);
+	// Same, uploading straight from memory (e.g. a mapped cache file)
+	VBO(const Vertex* vertices, size_t count);
+	// Same, for vertices already encoded into another layout
+	VBO(const void* data, size_t bytes);
 	// Destructor
 	~VBO() {
 		if (ID != 0) Delete();
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "engine/VBO.h"
+class VAO;
+
+// How texture coordinates are stored in a compact vertex
+enum class UVEncoding {
+    Float,   // 2 x float
+    Half,    // 2 x half float
+    UNorm16  // 2 x normalized ushort, only for UVs inside [0, 1] (others are clamped)
+};
+
+// GPU vertex layout used by a Mesh. Attribute locations stay the same as
+// the standard Vertex: 0 position, 1 normal, 2 color, 3 texUV.
+struct VertexFormat
+{
+    // 16-bit normalized positions inside the mesh bounds, scaled back by
+    // the mesh's dequantization matrix (uniform scale, normals unaffected)
+    bool quantizePositions = false;
+    // normals as GL_INT_2_10_10_10_REV instead of 3 floats
+    bool packNormals = false;
+    UVEncoding uv = UVEncoding::Float;
+    // per-vertex color (3 floats in the standard layout, RGBA8 otherwise);
+    // without it the color attribute reads constant white
+    bool includeColor = true;
+
+    // The 44-byte Vertex
+    static VertexFormat standard() { return VertexFormat(); }
+    // Packed normals, half UVs, no color: 20 bytes
+    static VertexFormat compact();
+    // Compact plus quantized positions: 16 bytes
+    static VertexFormat compactQuantized();
+
+    bool isStandard() const;
+    GLsizei stride() const;
+
+    // Converts standard vertices into this layout. quantMin/quantScale
+    // receive the dequantization (position = quantMin + p * quantScale).
+    std::vector<unsigned char> encode(const Vertex* vertices, size_t count,
+        const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+        glm::vec3& quantMin, float& quantScale) const;
+
+    // Links this layout of vbo into the currently bound vao
+    void link(VAO& vao, VBO& vbo) const;
+
+    bool operator==(const VertexFormat& o) const {
+        return quantizePositions == o.quantizePositions && packNormals == o.packNormals &&
+            uv == o.uv && includeColor == o.includeColor;
+    }
+    bool operator!=(const VertexFormat& o) const { return !(*this == o); }
+};
@@ -0,0 +1,147 @@
+#include "engine/AsyncModelLoader.h"
+#include "engine/Shader.h"
+#include "engine/TextureRegistry.h"
+#include <iostream>
+
+void ModelHandle::Draw(Shader& shader) {
+    if (Model* m = get()) m->Draw(shader);
+}
+
+AsyncModelLoader::AsyncModelLoader(GLFWwindow* mainWindow) {
+    // hidden 1x1 window whose only purpose is a context sharing with mainWindow,
+    // matching its version/profile (note: resets the caller's window hints)
+    glfwDefaultWindowHints();
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, glfwGetWindowAttrib(mainWindow, GLFW_CONTEXT_VERSION_MAJOR));
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, glfwGetWindowAttrib(mainWindow, GLFW_CONTEXT_VERSION_MINOR));
+    glfwWindowHint(GLFW_OPENGL_PROFILE, glfwGetWindowAttrib(mainWindow, GLFW_OPENGL_PROFILE));
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, glfwGetWindowAttrib(mainWindow, GLFW_OPENGL_FORWARD_COMPAT));
+    uploadContext = glfwCreateWindow(1, 1, "upload", nullptr, mainWindow);
+    glfwDefaultWindowHints();
+    if (!uploadContext) {
+        std::cerr << "[AsyncModelLoader] Failed to create shared upload context\n";
+        return;
+    }
+    worker = std::thread([this]() { workerLoop(); });
+}
+
+AsyncModelLoader::~AsyncModelLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) worker.join();
+
+    // never published, release their fences
+    for (auto& h : inFlight) {
+        if (h->fence) glDeleteSync(h->fence);
+        h->fence = nullptr;
+        h->state = LoadState::Failed;
+    }
+    for (auto& h : queue) h->state = LoadState::Failed;
+
+    if (uploadContext) glfwDestroyWindow(uploadContext);
+}
+
+std::shared_ptr<ModelHandle> AsyncModelLoader::load(const std::string& path,
+    const ModelOptions& options, const std::vector<std::string>& skipNames) {
+    auto handle = std::make_shared<ModelHandle>();
+    handle->path = path;
+    handle->options = options;
+    // VAOs must be created on the render context
+    handle->options.deferVertexArrays = true;
+    handle->skipNames = skipNames;
+    handle->requested = std::chrono::steady_clock::now();
+
+    if (!uploadContext) {
+        handle->state = LoadState::Failed;
+        return handle;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(handle);
+    }
+    wake.notify_one();
+    return handle;
+}
+
+void AsyncModelLoader::workerLoop() {
+    glfwMakeContextCurrent(uploadContext);
+
+    for (;;) {
+        std::shared_ptr<ModelHandle> handle;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (stopping) break;
+            handle = queue.front();
+            queue.pop_front();
+            ++loading;
+        }
+
+        handle->state = LoadState::Loading;
+        auto model = std::make_unique<Model>(handle->path, handle->options, handle->skipNames);
+
+        // fence marks the end of this model's uploads, flush so it can signal
+        GLsync fence = nullptr;
+        if (model->isLoaded()) {
+            fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glFlush();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        --loading;
+        if (!fence) {
+            handle->state = LoadState::Failed;
+            continue;
+        }
+        handle->fence = fence;
+        handle->model = std::move(model);
+        handle->state = LoadState::Uploading;
+        inFlight.push_back(handle);
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
+
+void AsyncModelLoader::poll() {
+    auto start = std::chrono::steady_clock::now();
+    // textures the workers' uploads pushed out of the budget
+    TextureRegistry::instance().flushEvictions();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < inFlight.size();) {
+        auto& h = inFlight[i];
+        // zero timeout: only check, never stall the frame
+        GLenum status = glClientWaitSync(h->fence, 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            glDeleteSync(h->fence);
+            h->fence = nullptr;
+            h->loadMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - h->requested).count();
+            h->state = LoadState::Ready;
+            std::cout << "[AsyncModelLoader] Ready: " << h->path
+                << " after " << h->loadMs << " ms\n";
+            inFlight.erase(inFlight.begin() + i);
+        }
+        else if (status == GL_WAIT_FAILED) {
+            glDeleteSync(h->fence);
+            h->fence = nullptr;
+            h->state = LoadState::Failed;
+            inFlight.erase(inFlight.begin() + i);
+        }
+        else {
+            ++i;
+        }
+    }
+
+    lastPollMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+size_t AsyncModelLoader::pendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.size() + loading + inFlight.size();
+}
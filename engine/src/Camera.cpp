@@ -1,5 +1,6 @@
 #include "engine/Camera.h"
 #include "engine/Shader.h"
+#include "engine/UniformBuffer.h"
 
 Camera::Camera(int width, int height, glm::vec3 position) {
 	Camera::width = width;
@@ -25,6 +26,20 @@ void Camera::Matrix(Shader& shader, const char* uniform) const {
 	shader.setMat4(uniform, cameraMatrix); // uses cached location
 }
 
+void Camera::UploadFrame(float time) const {
+	FrameUniforms frame;
+	frame.view = view;
+	frame.projection = projection;
+	frame.viewProj = cameraMatrix;
+	frame.cameraPosition = Position;
+	frame.time = time;
+	UniformBuffer::updateFrame(frame);
+}
+
+Frustum Camera::getFrustum() const {
+	return Frustum::fromMatrix(cameraMatrix);
+}
+
 void Camera::setSize(int newWidth, int newHeight) {
 	width = newWidth;
 	height = newHeight > 0 ? newHeight : 1; // avoid divide-by-zero
@@ -1,9 +1,10 @@
 #include "engine/Cubemap.h"
+#include "engine/GLState.h"
 
 Cubemap::Cubemap(int resolution) : size(resolution) {
     // Generates an OpenGL texture object
     glGenTextures(1, &ID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, ID);
+    GLState::bindTexture(GL_TEXTURE_CUBE_MAP, ID);
 
     // Allocate 6 faces (empty for now)
     for (int i = 0; i < 6; ++i) {
@@ -24,7 +25,41 @@ Cubemap::Cubemap(int resolution) : size(resolution) {
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 }
 
+Cubemap::Cubemap(const CubemapImage& image) : size(image.size), levels(image.levels) {
+    glGenTextures(1, &ID);
+    GLState::bindTexture(GL_TEXTURE_CUBE_MAP, ID);
+
+    // RGB half rows are 6 bytes per texel, not always a multiple of 4
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    for (int level = 0; level < levels; ++level) {
+        int levelSize = image.levelSize(level);
+        for (int i = 0; i < 6; ++i) {
+            glTexImage2D(
+                GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
+                level, GL_RGB16F,
+                levelSize, levelSize, 0,
+                GL_RGB, GL_HALF_FLOAT, image.face(level, i)
+            );
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+}
+
+std::unique_ptr<Cubemap> Cubemap::fromEquirect(const std::string& hdrPath, const CubemapBakeOptions& options) {
+    CubemapImage image;
+    if (!CubemapBaker::loadOrBake(hdrPath, image, options)) return nullptr;
+    return std::make_unique<Cubemap>(image);
+}
+
 void Cubemap::Bind(GLuint unit) const {
-    glActiveTexture(GL_TEXTURE0 + unit);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, ID);
+    GLState::bindTexture(unit, GL_TEXTURE_CUBE_MAP, ID);
 }
@@ -0,0 +1,371 @@
+#include "engine/CubemapBaker.h"
+#include "engine/ThreadPool.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+#include <stb_image.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+namespace fs = std::filesystem;
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ENGINE_CUBEMAP_SSE 1
+#endif
+
+namespace {
+
+    // face rows projected by one task
+    const int ROWS_PER_TASK = 8;
+    const float INV_TWO_PI = 0.159154943f;
+    const float INV_PI = 0.318309886f;
+    const char MAGIC[4] = { 'E', 'C', 'U', 'B' };
+
+    // On-disk layout: header, then every level's six faces of RGB halves
+    struct FileHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t size;
+        uint32_t levels;
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        uint32_t supersample;
+        uint32_t reserved;
+    };
+
+    // dir = u * right + v * up + forward, from HDRConverter's view matrices
+    struct FaceBasis {
+        glm::vec3 right, up, forward;
+    };
+
+    FaceBasis faceBasis(int face) {
+        static const glm::vec3 targets[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+        static const glm::vec3 ups[6] = { { 0, -1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 0, -1, 0 }, { 0, -1, 0 } };
+        // view space (u, v, -1) back to world space
+        glm::mat3 inverse = glm::transpose(glm::mat3(glm::lookAt(glm::vec3(0.0f), targets[face], ups[face])));
+        return { inverse[0], inverse[1], -inverse[2] };
+    }
+
+    // Bilinear taps of the equirect image, wrapping around horizontally
+    struct Equirect {
+        const float* pixels;
+        int width, height;
+
+        void sample(float u, float v, float* out) const {
+            float x = u * width - 0.5f;
+            float y = v * height - 0.5f;
+            float fx = std::floor(x), fy = std::floor(y);
+            float tx = x - fx, ty = y - fy;
+            int x0 = int(fx) % width;
+            if (x0 < 0) x0 += width;
+            int x1 = x0 + 1 == width ? 0 : x0 + 1;
+            int y0 = std::min(std::max(int(fy), 0), height - 1);
+            int y1 = std::min(std::max(int(fy) + 1, 0), height - 1);
+            const float* p00 = pixels + (size_t(y0) * width + x0) * 3;
+            const float* p10 = pixels + (size_t(y0) * width + x1) * 3;
+            const float* p01 = pixels + (size_t(y1) * width + x0) * 3;
+            const float* p11 = pixels + (size_t(y1) * width + x1) * 3;
+            for (int c = 0; c < 3; ++c) {
+                float top = p00[c] + (p10[c] - p00[c]) * tx;
+                float bottom = p01[c] + (p11[c] - p01[c]) * tx;
+                out[c] = top + (bottom - top) * ty;
+            }
+        }
+    };
+
+    // same mapping as hdr2cubemap.frag
+    void directionToUV(float x, float y, float z, float& u, float& v) {
+        float invLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+        u = std::atan2(z, x) * INV_TWO_PI + 0.5f;
+        v = std::asin(std::min(std::max(y * invLength, -1.0f), 1.0f)) * INV_PI + 0.5f;
+    }
+
+#ifdef ENGINE_CUBEMAP_SSE
+    // atan2 to ~1e-5 rad: odd minimax polynomial on [0, 1] plus octant fix-up
+    __m128 atan2Sse(__m128 y, __m128 x) {
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        __m128 ax = _mm_andnot_ps(signMask, x);
+        __m128 ay = _mm_andnot_ps(signMask, y);
+        __m128 high = _mm_max_ps(ax, ay);
+        __m128 low = _mm_min_ps(ax, ay);
+        __m128 a = _mm_div_ps(low, _mm_max_ps(high, _mm_set1_ps(1e-30f)));
+        __m128 s = _mm_mul_ps(a, a);
+        __m128 r = _mm_set1_ps(-0.0117212f);
+        r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(0.05265332f));
+        r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(-0.11643287f));
+        r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(0.19354346f));
+        r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(-0.33262347f));
+        r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(0.99997726f));
+        r = _mm_mul_ps(r, a);
+        // |y| > |x|: pi/2 - r
+        __m128 swap = _mm_cmpgt_ps(ay, ax);
+        r = _mm_or_ps(_mm_and_ps(swap, _mm_sub_ps(_mm_set1_ps(1.57079633f), r)), _mm_andnot_ps(swap, r));
+        // x < 0: pi - r
+        __m128 negX = _mm_cmplt_ps(x, _mm_setzero_ps());
+        r = _mm_or_ps(_mm_and_ps(negX, _mm_sub_ps(_mm_set1_ps(3.14159265f), r)), _mm_andnot_ps(negX, r));
+        // sign of y
+        return _mm_or_ps(r, _mm_and_ps(signMask, y));
+    }
+#endif
+
+    // Projects face row y (supersampled n x n) into out, RGB floats
+    void projectRow(const Equirect& src, const FaceBasis& basis, int size, int y, int n, float* out) {
+        const float scale = 2.0f / float(size);
+        const float weight = 1.0f / float(n * n);
+        std::fill(out, out + size_t(size) * 3, 0.0f);
+
+        for (int sy = 0; sy < n; ++sy) {
+            float v = (float(y) + (float(sy) + 0.5f) / float(n)) * scale - 1.0f;
+            glm::vec3 rowBase = basis.forward + v * basis.up;
+            for (int sx = 0; sx < n; ++sx) {
+                float offset = (float(sx) + 0.5f) / float(n);
+                int x = 0;
+                float color[3];
+#ifdef ENGINE_CUBEMAP_SSE
+                alignas(16) float us[4], vs[4];
+                const __m128 lane = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+                for (; x + 4 <= size; x += 4) {
+                    __m128 u = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(_mm_set1_ps(float(x) + offset), lane),
+                        _mm_set1_ps(scale)), _mm_set1_ps(1.0f));
+                    __m128 dx = _mm_add_ps(_mm_set1_ps(rowBase.x), _mm_mul_ps(u, _mm_set1_ps(basis.right.x)));
+                    __m128 dy = _mm_add_ps(_mm_set1_ps(rowBase.y), _mm_mul_ps(u, _mm_set1_ps(basis.right.y)));
+                    __m128 dz = _mm_add_ps(_mm_set1_ps(rowBase.z), _mm_mul_ps(u, _mm_set1_ps(basis.right.z)));
+                    // longitude from (x, z), latitude against the horizontal length
+                    __m128 horizontal = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz)));
+                    __m128 lon = atan2Sse(dz, dx);
+                    __m128 lat = atan2Sse(dy, horizontal);
+                    _mm_store_ps(us, _mm_add_ps(_mm_mul_ps(lon, _mm_set1_ps(INV_TWO_PI)), _mm_set1_ps(0.5f)));
+                    _mm_store_ps(vs, _mm_add_ps(_mm_mul_ps(lat, _mm_set1_ps(INV_PI)), _mm_set1_ps(0.5f)));
+                    for (int i = 0; i < 4; ++i) {
+                        src.sample(us[i], vs[i], color);
+                        float* texel = out + size_t(x + i) * 3;
+                        texel[0] += color[0];
+                        texel[1] += color[1];
+                        texel[2] += color[2];
+                    }
+                }
+#endif
+                for (; x < size; ++x) {
+                    float u = (float(x) + offset) * scale - 1.0f;
+                    glm::vec3 dir = rowBase + u * basis.right;
+                    float tu, tv;
+                    directionToUV(dir.x, dir.y, dir.z, tu, tv);
+                    src.sample(tu, tv, color);
+                    float* texel = out + size_t(x) * 3;
+                    texel[0] += color[0];
+                    texel[1] += color[1];
+                    texel[2] += color[2];
+                }
+            }
+        }
+        if (n > 1) {
+            for (size_t i = 0; i < size_t(size) * 3; ++i) out[i] *= weight;
+        }
+    }
+
+    // 2x2 box filter, odd sizes clamp the last row/column
+    void downsample(const std::vector<float>& src, int srcSize, std::vector<float>& dst, int dstSize) {
+        dst.resize(size_t(dstSize) * dstSize * 3);
+        for (int y = 0; y < dstSize; ++y) {
+            int y0 = std::min(y * 2, srcSize - 1), y1 = std::min(y * 2 + 1, srcSize - 1);
+            for (int x = 0; x < dstSize; ++x) {
+                int x0 = std::min(x * 2, srcSize - 1), x1 = std::min(x * 2 + 1, srcSize - 1);
+                for (int c = 0; c < 3; ++c) {
+                    dst[(size_t(y) * dstSize + x) * 3 + c] = 0.25f * (
+                        src[(size_t(y0) * srcSize + x0) * 3 + c] + src[(size_t(y0) * srcSize + x1) * 3 + c] +
+                        src[(size_t(y1) * srcSize + x0) * 3 + c] + src[(size_t(y1) * srcSize + x1) * 3 + c]);
+                }
+            }
+        }
+    }
+
+    std::vector<uint16_t> toHalf(const std::vector<float>& values) {
+        std::vector<uint16_t> halves(values.size());
+        for (size_t i = 0; i < values.size(); ++i) halves[i] = glm::packHalf1x16(values[i]);
+        return halves;
+    }
+
+    bool sourceState(const std::string& path, uint64_t& size, int64_t& time) {
+        std::error_code ec;
+        size = fs::file_size(path, ec);
+        if (ec) return false;
+        auto t = fs::last_write_time(path, ec);
+        if (ec) return false;
+        time = static_cast<int64_t>(t.time_since_epoch().count());
+        return true;
+    }
+
+    int levelCount(const CubemapBakeOptions& options) {
+        if (!options.mipmaps) return 1;
+        int levels = 1;
+        while ((options.size >> levels) > 0) ++levels;
+        return levels;
+    }
+
+} // namespace
+
+CubemapImage CubemapBaker::bake(const float* equirect, int width, int height, const CubemapBakeOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    CubemapImage image;
+    if (!equirect || width <= 0 || height <= 0 || options.size <= 0) return image;
+
+    const int size = options.size;
+    const int n = std::max(1, options.supersample);
+    image.size = size;
+    image.levels = levelCount(options);
+
+    // level 0 in floats, tasks are bands of rows of one face
+    std::vector<std::vector<float>> level(6, std::vector<float>(size_t(size) * size * 3));
+    Equirect src{ equirect, width, height };
+    const int bandsPerFace = (size + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    ThreadPool::shared().parallelFor(size_t(6 * bandsPerFace), [&](size_t task) {
+        int face = int(task) / bandsPerFace;
+        int firstRow = (int(task) % bandsPerFace) * ROWS_PER_TASK;
+        int lastRow = std::min(firstRow + ROWS_PER_TASK, size);
+        FaceBasis basis = faceBasis(face);
+        for (int y = firstRow; y < lastRow; ++y)
+            projectRow(src, basis, size, y, n, level[face].data() + size_t(y) * size * 3);
+    });
+
+    // mip chain, each face on its own task
+    std::vector<std::vector<std::vector<float>>> levels(image.levels);
+    levels[0] = std::move(level);
+    for (int l = 1; l < image.levels; ++l) levels[l].resize(6);
+    ThreadPool::shared().parallelFor(6, [&](size_t face) {
+        for (int l = 1; l < image.levels; ++l)
+            downsample(levels[l - 1][face], image.levelSize(l - 1), levels[l][face], image.levelSize(l));
+    });
+
+    image.faces.resize(size_t(image.levels) * 6);
+    ThreadPool::shared().parallelFor(image.faces.size(), [&](size_t i) {
+        image.faces[i] = toHalf(levels[i / 6][i % 6]);
+    });
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[CubemapBaker] Baked " << size << "x" << size << " x6 (" << image.levels << " levels, "
+        << n << "x" << n << " samples) in " << ms << " ms\n";
+    return image;
+}
+
+bool CubemapBaker::bakeFile(const std::string& hdrPath, CubemapImage& out, const CubemapBakeOptions& options) {
+    // bottom-up rows like HDRTexture, with the thread-local flip flag
+    int width, height, channels;
+    stbi_set_flip_vertically_on_load_thread(1);
+    float* data = stbi_loadf(hdrPath.c_str(), &width, &height, &channels, 3);
+    if (!data) {
+        std::cerr << "[CubemapBaker] Failed to load " << hdrPath << ": " << stbi_failure_reason() << "\n";
+        return false;
+    }
+    out = bake(data, width, height, options);
+    stbi_image_free(data);
+    return out.isValid();
+}
+
+std::string CubemapBaker::cachePathFor(const std::string& hdrPath, const CubemapBakeOptions& options) {
+    return hdrPath + "." + std::to_string(options.size) + ".cubecache";
+}
+
+bool CubemapBaker::write(const std::string& cachePath, const std::string& hdrPath,
+    const CubemapBakeOptions& options, const CubemapImage& image) {
+    if (!image.isValid()) return false;
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, 4);
+    header.version = VERSION;
+    header.size = uint32_t(image.size);
+    header.levels = uint32_t(image.levels);
+    header.supersample = uint32_t(std::max(1, options.supersample));
+    if (!sourceState(hdrPath, header.sourceSize, header.sourceTime)) return false;
+
+    // write to a temporary file and swap it in, so readers never see a partial cache
+    std::string tmpPath = cachePath + ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& face : image.faces)
+            out.write(reinterpret_cast<const char*>(face.data()), std::streamsize(face.size() * sizeof(uint16_t)));
+        if (!out) {
+            out.close();
+            fs::remove(tmpPath, ec);
+            return false;
+        }
+    }
+    fs::rename(tmpPath, cachePath, ec);
+    if (ec) {
+        // some platforms refuse to rename over an existing file
+        fs::remove(cachePath, ec);
+        fs::rename(tmpPath, cachePath, ec);
+    }
+    return !ec;
+}
+
+bool CubemapBaker::read(const std::string& cachePath, const std::string& hdrPath,
+    const CubemapBakeOptions& options, CubemapImage& out) {
+    std::ifstream in(cachePath, std::ios::binary);
+    FileHeader header{};
+    if (!in || !in.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    bool hasSource = sourceState(hdrPath, sourceSize, sourceTime);
+    // without the source (shipped cache only) the cache is trusted as is
+    if (std::memcmp(header.magic, MAGIC, 4) != 0 || header.version != VERSION
+        || int(header.size) != options.size || int(header.levels) != levelCount(options)
+        || int(header.supersample) != std::max(1, options.supersample)
+        || (hasSource && (header.sourceSize != sourceSize || header.sourceTime != sourceTime)))
+        return false;
+
+    CubemapImage image;
+    image.size = int(header.size);
+    image.levels = int(header.levels);
+    image.faces.resize(size_t(image.levels) * 6);
+    for (size_t i = 0; i < image.faces.size(); ++i) {
+        int s = image.levelSize(int(i / 6));
+        image.faces[i].resize(size_t(s) * s * 3);
+        if (!in.read(reinterpret_cast<char*>(image.faces[i].data()), std::streamsize(image.faces[i].size() * sizeof(uint16_t))))
+            return false;
+    }
+    out = std::move(image);
+    return true;
+}
+
+bool CubemapBaker::loadOrBake(const std::string& hdrPath, CubemapImage& out, const CubemapBakeOptions& options) {
+    std::string cachePath = cachePathFor(hdrPath, options);
+    auto start = std::chrono::steady_clock::now();
+    if (read(cachePath, hdrPath, options, out)) {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "[CubemapBaker] Loaded " << cachePath << " in " << ms << " ms\n";
+        return true;
+    }
+    if (!bakeFile(hdrPath, out, options)) return false;
+    if (!write(cachePath, hdrPath, options, out))
+        std::cerr << "[CubemapBaker] Could not write " << cachePath << "\n";
+    return true;
+}
+
+void CubemapBaker::texelDirection(int face, float u, float v, float dir[3]) {
+    FaceBasis basis = faceBasis(face);
+    glm::vec3 d = basis.forward + u * basis.right + v * basis.up;
+    dir[0] = d.x;
+    dir[1] = d.y;
+    dir[2] = d.z;
+}
+
+void CubemapBaker::directionToFace(const float dir[3], int& face, float& u, float& v) {
+    // major axis picks the face, in GL order +X, -X, +Y, -Y, +Z, -Z
+    float ax = std::fabs(dir[0]), ay = std::fabs(dir[1]), az = std::fabs(dir[2]);
+    int axis = ax >= ay && ax >= az ? 0 : (ay >= az ? 1 : 2);
+    face = axis * 2 + (dir[axis] < 0.0f ? 1 : 0);
+
+    static const FaceBasis bases[6] = { faceBasis(0), faceBasis(1), faceBasis(2), faceBasis(3), faceBasis(4), faceBasis(5) };
+    const FaceBasis& basis = bases[face];
+    glm::vec3 d(dir[0], dir[1], dir[2]);
+    float invMajor = 1.0f / std::max(glm::dot(d, basis.forward), 1e-30f);
+    u = glm::dot(d, basis.right) * invMajor;
+    v = glm::dot(d, basis.up) * invMajor;
+}
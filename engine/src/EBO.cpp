@@ -1,23 +1,36 @@
 #include "engine/EBO.h"
+#include "engine/GLState.h"
 
 // Constructor that generates a Elements Buffer Object and links it to indices
-EBO::EBO(const std::vector<GLuint>& indices) {
+EBO::EBO(const std::vector<GLuint>& indices)
+	: EBO(indices.data(), indices.size()) {}
+
+// Constructor that uploads indices from any contiguous memory
+EBO::EBO(const GLuint* indices, size_t count, GLenum type) {
 	glGenBuffers(1, &ID);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+	// upload through the copy target, the element binding belongs to whichever VAO is bound
+	GLState::bindBuffer(GL_COPY_WRITE_BUFFER, ID);
+	if (type == GL_UNSIGNED_SHORT) {
+		// caller guarantees every index fits in 16 bits
+		std::vector<GLushort> narrow(indices, indices + count);
+		glBufferData(GL_COPY_WRITE_BUFFER, count * sizeof(GLushort), narrow.data(), GL_STATIC_DRAW);
+	}
+	else {
+		glBufferData(GL_COPY_WRITE_BUFFER, count * sizeof(GLuint), indices, GL_STATIC_DRAW);
+	}
 }
 
 // Binds the EBO
 void EBO::Bind() {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
 }
 
 // Unbinds the EBO
 void EBO::Unbind() {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 // Deletes the EBO
 void EBO::Delete() {
-	glDeleteBuffers(1, &ID);
+	GLState::deleteBuffer(ID);
 }
\ No newline at end of file
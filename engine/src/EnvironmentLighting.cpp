@@ -0,0 +1,53 @@
+#include "engine/EnvironmentLighting.h"
+#include "engine/GLState.h"
+#include "engine/Shader.h"
+
+namespace {
+
+    // names in ibl.glsl
+    constexpr UniformName SH_UNIFORMS[9] = {
+        "irradianceSH[0]", "irradianceSH[1]", "irradianceSH[2]",
+        "irradianceSH[3]", "irradianceSH[4]", "irradianceSH[5]",
+        "irradianceSH[6]", "irradianceSH[7]", "irradianceSH[8]",
+    };
+    constexpr UniformName PREFILTERED_MAP("prefilteredMap");
+    constexpr UniformName PREFILTERED_LEVELS("prefilteredLevels");
+    constexpr UniformName BRDF_LUT("brdfLut");
+
+} // namespace
+
+EnvironmentLighting::EnvironmentLighting(const IBLData& data) : specular(std::make_unique<Cubemap>(data.specular)) {
+    std::copy(data.sh, data.sh + 9, sh);
+    // filter across cube faces, otherwise the small rough levels show their seams
+    GLState::setEnabled(GL_TEXTURE_CUBE_MAP_SEAMLESS, true);
+
+    glGenTextures(1, &brdfLut);
+    GLState::bindTexture(GL_TEXTURE_2D, brdfLut);
+    // RG halves are 4 bytes per texel, the default alignment holds
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, data.lutSize, data.lutSize, 0, GL_RG, GL_HALF_FLOAT, data.brdfLut.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+EnvironmentLighting::~EnvironmentLighting() {
+    if (brdfLut != 0) GLState::deleteTexture(brdfLut);
+    if (specular && specular->ID != 0) GLState::deleteTexture(specular->ID);
+}
+
+std::unique_ptr<EnvironmentLighting> EnvironmentLighting::fromEquirect(const std::string& hdrPath,
+    const IBLBakeOptions& options) {
+    IBLData data;
+    if (!IBLBaker::loadOrBake(hdrPath, data, options)) return nullptr;
+    return std::make_unique<EnvironmentLighting>(data);
+}
+
+void EnvironmentLighting::apply(const Shader& shader, GLuint specularUnit, GLuint lutUnit) const {
+    specular->Bind(specularUnit);
+    GLState::bindTexture(lutUnit, GL_TEXTURE_2D, brdfLut);
+    shader.setInt(PREFILTERED_MAP, int(specularUnit));
+    shader.setInt(BRDF_LUT, int(lutUnit));
+    shader.setFloat(PREFILTERED_LEVELS, float(specular->levels - 1));
+    for (int i = 0; i < 9; ++i) shader.setVec3(SH_UNIFORMS[i], sh[i]);
+}
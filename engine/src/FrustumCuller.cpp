@@ -0,0 +1,146 @@
+#include "engine/FrustumCuller.h"
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define ENGINE_CULL_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ENGINE_CULL_SSE 1
+#endif
+
+Frustum Frustum::fromMatrix(const glm::mat4& m) {
+    // glm is column-major, row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    auto row = [&](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+    Frustum f;
+    f.planes[Left] = row(3) + row(0);
+    f.planes[Right] = row(3) - row(0);
+    f.planes[Bottom] = row(3) + row(1);
+    f.planes[Top] = row(3) - row(1);
+    f.planes[Near] = row(3) + row(2);
+    f.planes[Far] = row(3) - row(2);
+    for (auto& p : f.planes) {
+        float len = glm::length(glm::vec3(p));
+        if (len > 0.0f) p /= len;
+    }
+    return f;
+}
+
+bool Frustum::intersectsAABB(const glm::vec3& min, const glm::vec3& max) const {
+    glm::vec3 c = (min + max) * 0.5f;
+    glm::vec3 e = (max - min) * 0.5f;
+    for (const auto& p : planes) {
+        glm::vec3 n(p);
+        // box is outside once even its most positive corner is behind the plane
+        if (glm::dot(n, c) + p.w + glm::dot(glm::abs(n), e) < 0.0f) return false;
+    }
+    return true;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const {
+    for (const auto& p : planes) {
+        if (glm::dot(glm::vec3(p), center) + p.w < -radius) return false;
+    }
+    return true;
+}
+
+void FrustumCuller::clear() {
+    count = 0;
+    cx.clear(); cy.clear(); cz.clear();
+    ex.clear(); ey.clear(); ez.clear();
+}
+
+void FrustumCuller::reserve(size_t n) {
+    n = (n + 7) & ~size_t(7);
+    cx.reserve(n); cy.reserve(n); cz.reserve(n);
+    ex.reserve(n); ey.reserve(n); ez.reserve(n);
+}
+
+size_t FrustumCuller::add(const glm::vec3& min, const glm::vec3& max) {
+    // drop the padding of the last block before appending
+    cx.resize(count); cy.resize(count); cz.resize(count);
+    ex.resize(count); ey.resize(count); ez.resize(count);
+
+    glm::vec3 c = (min + max) * 0.5f;
+    glm::vec3 e = (max - min) * 0.5f;
+    cx.push_back(c.x); cy.push_back(c.y); cz.push_back(c.z);
+    ex.push_back(e.x); ey.push_back(e.y); ez.push_back(e.z);
+
+    // pad with zero-sized boxes so SIMD loads never run past the end
+    size_t padded = (count + 1 + 7) & ~size_t(7);
+    cx.resize(padded); cy.resize(padded); cz.resize(padded);
+    ex.resize(padded); ey.resize(padded); ez.resize(padded);
+    return count++;
+}
+
+size_t FrustumCuller::cullScalar(const Frustum& frustum, std::vector<uint8_t>& visible) const {
+    visible.assign(count, 0);
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        bool inside = true;
+        for (const auto& p : frustum.planes) {
+            float d = p.x * cx[i] + p.y * cy[i] + p.z * cz[i] + p.w;
+            float r = std::fabs(p.x) * ex[i] + std::fabs(p.y) * ey[i] + std::fabs(p.z) * ez[i];
+            if (d + r < 0.0f) {
+                inside = false;
+                break;
+            }
+        }
+        visible[i] = inside ? 1 : 0;
+        visibleCount += inside ? 1 : 0;
+    }
+    return visibleCount;
+}
+
+size_t FrustumCuller::cull(const Frustum& frustum, std::vector<uint8_t>& visible) const {
+#if defined(ENGINE_CULL_AVX)
+    visible.assign(count, 0);
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < count; i += 8) {
+        __m256 px = _mm256_loadu_ps(&cx[i]), py = _mm256_loadu_ps(&cy[i]), pz = _mm256_loadu_ps(&cz[i]);
+        __m256 qx = _mm256_loadu_ps(&ex[i]), qy = _mm256_loadu_ps(&ey[i]), qz = _mm256_loadu_ps(&ez[i]);
+        __m256 outside = _mm256_setzero_ps();
+        for (const auto& p : frustum.planes) {
+            __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.x), px),
+                _mm256_mul_ps(_mm256_set1_ps(p.y), py)),
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.z), pz), _mm256_set1_ps(p.w)));
+            __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(std::fabs(p.x)), qx),
+                _mm256_mul_ps(_mm256_set1_ps(std::fabs(p.y)), qy)),
+                _mm256_mul_ps(_mm256_set1_ps(std::fabs(p.z)), qz));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+        int mask = _mm256_movemask_ps(outside);
+        for (size_t k = 0; k < 8 && i + k < count; ++k) {
+            uint8_t in = (mask >> k) & 1 ? 0 : 1;
+            visible[i + k] = in;
+            visibleCount += in;
+        }
+    }
+    return visibleCount;
+#elif defined(ENGINE_CULL_SSE)
+    visible.assign(count, 0);
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < count; i += 4) {
+        __m128 px = _mm_loadu_ps(&cx[i]), py = _mm_loadu_ps(&cy[i]), pz = _mm_loadu_ps(&cz[i]);
+        __m128 qx = _mm_loadu_ps(&ex[i]), qy = _mm_loadu_ps(&ey[i]), qz = _mm_loadu_ps(&ez[i]);
+        __m128 outside = _mm_setzero_ps();
+        for (const auto& p : frustum.planes) {
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.x), px), _mm_mul_ps(_mm_set1_ps(p.y), py)),
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.z), pz), _mm_set1_ps(p.w)));
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::fabs(p.x)), qx),
+                _mm_mul_ps(_mm_set1_ps(std::fabs(p.y)), qy)),
+                _mm_mul_ps(_mm_set1_ps(std::fabs(p.z)), qz));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+        }
+        int mask = _mm_movemask_ps(outside);
+        for (size_t k = 0; k < 4 && i + k < count; ++k) {
+            uint8_t in = (mask >> k) & 1 ? 0 : 1;
+            visible[i + k] = in;
+            visibleCount += in;
+        }
+    }
+    return visibleCount;
+#else
+    return cullScalar(frustum, visible);
+#endif
+}
@@ -0,0 +1,310 @@
+#include "engine/GLState.h"
+#include <atomic>
+#include <cstdint>
+
+namespace {
+
+    const GLuint UNKNOWN = ~0u;
+    const GLuint MAX_UNITS = 32;
+    // texture targets with a shadow per unit
+    const GLenum TEXTURE_TARGETS[] = { GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY };
+    const int TEXTURE_TARGET_COUNT = 3;
+    const GLenum BUFFER_TARGETS[] = { GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_COPY_READ_BUFFER,
+        GL_COPY_WRITE_BUFFER, GL_UNIFORM_BUFFER, GL_PIXEL_UNPACK_BUFFER };
+    const int BUFFER_TARGET_COUNT = 6;
+
+    // -1 unknown, otherwise 0 / 1
+    using Tristate = int;
+
+    struct Shadow {
+        GLuint program = UNKNOWN;
+        GLuint vertexArray = UNKNOWN;
+        GLuint buffers[BUFFER_TARGET_COUNT];
+        GLuint framebuffer = UNKNOWN;
+        GLuint activeUnit = UNKNOWN;
+        GLuint textures[MAX_UNITS][TEXTURE_TARGET_COUNT];
+        Tristate depthTest = -1, cullFace = -1, blend = -1;
+        GLenum cullMode = 0;  // 0 unknown
+        GLenum depthFunc = 0;
+        Tristate depthMask = -1;
+        GLint viewport[4] = {};
+        bool viewportKnown = false;
+        GLStateStats stats;
+        uint64_t sharedGeneration = 0;
+
+        Shadow() { forget(); }
+
+        // programs, buffers and textures are shared between contexts
+        void forgetShared() {
+            program = UNKNOWN;
+            for (auto& b : buffers) b = UNKNOWN;
+            for (auto& unit : textures)
+                for (auto& t : unit) t = UNKNOWN;
+        }
+
+        void forget() {
+            forgetShared();
+            vertexArray = framebuffer = activeUnit = UNKNOWN;
+            depthTest = cullFace = blend = depthMask = -1;
+            cullMode = depthFunc = 0;
+            viewportKnown = false;
+        }
+    };
+
+    thread_local Shadow shadow;
+
+    // Bumped by every delete of a shared object. Another context may get the
+    // deleted name back from glGen*, so the other threads' shadows can no
+    // longer trust bindings they recorded under that name.
+    std::atomic<uint64_t> sharedDeletions{ 0 };
+
+    void syncShared() {
+        uint64_t generation = sharedDeletions.load(std::memory_order_acquire);
+        if (generation == shadow.sharedGeneration) return;
+        shadow.forgetShared();
+        shadow.sharedGeneration = generation;
+    }
+
+    // before the glDelete*, so a name handed out again is seen after the bump;
+    // the deleting thread keeps its shadow when it was current
+    void bumpShared() {
+        syncShared();
+        uint64_t previous = sharedDeletions.fetch_add(1, std::memory_order_acq_rel);
+        if (previous == shadow.sharedGeneration) shadow.sharedGeneration = previous + 1;
+    }
+
+    int bufferIndex(GLenum target) {
+        for (int i = 0; i < BUFFER_TARGET_COUNT; ++i)
+            if (BUFFER_TARGETS[i] == target) return i;
+        return -1;
+    }
+
+    int textureIndex(GLenum target) {
+        for (int i = 0; i < TEXTURE_TARGET_COUNT; ++i)
+            if (TEXTURE_TARGETS[i] == target) return i;
+        return -1;
+    }
+
+    Tristate* capability(GLenum cap) {
+        switch (cap) {
+        case GL_DEPTH_TEST: return &shadow.depthTest;
+        case GL_CULL_FACE: return &shadow.cullFace;
+        case GL_BLEND: return &shadow.blend;
+        default: return nullptr;
+        }
+    }
+
+    // true when value is already current (and counts the skip)
+    template <typename T>
+    bool unchanged(T& current, T value) {
+        if (current == value) {
+            ++shadow.stats.skipped;
+            return true;
+        }
+        current = value;
+        ++shadow.stats.issued;
+        return false;
+    }
+
+} // namespace
+
+void GLState::useProgram(GLuint program) {
+    syncShared();
+    if (unchanged(shadow.program, program)) return;
+    glUseProgram(program);
+}
+
+void GLState::bindVertexArray(GLuint vertexArray) {
+    if (unchanged(shadow.vertexArray, vertexArray)) return;
+    glBindVertexArray(vertexArray);
+    // the element buffer binding is part of the VAO
+    shadow.buffers[bufferIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+    syncShared();
+    int i = bufferIndex(target);
+    if (i < 0) {
+        ++shadow.stats.issued;
+    }
+    else if (unchanged(shadow.buffers[i], buffer)) {
+        return;
+    }
+    glBindBuffer(target, buffer);
+}
+
+void GLState::bindFramebuffer(GLuint framebuffer) {
+    if (unchanged(shadow.framebuffer, framebuffer)) return;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void GLState::activeTexture(GLuint unit) {
+    if (unchanged(shadow.activeUnit, unit)) return;
+    glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture) {
+    syncShared();
+    int t = textureIndex(target);
+    GLuint unit = shadow.activeUnit;
+    if (t < 0 || unit >= MAX_UNITS) {
+        ++shadow.stats.issued;
+    }
+    else if (unchanged(shadow.textures[unit][t], texture)) {
+        return;
+    }
+    glBindTexture(target, texture);
+}
+
+void GLState::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+    syncShared();
+    int t = textureIndex(target);
+    if (t >= 0 && unit < MAX_UNITS && shadow.textures[unit][t] == texture) {
+        ++shadow.stats.skipped;
+        return;
+    }
+    activeTexture(unit);
+    bindTexture(target, texture);
+}
+
+void GLState::setEnabled(GLenum cap, bool enabled) {
+    Tristate* state = capability(cap);
+    if (state && unchanged(*state, Tristate(enabled))) return;
+    if (!state) ++shadow.stats.issued;
+    if (enabled) glEnable(cap);
+    else glDisable(cap);
+}
+
+bool GLState::isEnabled(GLenum cap) {
+    Tristate* state = capability(cap);
+    if (state && *state >= 0) {
+        ++shadow.stats.queriesServed;
+        return *state != 0;
+    }
+    ++shadow.stats.queriesIssued;
+    bool enabled = glIsEnabled(cap) == GL_TRUE;
+    if (state) *state = enabled;
+    return enabled;
+}
+
+void GLState::cullFace(GLenum mode) {
+    if (unchanged(shadow.cullMode, mode)) return;
+    glCullFace(mode);
+}
+
+GLenum GLState::getCullFace() {
+    if (shadow.cullMode != 0) {
+        ++shadow.stats.queriesServed;
+        return shadow.cullMode;
+    }
+    ++shadow.stats.queriesIssued;
+    GLint mode = GL_BACK;
+    glGetIntegerv(GL_CULL_FACE_MODE, &mode);
+    shadow.cullMode = GLenum(mode);
+    return shadow.cullMode;
+}
+
+void GLState::depthFunc(GLenum func) {
+    if (unchanged(shadow.depthFunc, func)) return;
+    glDepthFunc(func);
+}
+
+GLenum GLState::getDepthFunc() {
+    if (shadow.depthFunc != 0) {
+        ++shadow.stats.queriesServed;
+        return shadow.depthFunc;
+    }
+    ++shadow.stats.queriesIssued;
+    GLint func = GL_LESS;
+    glGetIntegerv(GL_DEPTH_FUNC, &func);
+    shadow.depthFunc = GLenum(func);
+    return shadow.depthFunc;
+}
+
+void GLState::depthMask(bool write) {
+    if (unchanged(shadow.depthMask, Tristate(write))) return;
+    glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+bool GLState::getDepthMask() {
+    if (shadow.depthMask >= 0) {
+        ++shadow.stats.queriesServed;
+        return shadow.depthMask != 0;
+    }
+    ++shadow.stats.queriesIssued;
+    GLboolean write = GL_TRUE;
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &write);
+    shadow.depthMask = write == GL_TRUE;
+    return shadow.depthMask != 0;
+}
+
+void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    GLint* v = shadow.viewport;
+    if (shadow.viewportKnown && v[0] == x && v[1] == y && v[2] == width && v[3] == height) {
+        ++shadow.stats.skipped;
+        return;
+    }
+    ++shadow.stats.issued;
+    v[0] = x; v[1] = y; v[2] = width; v[3] = height;
+    shadow.viewportKnown = true;
+    glViewport(x, y, width, height);
+}
+
+void GLState::getViewport(GLint out[4]) {
+    if (shadow.viewportKnown) {
+        ++shadow.stats.queriesServed;
+    }
+    else {
+        ++shadow.stats.queriesIssued;
+        glGetIntegerv(GL_VIEWPORT, shadow.viewport);
+        shadow.viewportKnown = true;
+    }
+    for (int i = 0; i < 4; ++i) out[i] = shadow.viewport[i];
+}
+
+void GLState::deleteProgram(GLuint program) {
+    bumpShared();
+    // a deleted program stays in use until replaced, re-learn it
+    if (shadow.program == program) shadow.program = UNKNOWN;
+    glDeleteProgram(program);
+}
+
+void GLState::deleteVertexArray(GLuint vertexArray) {
+    if (shadow.vertexArray == vertexArray) {
+        shadow.vertexArray = 0;
+        shadow.buffers[bufferIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+    }
+    glDeleteVertexArrays(1, &vertexArray);
+}
+
+void GLState::deleteBuffer(GLuint buffer) {
+    bumpShared();
+    for (auto& b : shadow.buffers)
+        if (b == buffer) b = 0;
+    glDeleteBuffers(1, &buffer);
+}
+
+void GLState::deleteTexture(GLuint texture) {
+    bumpShared();
+    for (auto& unit : shadow.textures)
+        for (auto& t : unit)
+            if (t == texture) t = 0;
+    glDeleteTextures(1, &texture);
+}
+
+void GLState::deleteFramebuffer(GLuint framebuffer) {
+    if (shadow.framebuffer == framebuffer) shadow.framebuffer = 0;
+    glDeleteFramebuffers(1, &framebuffer);
+}
+
+void GLState::invalidate() {
+    shadow.forget();
+}
+
+GLStateStats GLState::getStats() {
+    return shadow.stats;
+}
+
+void GLState::resetStats() {
+    shadow.stats = GLStateStats();
+}
@@ -0,0 +1,255 @@
+#include "engine/GeometryArena.h"
+#include "engine/GLState.h"
+#include <algorithm>
+#include <iostream>
+#include <cstdint>
+
+namespace {
+
+    // compaction kicks in once freed holes exceed half of the used range (and 1 MB)
+    const size_t COMPACT_MIN_WASTE = 1u << 20;
+
+    std::vector<std::unique_ptr<GeometryArena>>& sharedArenas() {
+        static std::vector<std::unique_ptr<GeometryArena>> arenas;
+        return arenas;
+    }
+
+    // GPU side copy between two buffers, without touching the VAO's element binding
+    void copyBuffer(GLuint src, GLuint dst, size_t srcOffset, size_t dstOffset, size_t size) {
+        if (size == 0) return;
+        GLState::bindBuffer(GL_COPY_READ_BUFFER, src);
+        GLState::bindBuffer(GL_COPY_WRITE_BUFFER, dst);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+            static_cast<GLintptr>(srcOffset), static_cast<GLintptr>(dstOffset), static_cast<GLsizeiptr>(size));
+    }
+
+    void uploadRange(GLuint buffer, size_t offset, const void* data, size_t size) {
+        if (size == 0) return;
+        GLState::bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+    }
+
+} // namespace
+
+GeometryArena::GeometryArena(const VertexFormat& vertexFormat,
+    size_t initialVertexBytes, size_t initialIndexBytes)
+    : format(vertexFormat), stride(vertexFormat.stride()) {
+    vertexSpace.capacity = initialVertexBytes / stride * stride;
+    indexSpace.capacity = (initialIndexBytes + 3) & ~size_t(3);
+    vbo = std::make_unique<VBO>(static_cast<const void*>(nullptr), vertexSpace.capacity);
+    ebo = std::make_unique<EBO>(nullptr, indexSpace.capacity / sizeof(GLuint));
+    setupVertexArray();
+}
+
+GeometryArena::~GeometryArena() {
+    // vao deletes itself through GLState, dropping the binding if current
+}
+
+GeometryArena& GeometryArena::forFormat(const VertexFormat& format) {
+    auto& arenas = sharedArenas();
+    for (auto& arena : arenas) {
+        if (arena->format == format) return *arena;
+    }
+    arenas.push_back(std::make_unique<GeometryArena>(format));
+    return *arenas.back();
+}
+
+void GeometryArena::destroyAll() {
+    sharedArenas().clear();
+}
+
+void GeometryArena::setupVertexArray() {
+    vao = std::make_unique<VAO>();
+    vao->Bind();
+    ebo->Bind(); // stored in the vao
+    format.link(*vao, *vbo);
+    vao->Unbind();
+}
+
+size_t GeometryArena::takeRange(Space& space, size_t size) {
+    // first fit in the free-list
+    for (size_t i = 0; i < space.freeList.size(); ++i) {
+        Range& r = space.freeList[i];
+        if (r.size < size) continue;
+        size_t offset = r.offset;
+        r.offset += size;
+        r.size -= size;
+        if (r.size == 0) space.freeList.erase(space.freeList.begin() + i);
+        space.freeBytes -= size;
+        return offset;
+    }
+    // otherwise bump the top
+    if (space.top + size > space.capacity) return SIZE_MAX;
+    size_t offset = space.top;
+    space.top += size;
+    return offset;
+}
+
+void GeometryArena::giveRange(Space& space, size_t offset, size_t size) {
+    if (size == 0) return;
+
+    // a block at the top just lowers it, along with a free range now ending there
+    if (offset + size == space.top) {
+        space.top = offset;
+        if (!space.freeList.empty()) {
+            Range& last = space.freeList.back();
+            if (last.offset + last.size == space.top) {
+                space.top = last.offset;
+                space.freeBytes -= last.size;
+                space.freeList.pop_back();
+            }
+        }
+        return;
+    }
+
+    // insert sorted and merge with neighbours
+    auto it = std::lower_bound(space.freeList.begin(), space.freeList.end(), offset,
+        [](const Range& r, size_t o) { return r.offset < o; });
+    it = space.freeList.insert(it, { offset, size });
+    space.freeBytes += size;
+    if (it + 1 != space.freeList.end() && it->offset + it->size == (it + 1)->offset) {
+        it->size += (it + 1)->size;
+        space.freeList.erase(it + 1);
+    }
+    if (it != space.freeList.begin() && (it - 1)->offset + (it - 1)->size == it->offset) {
+        (it - 1)->size += it->size;
+        space.freeList.erase(it);
+    }
+}
+
+void GeometryArena::growVertices(size_t minCapacity) {
+    size_t capacity = std::max(vertexSpace.capacity * 2, minCapacity);
+    capacity = (capacity + stride - 1) / stride * stride;
+
+    auto larger = std::make_unique<VBO>(static_cast<const void*>(nullptr), capacity);
+    copyBuffer(vbo->ID, larger->ID, 0, 0, vertexSpace.top);
+    vbo = std::move(larger);
+    vertexSpace.capacity = capacity;
+    ++growths;
+    setupVertexArray();
+    std::cout << "[GeometryArena] Vertex buffer grown to " << (capacity >> 10) << " KB\n";
+}
+
+void GeometryArena::growIndices(size_t minCapacity) {
+    size_t capacity = std::max(indexSpace.capacity * 2, minCapacity);
+    capacity = (capacity + 3) & ~size_t(3);
+
+    auto larger = std::make_unique<EBO>(nullptr, capacity / sizeof(GLuint));
+    copyBuffer(ebo->ID, larger->ID, 0, 0, indexSpace.top);
+    ebo = std::move(larger);
+    indexSpace.capacity = capacity;
+    ++growths;
+    setupVertexArray();
+    std::cout << "[GeometryArena] Index buffer grown to " << (capacity >> 10) << " KB\n";
+}
+
+GeometryHandle GeometryArena::allocate(const void* vertexData, size_t vertexCount,
+    const void* indexData, size_t indexBytes) {
+    GeometryBlock block;
+    block.vertexBytes = vertexCount * stride;
+    block.indexBytes = indexBytes;
+    size_t indexSpan = (indexBytes + 3) & ~size_t(3);
+
+    block.vertexOffset = takeRange(vertexSpace, block.vertexBytes);
+    if (block.vertexOffset == SIZE_MAX) {
+        growVertices(vertexSpace.top + block.vertexBytes);
+        block.vertexOffset = takeRange(vertexSpace, block.vertexBytes);
+    }
+    block.indexOffset = takeRange(indexSpace, indexSpan);
+    if (block.indexOffset == SIZE_MAX) {
+        growIndices(indexSpace.top + indexSpan);
+        block.indexOffset = takeRange(indexSpace, indexSpan);
+    }
+
+    uploadRange(vbo->ID, block.vertexOffset, vertexData, block.vertexBytes);
+    uploadRange(ebo->ID, block.indexOffset, indexData, indexBytes);
+    block.live = true;
+
+    GeometryHandle handle;
+    if (!freeHandles.empty()) {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+        blocks[handle] = block;
+    }
+    else {
+        handle = static_cast<GeometryHandle>(blocks.size());
+        blocks.push_back(block);
+    }
+    return handle;
+}
+
+void GeometryArena::release(GeometryHandle handle) {
+    if (handle >= blocks.size() || !blocks[handle].live) return;
+    GeometryBlock& block = blocks[handle];
+    giveRange(vertexSpace, block.vertexOffset, block.vertexBytes);
+    giveRange(indexSpace, block.indexOffset, (block.indexBytes + 3) & ~size_t(3));
+    block = GeometryBlock();
+    freeHandles.push_back(handle);
+
+    size_t waste = vertexSpace.freeBytes + indexSpace.freeBytes;
+    size_t used = vertexSpace.top + indexSpace.top;
+    if (waste > COMPACT_MIN_WASTE && waste * 2 > used) compact();
+}
+
+void GeometryArena::compact() {
+    // live blocks in buffer order, so every move goes downwards
+    std::vector<GeometryHandle> order;
+    for (GeometryHandle h = 0; h < blocks.size(); ++h) {
+        if (blocks[h].live) order.push_back(h);
+    }
+
+    // pack into fresh buffers, overlapping copies inside one buffer are undefined
+    std::sort(order.begin(), order.end(), [&](GeometryHandle a, GeometryHandle b) {
+        return blocks[a].vertexOffset < blocks[b].vertexOffset; });
+    auto packedVbo = std::make_unique<VBO>(static_cast<const void*>(nullptr), vertexSpace.capacity);
+    size_t vertexTop = 0;
+    for (GeometryHandle h : order) {
+        GeometryBlock& b = blocks[h];
+        copyBuffer(vbo->ID, packedVbo->ID, b.vertexOffset, vertexTop, b.vertexBytes);
+        b.vertexOffset = vertexTop;
+        vertexTop += b.vertexBytes;
+    }
+
+    std::sort(order.begin(), order.end(), [&](GeometryHandle a, GeometryHandle b) {
+        return blocks[a].indexOffset < blocks[b].indexOffset; });
+    auto packedEbo = std::make_unique<EBO>(nullptr, indexSpace.capacity / sizeof(GLuint));
+    size_t indexTop = 0;
+    for (GeometryHandle h : order) {
+        GeometryBlock& b = blocks[h];
+        size_t span = (b.indexBytes + 3) & ~size_t(3);
+        copyBuffer(ebo->ID, packedEbo->ID, b.indexOffset, indexTop, span);
+        b.indexOffset = indexTop;
+        indexTop += span;
+    }
+
+    vbo = std::move(packedVbo);
+    ebo = std::move(packedEbo);
+    vertexSpace.top = vertexTop;
+    vertexSpace.freeList.clear();
+    vertexSpace.freeBytes = 0;
+    indexSpace.top = indexTop;
+    indexSpace.freeList.clear();
+    indexSpace.freeBytes = 0;
+    ++compactions;
+    setupVertexArray();
+}
+
+GeometryArenaStats GeometryArena::getStats() const {
+    GeometryArenaStats stats;
+    stats.vertexCapacity = vertexSpace.capacity;
+    stats.vertexUsed = vertexSpace.top - vertexSpace.freeBytes;
+    stats.indexCapacity = indexSpace.capacity;
+    stats.indexUsed = indexSpace.top - indexSpace.freeBytes;
+    stats.allocations = blocks.size() - freeHandles.size();
+    stats.growths = growths;
+    stats.compactions = compactions;
+    return stats;
+}
+
+void GeometryArena::Bind() {
+    vao->Bind();
+}
+
+void GeometryArena::Unbind() {
+    GLState::bindVertexArray(0);
+}
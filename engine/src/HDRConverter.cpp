@@ -2,6 +2,7 @@
 #include "engine/Shader.h"
 #include "engine/HDRTexture.h"
 #include "engine/Cubemap.h"
+#include "engine/GLState.h"
 #include <glm/gtc/matrix_transform.hpp>
 
 #ifndef ENGINE_SHADER_DIR
@@ -19,14 +20,14 @@ HDRConverter::HDRConverter(int cubemapSize) : size(cubemapSize) {
 
 HDRConverter::~HDRConverter() {
 	if (shader) delete shader;
-	if (fbo) glDeleteFramebuffers(1, &fbo);
+	if (fbo) GLState::deleteFramebuffer(fbo);
 	if (rbo) glDeleteRenderbuffers(1, &rbo);
 }
 
 void HDRConverter::initFramebuffer() {
 	// Create framebuffer
 	glGenFramebuffers(1, &fbo);
-	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	GLState::bindFramebuffer(fbo);
 	// Create renderbuffer for depth testing
 	glGenRenderbuffers(1, &rbo);
 	glBindRenderbuffer(GL_RENDERBUFFER, rbo);
@@ -34,7 +35,7 @@ void HDRConverter::initFramebuffer() {
 	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
 	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rbo);
 	// Unbind
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::bindFramebuffer(0);
 }
 
 void HDRConverter::initMatrices() {
@@ -81,8 +82,8 @@ static void renderCube() {
 		glGenVertexArrays(1, &cubeVAO);
 		glGenBuffers(1, &cubeVBO);
 
-		glBindVertexArray(cubeVAO);
-		glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+		GLState::bindVertexArray(cubeVAO);
+		GLState::bindBuffer(GL_ARRAY_BUFFER, cubeVBO);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
 		// Only position attribute
@@ -90,20 +91,20 @@ static void renderCube() {
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 	}
 
-	glBindVertexArray(cubeVAO);
+	GLState::bindVertexArray(cubeVAO);
 	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
+	GLState::bindVertexArray(0);
 }
 
 void HDRConverter::convert(const HDRTexture& src, Cubemap& dst) {
 	// Render into cubemap resolution
 	GLint prevViewport[4];
-	glGetIntegerv(GL_VIEWPORT, prevViewport);
-	glViewport(0, 0, size, size);
+	GLState::getViewport(prevViewport);
+	GLState::viewport(0, 0, size, size);
 	// Bind framebuffer to render offscreen
-	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-	GLboolean wasCulling = glIsEnabled(GL_CULL_FACE);
-	glDisable(GL_CULL_FACE);
+	GLState::bindFramebuffer(fbo);
+	bool wasCulling = GLState::isEnabled(GL_CULL_FACE);
+	GLState::setEnabled(GL_CULL_FACE, false);
 	// Bind shader and set uniforms
 	shader->Activate();
 	shader->setInt("eqrMap", 0);
@@ -122,12 +123,11 @@ void HDRConverter::convert(const HDRTexture& src, Cubemap& dst) {
 		renderCube();
 	}
 	// Restore default framebuffer
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	if (wasCulling) glEnable(GL_CULL_FACE);
-	else glDisable(GL_CULL_FACE);
+	GLState::bindFramebuffer(0);
+	GLState::setEnabled(GL_CULL_FACE, wasCulling);
 	// Generate mipmaps for smoother reflections/refractions
-	glBindTexture(GL_TEXTURE_CUBE_MAP, dst.ID);
+	GLState::bindTexture(GL_TEXTURE_CUBE_MAP, dst.ID);
 	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 	// Restore previous state
-	glViewport(prevViewport[0], prevViewport[1], prevViewport[2], prevViewport[3]);
+	GLState::viewport(prevViewport[0], prevViewport[1], prevViewport[2], prevViewport[3]);
 }
\ No newline at end of file
@@ -0,0 +1,360 @@
+#include "engine/HDRDecoder.h"
+#include "engine/ThreadPool.h"
+#include <glm/gtc/packing.hpp>
+#include <stb_image.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ENGINE_HDR_SSE 1
+#endif
+
+namespace {
+
+    const size_t READ_BUFFER_BYTES = 256 * 1024;
+    const size_t MAX_HEADER_LINE = 4096;
+    // largest finite half, brighter texels clamp to it instead of turning into inf
+    const float HALF_MAX = 65504.0f;
+    const uint16_t HALF_ONE = 0x3C00;
+
+    double msSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // 2^(e - 136) as stb_image scales the 8-bit mantissas, 0 below the float range
+    float exponentScale(uint8_t e) {
+        if (e < 10) return 0.0f;
+        uint32_t bits = uint32_t(e - 9) << 23;
+        float scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+        return scale;
+    }
+
+    // Round to nearest even, for non-negative values up to HALF_MAX. Same steps
+    // as the SSE2 path so both produce the same bits.
+    uint16_t floatToHalf(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        if (bits < (113u << 23)) {
+            // subnormal half: adding 0.5 lines the mantissa up with 2^-24 steps
+            float shifted = value + 0.5f;
+            std::memcpy(&bits, &shifted, sizeof(bits));
+            return uint16_t(bits - (126u << 23));
+        }
+        uint32_t odd = (bits >> 13) & 1u;
+        bits += 0xFFFu - (112u << 23) + odd;
+        return uint16_t(bits >> 13);
+    }
+
+#ifdef ENGINE_HDR_SSE
+    // 4 non-negative floats (<= HALF_MAX) to halves in the low 16 bits of each lane
+    __m128i floatToHalf4(__m128 value) {
+        const __m128i bits = _mm_castps_si128(value);
+        const __m128i isSubnormal = _mm_cmpgt_epi32(_mm_set1_epi32(113 << 23), bits);
+
+        __m128 shifted = _mm_add_ps(value, _mm_castsi128_ps(_mm_set1_epi32(126 << 23)));
+        __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(shifted), _mm_set1_epi32(126 << 23));
+
+        __m128i odd = _mm_srai_epi32(_mm_slli_epi32(bits, 31 - 13), 31);
+        __m128i rounded = _mm_sub_epi32(_mm_add_epi32(bits, _mm_set1_epi32(0xFFF - (112 << 23))), odd);
+        __m128i normal = _mm_srli_epi32(rounded, 13);
+
+        return _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+    }
+
+    // One RGBE pixel (mantissas and exponent widened to 32 bits) to RGB floats, alpha 1
+    __m128 rgbeToFloat4(__m128i pixel) {
+        const __m128i e = _mm_shuffle_epi32(pixel, _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i scaleBits = _mm_slli_epi32(_mm_sub_epi32(e, _mm_set1_epi32(9)), 23);
+        scaleBits = _mm_and_si128(scaleBits, _mm_cmpgt_epi32(e, _mm_set1_epi32(9)));
+        __m128 color = _mm_mul_ps(_mm_cvtepi32_ps(pixel), _mm_castsi128_ps(scaleBits));
+        color = _mm_min_ps(color, _mm_set1_ps(HALF_MAX));
+        const __m128 rgbMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+        return _mm_or_ps(_mm_and_ps(rgbMask, color), _mm_andnot_ps(rgbMask, _mm_set1_ps(1.0f)));
+    }
+#endif
+
+} // namespace
+
+HDRDecoder::~HDRDecoder() {
+    close();
+}
+
+bool HDRDecoder::open(const std::string& path) {
+    close();
+    file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        std::cerr << "[HDRDecoder] Cannot open " << path << "\n";
+        return false;
+    }
+    buffer.resize(READ_BUFFER_BYTES);
+
+    std::string line;
+    if (!readLine(line) || line.compare(0, 2, "#?") != 0) {
+        std::cerr << "[HDRDecoder] Not a Radiance file: " << path << "\n";
+        close();
+        return false;
+    }
+    // header variables up to an empty line, only FORMAT matters
+    while (readLine(line) && !line.empty()) {
+        if (line.compare(0, 7, "FORMAT=") == 0 && line != "FORMAT=32-bit_rle_rgbe") {
+            std::cerr << "[HDRDecoder] Unsupported " << line << " in " << path << "\n";
+            close();
+            return false;
+        }
+    }
+
+    char yAxis[3] = {}, xAxis[3] = {};
+    if (!readLine(line) || std::sscanf(line.c_str(), "%2s %d %2s %d", yAxis, &height, xAxis, &width) != 4
+        || std::strcmp(xAxis, "+X") != 0 || (std::strcmp(yAxis, "-Y") != 0 && std::strcmp(yAxis, "+Y") != 0)
+        || width <= 0 || height <= 0) {
+        std::cerr << "[HDRDecoder] Unsupported resolution line \"" << line << "\" in " << path << "\n";
+        close();
+        return false;
+    }
+    bottomUp = yAxis[0] == '+';
+    row = 0;
+    return true;
+}
+
+void HDRDecoder::close() {
+    if (file) std::fclose(file);
+    file = nullptr;
+    position = available = 0;
+    width = height = row = 0;
+}
+
+bool HDRDecoder::refill() {
+    if (!file) return false;
+    available = std::fread(buffer.data(), 1, buffer.size(), file);
+    position = 0;
+    return available > 0;
+}
+
+bool HDRDecoder::readBytes(uint8_t* out, size_t count) {
+    while (count > 0) {
+        if (position == available && !refill()) return false;
+        size_t n = std::min(count, available - position);
+        std::memcpy(out, buffer.data() + position, n);
+        position += n;
+        out += n;
+        count -= n;
+    }
+    return true;
+}
+
+bool HDRDecoder::readLine(std::string& line) {
+    line.clear();
+    for (int c = nextByte(); c != '\n'; c = nextByte()) {
+        if (c < 0 || line.size() >= MAX_HEADER_LINE) return false;
+        if (c != '\r') line.push_back(char(c));
+    }
+    return true;
+}
+
+bool HDRDecoder::readScanline(uint8_t* rgbe) {
+    if (!file || row >= height) return false;
+    uint8_t first[4];
+    if (!readBytes(first, 4)) return false;
+
+    // RLE scanlines start with 2, 2 and the width, channel by channel after that
+    bool runLength = width >= 8 && width < 32768 && first[0] == 2 && first[1] == 2 && (first[2] & 0x80) == 0;
+    if (runLength && ((first[2] << 8) | first[3]) != width) {
+        std::cerr << "[HDRDecoder] Scanline " << row << " has the wrong width\n";
+        return false;
+    }
+    bool ok = runLength ? readRunLength(rgbe) : readFlat(rgbe, first);
+    if (!ok) {
+        std::cerr << "[HDRDecoder] Truncated or corrupt scanline " << row << "\n";
+        return false;
+    }
+    ++row;
+    return true;
+}
+
+bool HDRDecoder::readRunLength(uint8_t* rgbe) {
+    for (int channel = 0; channel < 4; ++channel) {
+        int x = 0;
+        while (x < width) {
+            int count = nextByte();
+            if (count < 0) return false;
+            if (count > 128) {
+                // run of one value
+                count -= 128;
+                int value = nextByte();
+                if (value < 0 || count > width - x) return false;
+                for (int i = 0; i < count; ++i, ++x) rgbe[size_t(x) * 4 + channel] = uint8_t(value);
+            }
+            else {
+                // literal values
+                if (count == 0 || count > width - x) return false;
+                for (int i = 0; i < count; ++i, ++x) {
+                    int value = nextByte();
+                    if (value < 0) return false;
+                    rgbe[size_t(x) * 4 + channel] = uint8_t(value);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool HDRDecoder::readFlat(uint8_t* rgbe, const uint8_t first[4]) {
+    std::memcpy(rgbe, first, 4);
+    int x = 1, shift = 0;
+    uint8_t pixel[4];
+    while (x < width) {
+        if (!readBytes(pixel, 4)) return false;
+        if (pixel[0] == 1 && pixel[1] == 1 && pixel[2] == 1) {
+            // old style run: repeat the previous pixel, consecutive runs stack up
+            size_t count = shift < 24 ? size_t(pixel[3]) << shift : size_t(width);
+            count = std::min(count, size_t(width - x));
+            for (size_t i = 0; i < count; ++i, ++x)
+                std::memcpy(rgbe + size_t(x) * 4, rgbe + size_t(x - 1) * 4, 4);
+            shift += 8;
+        }
+        else {
+            std::memcpy(rgbe + size_t(x) * 4, pixel, 4);
+            ++x;
+            shift = 0;
+        }
+    }
+    return true;
+}
+
+void HDRDecoder::toHalf(const uint8_t* rgbe, uint16_t* rgba, size_t count) {
+    size_t i = 0;
+#ifdef ENGINE_HDR_SSE
+    // 4 pixels per step: 16 bytes in, 32 bytes of halves out
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgbe + i * 4));
+        __m128i low = _mm_unpacklo_epi8(pixels, zero);
+        __m128i high = _mm_unpackhi_epi8(pixels, zero);
+        __m128i h0 = floatToHalf4(rgbeToFloat4(_mm_unpacklo_epi16(low, zero)));
+        __m128i h1 = floatToHalf4(rgbeToFloat4(_mm_unpackhi_epi16(low, zero)));
+        __m128i h2 = floatToHalf4(rgbeToFloat4(_mm_unpacklo_epi16(high, zero)));
+        __m128i h3 = floatToHalf4(rgbeToFloat4(_mm_unpackhi_epi16(high, zero)));
+        // halves never exceed 0x7BFF, the signed saturating pack keeps them intact
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4), _mm_packs_epi32(h0, h1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4 + 8), _mm_packs_epi32(h2, h3));
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint8_t* p = rgbe + i * 4;
+        float scale = exponentScale(p[3]);
+        for (int c = 0; c < 3; ++c)
+            rgba[i * 4 + c] = floatToHalf(std::min(float(p[c]) * scale, HALF_MAX));
+        rgba[i * 4 + 3] = HALF_ONE;
+    }
+}
+
+void HDRDecoder::toRGB9E5(const uint8_t* rgbe, uint32_t* out, size_t count) {
+    // m * 2^(e - 136) == (2m) * 2^((e - 113) - 24): the shared exponent only
+    // moves, integer work that needs no SIMD
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* p = rgbe + i * 4;
+        if (p[3] == 0) {
+            out[i] = 0;
+            continue;
+        }
+        uint32_t m[3] = { uint32_t(p[0]) << 1, uint32_t(p[1]) << 1, uint32_t(p[2]) << 1 };
+        int e = int(p[3]) - 113;
+        if (e > 31) {
+            // too bright: saturate at the largest exponent
+            int shift = e - 31;
+            for (uint32_t& v : m) v = (shift >= 9 || (v << shift) > 511u) ? (v ? 511u : 0u) : v << shift;
+            e = 31;
+        }
+        else if (e < 0) {
+            // too dark: denormalize towards the smallest exponent
+            int shift = -e;
+            for (uint32_t& v : m) v = shift >= 10 ? 0u : v >> shift;
+            e = 0;
+        }
+        out[i] = m[0] | (m[1] << 9) | (m[2] << 18) | (uint32_t(e) << 27);
+    }
+}
+
+void HDRDecoder::toFloat(const uint8_t* rgbe, float* rgb, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* p = rgbe + i * 4;
+        float scale = exponentScale(p[3]);
+        rgb[i * 3 + 0] = float(p[0]) * scale;
+        rgb[i * 3 + 1] = float(p[1]) * scale;
+        rgb[i * 3 + 2] = float(p[2]) * scale;
+    }
+}
+
+HDRDecodeBenchmark HDRDecoder::benchmark(const std::string& path, int bandRows) {
+    HDRDecodeBenchmark result;
+    bandRows = std::max(1, bandRows);
+
+    // what HDRTexture used to do: the whole image as floats, then halves
+    auto start = std::chrono::steady_clock::now();
+    int width, height, channels;
+    stbi_set_flip_vertically_on_load_thread(1);
+    float* data = stbi_loadf(path.c_str(), &width, &height, &channels, 3);
+    if (!data) {
+        std::cerr << "[HDRDecoder] Failed to load " << path << ": " << stbi_failure_reason() << "\n";
+        return result;
+    }
+    const size_t values = size_t(width) * height * 3;
+    std::vector<uint16_t> halves(values);
+    for (size_t i = 0; i < values; ++i) halves[i] = glm::packHalf1x16(data[i]);
+    result.stbMs = msSince(start);
+    result.stbPeakBytes = values * sizeof(float) + values * sizeof(uint16_t);
+    std::vector<uint16_t>().swap(halves);
+    result.width = width;
+    result.height = height;
+
+    // streamed, one band at a time converted on the pool; with compare every
+    // row is checked against stb's floats (meant for an untimed pass)
+    auto stream = [&](HDRPixelFormat format, bool compare) -> double {
+        HDRDecoder decoder;
+        if (!decoder.open(path) || decoder.getWidth() != width || decoder.getHeight() != height) return -1.0;
+        auto begin = std::chrono::steady_clock::now();
+        const size_t rowPixels = size_t(width);
+        const size_t rowBytes = rowPixels * (format == HDRPixelFormat::Half ? 8 : 4);
+        std::vector<uint8_t> rgbe(rowPixels * 4 * bandRows);
+        std::vector<uint8_t> converted(rowBytes * bandRows);
+        result.streamPeakBytes = rgbe.size() + converted.size();
+        for (int first = 0; first < height; first += bandRows) {
+            const int rows = std::min(bandRows, height - first);
+            for (int r = 0; r < rows; ++r)
+                if (!decoder.readScanline(rgbe.data() + size_t(r) * rowPixels * 4)) return -1.0;
+            ThreadPool::shared().parallelFor(size_t(rows), [&](size_t r) {
+                const uint8_t* in = rgbe.data() + r * rowPixels * 4;
+                uint8_t* out = converted.data() + r * rowBytes;
+                if (format == HDRPixelFormat::Half) toHalf(in, reinterpret_cast<uint16_t*>(out), rowPixels);
+                else toRGB9E5(in, reinterpret_cast<uint32_t*>(out), rowPixels);
+            });
+            if (!compare || decoder.isBottomUp()) continue;
+            for (int r = 0; r < rows; ++r) {
+                // stb flips top-down files, so file row y is row height - 1 - y
+                const float* reference = data + size_t(height - 1 - (first + r)) * rowPixels * 3;
+                const uint16_t* half = reinterpret_cast<const uint16_t*>(converted.data() + size_t(r) * rowBytes);
+                for (size_t x = 0; x < rowPixels; ++x) {
+                    for (int c = 0; c < 3; ++c) {
+                        float expected = std::min(reference[x * 3 + c], HALF_MAX);
+                        float actual = glm::unpackHalf1x16(half[x * 4 + c]);
+                        // relative, with the smallest normal half as the floor
+                        double error = std::fabs(double(actual) - expected) / std::max(double(expected), 6.1e-5);
+                        result.maxRelativeError = std::max(result.maxRelativeError, error);
+                    }
+                }
+            }
+        }
+        return msSince(begin);
+    };
+    result.halfMs = stream(HDRPixelFormat::Half, false);
+    result.rgb9e5Ms = stream(HDRPixelFormat::RGB9E5, false);
+    stream(HDRPixelFormat::Half, true);
+
+    stbi_image_free(data);
+    return result;
+}
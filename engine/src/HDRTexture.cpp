@@ -1,28 +1,40 @@
 #include "engine/HDRTexture.h"
+#include "engine/GLState.h"
+#include "engine/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
-#include <stb_image.h>
 #include <filesystem>
+#include <vector>
 
 
-HDRTexture::HDRTexture(const std::string& path) {
+HDRTexture::HDRTexture(const std::string& path, const HDRLoadOptions& options) {
 	// Load the HDR image data from file
 	std::cout << "[HDRTexture] trying path: " << path << "\n";
 	std::cout << "[HDRTexture] cwd: " << std::filesystem::current_path().string() << "\n";
-	// Flips the image so it appears right side up
-	int width, height, channels;
-	stbi_set_flip_vertically_on_load(true);
-	float* data = stbi_loadf(path.c_str(), &width, &height, &channels, 0);
-	if (!data) {
+	auto start = std::chrono::steady_clock::now();
+	HDRDecoder decoder;
+	if (!decoder.open(path)) {
 		std::cerr << "Failed to load HDR texture: " << path << std::endl;
-		std::cerr << "stbi reason: " << stbi_failure_reason() << "\n";
 		ID = 0;
 		return;
 	}
+	width = decoder.getWidth();
+	height = decoder.getHeight();
+
+	// Half floats (alpha dropped by the internal format) or the packed shared exponent
+	const bool half = options.format == HDRPixelFormat::Half;
+	internalFormat = half ? GL_RGB16F : GL_RGB9_E5;
+	const GLenum format = half ? GL_RGBA : GL_RGB;
+	const GLenum type = half ? GL_HALF_FLOAT : GL_UNSIGNED_INT_5_9_9_9_REV;
+	const size_t rowPixels = static_cast<size_t>(width);
+	const size_t rowBytes = rowPixels * (half ? 4 * sizeof(uint16_t) : sizeof(uint32_t));
+	const int bandRows = std::max(1, std::min(options.bandRows, height));
 
-	
 	// Generates an OpenGL texture object
 	glGenTextures(1, &ID);
-	glBindTexture(GL_TEXTURE_2D, ID);
+	GLState::bindTexture(GL_TEXTURE_2D, ID);
 
 	// Configures the type of algorithm that is used to make the image smaller or bigger
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -32,15 +44,58 @@ HDRTexture::HDRTexture(const std::string& path) {
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-	// Upload the HDR image data to the texture
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, data);
+	// Storage only, the bands fill it in
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+
+	// One pixel unpack buffer, invalidated per band so the driver can keep
+	// copying the previous band while the next one is decoded
+	GLuint pbo = 0;
+	glGenBuffers(1, &pbo);
+	GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, rowBytes * bandRows, nullptr, GL_STREAM_DRAW);
+
+	std::vector<uint8_t> rgbe(rowPixels * 4 * bandRows);
+	bool ok = true;
+	for (int first = 0; first < height && ok; first += bandRows) {
+		const int rows = std::min(bandRows, height - first);
+		for (int r = 0; r < rows && ok; ++r)
+			ok = decoder.readScanline(rgbe.data() + size_t(r) * rowPixels * 4);
+		if (!ok) break;
+
+		uint8_t* mapped = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+			GLsizeiptr(rowBytes * rows), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+		if (!mapped) {
+			ok = false;
+			break;
+		}
+		// Texture rows are bottom-up: flip top-down files inside the band
+		ThreadPool::shared().parallelFor(size_t(rows), [&](size_t r) {
+			const uint8_t* in = rgbe.data() + r * rowPixels * 4;
+			size_t target = decoder.isBottomUp() ? r : size_t(rows) - 1 - r;
+			uint8_t* out = mapped + target * rowBytes;
+			if (half) HDRDecoder::toHalf(in, reinterpret_cast<uint16_t*>(out), rowPixels);
+			else HDRDecoder::toRGB9E5(in, reinterpret_cast<uint32_t*>(out), rowPixels);
+		});
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+		int y = decoder.isBottomUp() ? first : height - first - rows;
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, width, rows, format, type, nullptr);
+	}
 
-	// Free the image data
-	stbi_image_free(data);
-	std::cout << "[HDRTexture] Loaded " << path << "\n";
+	// Unbind before anyone else uploads from client memory
+	GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	GLState::deleteBuffer(pbo);
+	if (!ok) {
+		std::cerr << "Failed to load HDR texture: " << path << std::endl;
+		GLState::deleteTexture(ID);
+		ID = 0;
+		return;
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "[HDRTexture] Loaded " << path << " (" << width << "x" << height << ", "
+		<< (half ? "RGB16F" : "RGB9_E5") << ") in " << ms << " ms\n";
 }
 
 void HDRTexture::Bind(GLuint unit) const {
-    glActiveTexture(GL_TEXTURE0 + unit);
-    glBindTexture(GL_TEXTURE_2D, ID);
+    GLState::bindTexture(unit, GL_TEXTURE_2D, ID);
 }
\ No newline at end of file
@@ -0,0 +1,486 @@
+#include "engine/IBLBaker.h"
+#include "engine/ThreadPool.h"
+#include <glm/gtc/packing.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+namespace fs = std::filesystem;
+
+namespace {
+
+    const int ROWS_PER_TASK = 8;
+    // SH projection runs on the first environment level no larger than this
+    const int SH_MAX_SIZE = 64;
+    const float PI = 3.14159265f;
+    const char MAGIC[4] = { 'E', 'I', 'B', 'L' };
+
+    // On-disk layout: header, 27 SH floats, prefiltered faces (RGB halves
+    // per level and face), then the LUT (RG halves)
+    struct FileHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t sourceHash;
+        uint32_t environmentSize;
+        uint32_t environmentSupersample;
+        uint32_t specularSize;
+        uint32_t requestedLevels;   // options.specularLevels
+        uint32_t specularSamples;
+        uint32_t lutSize;
+        uint32_t lutSamples;
+        uint32_t specularLevels;    // levels actually stored, small faces have fewer
+    };
+
+    uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    double msSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Environment unpacked to floats, bilinear within a face, linear between levels
+    struct FloatCube {
+        int size = 0;
+        int levels = 0;
+        std::vector<std::vector<float>> faces; // [level * 6 + face]
+
+        explicit FloatCube(const CubemapImage& image) : size(image.size), levels(image.levels), faces(image.faces.size()) {
+            ThreadPool::shared().parallelFor(faces.size(), [&](size_t i) {
+                const std::vector<uint16_t>& halves = image.faces[i];
+                faces[i].resize(halves.size());
+                for (size_t j = 0; j < halves.size(); ++j) faces[i][j] = glm::unpackHalf1x16(halves[j]);
+            });
+        }
+
+        int levelSize(int level) const { return std::max(1, size >> level); }
+
+        void sampleLevel(int level, int face, float u, float v, float* out) const {
+            const int s = levelSize(level);
+            const float* texels = faces[size_t(level) * 6 + face].data();
+            // seams clamp to the face edge instead of blending across faces
+            float x = std::min(std::max((u + 1.0f) * 0.5f * s - 0.5f, 0.0f), float(s - 1));
+            float y = std::min(std::max((v + 1.0f) * 0.5f * s - 0.5f, 0.0f), float(s - 1));
+            int x0 = int(x), y0 = int(y);
+            int x1 = std::min(x0 + 1, s - 1), y1 = std::min(y0 + 1, s - 1);
+            float tx = x - float(x0), ty = y - float(y0);
+            const float* p00 = texels + (size_t(y0) * s + x0) * 3;
+            const float* p10 = texels + (size_t(y0) * s + x1) * 3;
+            const float* p01 = texels + (size_t(y1) * s + x0) * 3;
+            const float* p11 = texels + (size_t(y1) * s + x1) * 3;
+            for (int c = 0; c < 3; ++c) {
+                float bottom = p00[c] + (p10[c] - p00[c]) * tx;
+                float top = p01[c] + (p11[c] - p01[c]) * tx;
+                out[c] = bottom + (top - bottom) * ty;
+            }
+        }
+
+        void sample(const glm::vec3& dir, float lod, float* out) const {
+            int face;
+            float u, v;
+            const float d[3] = { dir.x, dir.y, dir.z };
+            CubemapBaker::directionToFace(d, face, u, v);
+            lod = std::min(std::max(lod, 0.0f), float(levels - 1));
+            int l0 = int(lod);
+            float t = lod - float(l0);
+            sampleLevel(l0, face, u, v, out);
+            if (t > 0.0f && l0 + 1 < levels) {
+                float next[3];
+                sampleLevel(l0 + 1, face, u, v, next);
+                for (int c = 0; c < 3; ++c) out[c] += (next[c] - out[c]) * t;
+            }
+        }
+    };
+
+    // Real SH basis, bands 0 to 2
+    void shBasis(const glm::vec3& d, float y[9]) {
+        y[0] = 0.282095f;
+        y[1] = 0.488603f * d.y;
+        y[2] = 0.488603f * d.z;
+        y[3] = 0.488603f * d.x;
+        y[4] = 1.092548f * d.x * d.y;
+        y[5] = 1.092548f * d.y * d.z;
+        y[6] = 0.315392f * (3.0f * d.z * d.z - 1.0f);
+        y[7] = 1.092548f * d.x * d.z;
+        y[8] = 0.546274f * (d.x * d.x - d.y * d.y);
+    }
+
+    glm::vec3 faceTexelDirection(int face, int x, int y, int size) {
+        float scale = 2.0f / float(size);
+        float dir[3];
+        CubemapBaker::texelDirection(face, (float(x) + 0.5f) * scale - 1.0f, (float(y) + 0.5f) * scale - 1.0f, dir);
+        return glm::vec3(dir[0], dir[1], dir[2]);
+    }
+
+    glm::vec2 hammersley(uint32_t i, uint32_t count) {
+        uint32_t bits = i;
+        bits = (bits << 16u) | (bits >> 16u);
+        bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+        bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+        bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+        bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+        return glm::vec2(float(i) / float(count), float(bits) * 2.3283064365386963e-10f);
+    }
+
+    // GGX half vector around +Z
+    glm::vec3 sampleGGX(const glm::vec2& xi, float alpha) {
+        float phi = 2.0f * PI * xi.x;
+        float cosTheta = std::sqrt((1.0f - xi.y) / (1.0f + (alpha * alpha - 1.0f) * xi.y));
+        float sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+        return glm::vec3(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+    }
+
+    // Reflected direction around +Z with its weight and source lod, the same
+    // for every texel of a level since N = V = R
+    struct PrefilterSample {
+        glm::vec3 direction;
+        float weight;
+        float lod;
+    };
+
+    std::vector<PrefilterSample> prefilterSamples(float roughness, int count, int sourceSize) {
+        std::vector<PrefilterSample> samples;
+        const float alpha = roughness * roughness;
+        const float alpha2 = alpha * alpha;
+        const float texelSolidAngle = 4.0f * PI / (6.0f * float(sourceSize) * float(sourceSize));
+        for (int i = 0; i < count; ++i) {
+            glm::vec3 h = sampleGGX(hammersley(uint32_t(i), uint32_t(count)), alpha);
+            glm::vec3 l(2.0f * h.z * h.x, 2.0f * h.z * h.y, 2.0f * h.z * h.z - 1.0f);
+            if (l.z <= 0.0f) continue;
+            // pdf = D * NdotH / (4 * VdotH) = D / 4 with N = V
+            float denom = h.z * h.z * (alpha2 - 1.0f) + 1.0f;
+            float pdf = alpha2 / (PI * denom * denom) * 0.25f;
+            float sampleSolidAngle = 1.0f / (float(count) * pdf + 1e-4f);
+            float lod = std::max(0.0f, 0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f);
+            samples.push_back({ l, l.z, lod });
+        }
+        return samples;
+    }
+
+    // Smith-Schlick geometry term with the IBL k
+    float geometrySmith(float NdotV, float NdotL, float roughness) {
+        float k = roughness * roughness * 0.5f;
+        float gv = NdotV / (NdotV * (1.0f - k) + k);
+        float gl = NdotL / (NdotL * (1.0f - k) + k);
+        return gv * gl;
+    }
+
+    int specularLevelCount(int size, int requested) {
+        int levels = 1;
+        while ((size >> levels) > 0 && levels < requested) ++levels;
+        return levels;
+    }
+
+    int specularSize(const CubemapImage& environment, const IBLBakeOptions& options) {
+        return std::max(1, std::min(options.specularSize, environment.size));
+    }
+
+    FileHeader headerFor(uint64_t sourceHash, const IBLBakeOptions& options) {
+        FileHeader header{};
+        std::memcpy(header.magic, MAGIC, 4);
+        header.version = IBLBaker::VERSION;
+        header.sourceHash = sourceHash;
+        header.environmentSize = uint32_t(options.environment.size);
+        header.environmentSupersample = uint32_t(std::max(1, options.environment.supersample));
+        header.specularSize = uint32_t(options.specularSize);
+        header.requestedLevels = uint32_t(options.specularLevels);
+        header.specularSamples = uint32_t(options.specularSamples);
+        header.lutSize = uint32_t(options.lutSize);
+        header.lutSamples = uint32_t(options.lutSamples);
+        return header;
+    }
+
+} // namespace
+
+void IBLBaker::projectSH(const CubemapImage& environment, glm::vec3 out[9]) {
+    for (int i = 0; i < 9; ++i) out[i] = glm::vec3(0.0f);
+    if (!environment.isValid()) return;
+
+    int level = 0;
+    while (level + 1 < environment.levels && environment.levelSize(level) > SH_MAX_SIZE) ++level;
+    const int size = environment.levelSize(level);
+    const float scale = 2.0f / float(size);
+
+    // per face partial sums in doubles, [face][coefficient * 3 + channel], [face][27] is the weight
+    std::vector<std::vector<double>> sums(6, std::vector<double>(28, 0.0));
+    ThreadPool::shared().parallelFor(6, [&](size_t face) {
+        const uint16_t* texels = environment.face(level, int(face));
+        std::vector<double>& sum = sums[face];
+        float basis[9];
+        for (int y = 0; y < size; ++y) {
+            float v = (float(y) + 0.5f) * scale - 1.0f;
+            for (int x = 0; x < size; ++x) {
+                float u = (float(x) + 0.5f) * scale - 1.0f;
+                // solid angle of the texel on the unit cube
+                float r2 = 1.0f + u * u + v * v;
+                float weight = scale * scale / (r2 * std::sqrt(r2));
+                shBasis(glm::normalize(faceTexelDirection(int(face), x, y, size)), basis);
+                const uint16_t* texel = texels + (size_t(y) * size + x) * 3;
+                float color[3] = { glm::unpackHalf1x16(texel[0]), glm::unpackHalf1x16(texel[1]), glm::unpackHalf1x16(texel[2]) };
+                for (int i = 0; i < 9; ++i) {
+                    float w = basis[i] * weight;
+                    sum[i * 3 + 0] += color[0] * w;
+                    sum[i * 3 + 1] += color[1] * w;
+                    sum[i * 3 + 2] += color[2] * w;
+                }
+                sum[27] += weight;
+            }
+        }
+    });
+
+    double total[28] = {};
+    for (const auto& sum : sums)
+        for (int i = 0; i < 28; ++i) total[i] += sum[i];
+    // weights add up to 4 pi only approximately; cosine lobe (pi, 2pi/3, pi/4) over pi per band
+    const double normalize = 4.0 * double(PI) / total[27];
+    const double band[3] = { 1.0, 2.0 / 3.0, 0.25 };
+    for (int i = 0; i < 9; ++i) {
+        double b = band[i == 0 ? 0 : (i < 4 ? 1 : 2)] * normalize;
+        out[i] = glm::vec3(float(total[i * 3] * b), float(total[i * 3 + 1] * b), float(total[i * 3 + 2] * b));
+    }
+}
+
+glm::vec3 IBLBaker::evaluateSH(const glm::vec3 sh[9], const glm::vec3& normal) {
+    float basis[9];
+    shBasis(normal, basis);
+    glm::vec3 result(0.0f);
+    for (int i = 0; i < 9; ++i) result += sh[i] * basis[i];
+    return glm::max(result, glm::vec3(0.0f));
+}
+
+CubemapImage IBLBaker::prefilterSpecular(const CubemapImage& environment, const IBLBakeOptions& options) {
+    CubemapImage image;
+    if (!environment.isValid()) return image;
+
+    FloatCube source(environment);
+    image.size = specularSize(environment, options);
+    image.levels = specularLevelCount(image.size, std::max(1, options.specularLevels));
+    image.faces.resize(size_t(image.levels) * 6);
+
+    // level 0 is the mirror reflection: the source mip matching the output size
+    const float baseLod = std::log2(float(environment.size) / float(image.size));
+    std::vector<std::vector<PrefilterSample>> samples(image.levels);
+    for (int l = 1; l < image.levels; ++l)
+        samples[l] = prefilterSamples(float(l) / float(image.levels - 1), std::max(1, options.specularSamples), environment.size);
+
+    // tasks are bands of rows of one face of one level
+    struct Band { int level, face, firstRow; };
+    std::vector<Band> bands;
+    for (int l = 0; l < image.levels; ++l) {
+        int s = image.levelSize(l);
+        for (int face = 0; face < 6; ++face) {
+            image.faces[size_t(l) * 6 + face].resize(size_t(s) * s * 3);
+            for (int row = 0; row < s; row += ROWS_PER_TASK) bands.push_back({ l, face, row });
+        }
+    }
+
+    ThreadPool::shared().parallelFor(bands.size(), [&](size_t task) {
+        const Band band = bands[task];
+        const int s = image.levelSize(band.level);
+        const std::vector<PrefilterSample>& levelSamples = samples[band.level];
+        uint16_t* out = image.faces[size_t(band.level) * 6 + band.face].data();
+        const int lastRow = std::min(band.firstRow + ROWS_PER_TASK, s);
+        for (int y = band.firstRow; y < lastRow; ++y) {
+            for (int x = 0; x < s; ++x) {
+                glm::vec3 n = glm::normalize(faceTexelDirection(band.face, x, y, s));
+                float color[3] = { 0.0f, 0.0f, 0.0f };
+                if (band.level == 0) {
+                    source.sample(n, baseLod, color);
+                } else {
+                    glm::vec3 up = std::fabs(n.z) < 0.999f ? glm::vec3(0, 0, 1) : glm::vec3(1, 0, 0);
+                    glm::vec3 tangent = glm::normalize(glm::cross(up, n));
+                    glm::vec3 bitangent = glm::cross(n, tangent);
+                    float total = 0.0f, tap[3];
+                    for (const PrefilterSample& sample : levelSamples) {
+                        glm::vec3 l = tangent * sample.direction.x + bitangent * sample.direction.y + n * sample.direction.z;
+                        source.sample(l, sample.lod, tap);
+                        color[0] += tap[0] * sample.weight;
+                        color[1] += tap[1] * sample.weight;
+                        color[2] += tap[2] * sample.weight;
+                        total += sample.weight;
+                    }
+                    if (total > 0.0f) {
+                        color[0] /= total;
+                        color[1] /= total;
+                        color[2] /= total;
+                    }
+                }
+                uint16_t* texel = out + (size_t(y) * s + x) * 3;
+                texel[0] = glm::packHalf1x16(color[0]);
+                texel[1] = glm::packHalf1x16(color[1]);
+                texel[2] = glm::packHalf1x16(color[2]);
+            }
+        }
+    });
+    return image;
+}
+
+std::vector<uint16_t> IBLBaker::integrateBRDF(int size, int samples) {
+    std::vector<uint16_t> lut;
+    if (size <= 0) return lut;
+    samples = std::max(1, samples);
+    lut.resize(size_t(size) * size * 2);
+
+    ThreadPool::shared().parallelFor(size_t(size), [&](size_t row) {
+        float roughness = (float(row) + 0.5f) / float(size);
+        float alpha = roughness * roughness;
+        for (int x = 0; x < size; ++x) {
+            float NdotV = (float(x) + 0.5f) / float(size);
+            glm::vec3 v(std::sqrt(1.0f - NdotV * NdotV), 0.0f, NdotV);
+            float scale = 0.0f, bias = 0.0f;
+            for (int i = 0; i < samples; ++i) {
+                glm::vec3 h = sampleGGX(hammersley(uint32_t(i), uint32_t(samples)), alpha);
+                float VdotH = glm::dot(v, h);
+                glm::vec3 l = 2.0f * VdotH * h - v;
+                if (l.z <= 0.0f) continue;
+                VdotH = std::max(VdotH, 0.0f);
+                float visibility = geometrySmith(NdotV, l.z, roughness) * VdotH / (h.z * NdotV);
+                float fresnel = std::pow(1.0f - VdotH, 5.0f);
+                scale += (1.0f - fresnel) * visibility;
+                bias += fresnel * visibility;
+            }
+            uint16_t* texel = lut.data() + (row * size + x) * 2;
+            texel[0] = glm::packHalf1x16(scale / float(samples));
+            texel[1] = glm::packHalf1x16(bias / float(samples));
+        }
+    });
+    return lut;
+}
+
+IBLData IBLBaker::bake(const CubemapImage& environment, const IBLBakeOptions& options) {
+    IBLData data;
+    if (!environment.isValid()) return data;
+
+    auto start = std::chrono::steady_clock::now();
+    projectSH(environment, data.sh);
+    double shMs = msSince(start);
+
+    start = std::chrono::steady_clock::now();
+    data.specular = prefilterSpecular(environment, options);
+    double specularMs = msSince(start);
+
+    start = std::chrono::steady_clock::now();
+    data.lutSize = options.lutSize;
+    data.brdfLut = integrateBRDF(options.lutSize, options.lutSamples);
+    double lutMs = msSince(start);
+
+    std::cout << "[IBLBaker] SH " << shMs << " ms, specular " << data.specular.size << "x" << data.specular.size
+        << " x" << data.specular.levels << " levels " << specularMs << " ms, BRDF LUT " << data.lutSize
+        << "^2 " << lutMs << " ms\n";
+    return data;
+}
+
+bool IBLBaker::hashFile(const std::string& path, uint64_t& hash) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    hash = 14695981039346656037ull;
+    std::vector<char> chunk(1 << 20);
+    while (in) {
+        in.read(chunk.data(), std::streamsize(chunk.size()));
+        hash = fnv1a(hash, chunk.data(), size_t(in.gcount()));
+    }
+    return in.eof();
+}
+
+std::string IBLBaker::cachePathFor(const std::string& hdrPath) {
+    return hdrPath + ".iblcache";
+}
+
+bool IBLBaker::write(const std::string& cachePath, uint64_t sourceHash, const IBLBakeOptions& options, const IBLData& data) {
+    if (!data.isValid()) return false;
+    FileHeader header = headerFor(sourceHash, options);
+    header.specularLevels = uint32_t(data.specular.levels);
+
+    // write to a temporary file and swap it in, so readers never see a partial cache
+    std::string tmpPath = cachePath + ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(data.sh), sizeof(data.sh));
+        uint32_t specularSize = uint32_t(data.specular.size);
+        out.write(reinterpret_cast<const char*>(&specularSize), sizeof(specularSize));
+        for (const auto& face : data.specular.faces)
+            out.write(reinterpret_cast<const char*>(face.data()), std::streamsize(face.size() * sizeof(uint16_t)));
+        out.write(reinterpret_cast<const char*>(data.brdfLut.data()), std::streamsize(data.brdfLut.size() * sizeof(uint16_t)));
+        if (!out) {
+            out.close();
+            fs::remove(tmpPath, ec);
+            return false;
+        }
+    }
+    fs::rename(tmpPath, cachePath, ec);
+    if (ec) {
+        // some platforms refuse to rename over an existing file
+        fs::remove(cachePath, ec);
+        fs::rename(tmpPath, cachePath, ec);
+    }
+    return !ec;
+}
+
+bool IBLBaker::read(const std::string& cachePath, uint64_t sourceHash, const IBLBakeOptions& options, IBLData& out) {
+    std::ifstream in(cachePath, std::ios::binary);
+    FileHeader header{};
+    if (!in || !in.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+
+    // everything up to the stored level count is fixed by the source and options
+    FileHeader expected = headerFor(sourceHash, options);
+    if (std::memcmp(&header, &expected, offsetof(FileHeader, specularLevels)) != 0) return false;
+
+    IBLData data;
+    uint32_t specularSize = 0;
+    if (!in.read(reinterpret_cast<char*>(data.sh), sizeof(data.sh))
+        || !in.read(reinterpret_cast<char*>(&specularSize), sizeof(specularSize))
+        || specularSize == 0 || specularSize > header.specularSize)
+        return false;
+    // the level count follows from the face size, as prefilterSpecular picks it
+    if (header.specularLevels != uint32_t(specularLevelCount(int(specularSize), std::max(1, options.specularLevels))))
+        return false;
+
+    data.specular.size = int(specularSize);
+    data.specular.levels = int(header.specularLevels);
+    data.specular.faces.resize(size_t(data.specular.levels) * 6);
+    for (size_t i = 0; i < data.specular.faces.size(); ++i) {
+        int s = data.specular.levelSize(int(i / 6));
+        data.specular.faces[i].resize(size_t(s) * s * 3);
+        if (!in.read(reinterpret_cast<char*>(data.specular.faces[i].data()), std::streamsize(data.specular.faces[i].size() * sizeof(uint16_t))))
+            return false;
+    }
+    data.lutSize = int(header.lutSize);
+    data.brdfLut.resize(size_t(data.lutSize) * data.lutSize * 2);
+    if (!in.read(reinterpret_cast<char*>(data.brdfLut.data()), std::streamsize(data.brdfLut.size() * sizeof(uint16_t))))
+        return false;
+    out = std::move(data);
+    return true;
+}
+
+bool IBLBaker::loadOrBake(const std::string& hdrPath, IBLData& out, const IBLBakeOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t sourceHash = 0;
+    if (!hashFile(hdrPath, sourceHash)) {
+        std::cerr << "[IBLBaker] Failed to read " << hdrPath << "\n";
+        return false;
+    }
+    std::string cachePath = cachePathFor(hdrPath);
+    if (read(cachePath, sourceHash, options, out)) {
+        std::cout << "[IBLBaker] Loaded " << cachePath << " in " << msSince(start) << " ms\n";
+        return true;
+    }
+
+    CubemapImage environment;
+    if (!CubemapBaker::loadOrBake(hdrPath, environment, options.environment)) return false;
+    out = bake(environment, options);
+    if (!out.isValid()) return false;
+    if (!write(cachePath, sourceHash, options, out))
+        std::cerr << "[IBLBaker] Could not write " << cachePath << "\n";
+    return true;
+}
@@ -0,0 +1,77 @@
+#include "engine/InstanceBuffer.h"
+#include <algorithm>
+
+thread_local bool InstanceBuffer::identitySet = false;
+
+InstanceBuffer::InstanceBuffer(size_t initialCapacity)
+    : capacity(initialCapacity) {
+    vbo = std::make_unique<VBO>(static_cast<const void*>(nullptr), 0);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+    vbo->Unbind();
+}
+
+void InstanceBuffer::update(const glm::mat4* transforms, size_t newCount) {
+    transformsCpu.assign(transforms, transforms + newCount);
+    vbo->Bind();
+    // grow with headroom so slowly growing crowds do not realloc every frame
+    if (newCount > capacity) capacity = std::max(newCount, capacity + capacity / 2);
+    // orphan the old storage so a draw still reading it does not stall the upload
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+    if (newCount > 0)
+        glBufferSubData(GL_ARRAY_BUFFER, 0, newCount * sizeof(glm::mat4), transforms);
+    vbo->Unbind();
+}
+
+void InstanceBuffer::resize(size_t newCount) {
+    transformsCpu.resize(newCount, glm::mat4(1.0f));
+    if (newCount <= capacity) return;
+
+    // reallocate and restore the live transforms from the CPU copy
+    capacity = std::max(newCount, capacity + capacity / 2);
+    vbo->Bind();
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, newCount * sizeof(glm::mat4), transformsCpu.data());
+    vbo->Unbind();
+}
+
+void InstanceBuffer::updateRange(size_t first, const glm::mat4* transforms, size_t rangeCount) {
+    if (first >= transformsCpu.size() || rangeCount == 0) return;
+    rangeCount = std::min(rangeCount, transformsCpu.size() - first);
+    std::copy(transforms, transforms + rangeCount, transformsCpu.begin() + first);
+    vbo->Bind();
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(first * sizeof(glm::mat4)),
+        static_cast<GLsizeiptr>(rangeCount * sizeof(glm::mat4)), transforms);
+    vbo->Unbind();
+}
+
+void InstanceBuffer::link() {
+    vbo->Bind();
+    // a mat4 attribute takes four vec4 locations
+    for (GLuint i = 0; i < 4; ++i) {
+        GLuint location = FIRST_ATTRIBUTE + i;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+            (void*)(i * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    vbo->Unbind();
+}
+
+void InstanceBuffer::unlink() {
+    // current values of an array-fed attribute are undefined after a draw
+    for (GLuint i = 0; i < 4; ++i) {
+        glVertexAttribDivisor(FIRST_ATTRIBUTE + i, 0);
+        glDisableVertexAttribArray(FIRST_ATTRIBUTE + i);
+    }
+    identitySet = false;
+    setDefaultIdentity();
+}
+
+void InstanceBuffer::setDefaultIdentity() {
+    if (identitySet) return;
+    for (GLuint i = 0; i < 4; ++i) {
+        glVertexAttrib4f(FIRST_ATTRIBUTE + i, i == 0 ? 1.0f : 0.0f, i == 1 ? 1.0f : 0.0f,
+            i == 2 ? 1.0f : 0.0f, i == 3 ? 1.0f : 0.0f);
+    }
+    identitySet = true;
+}
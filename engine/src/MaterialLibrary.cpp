@@ -0,0 +1,329 @@
+#include "engine/MaterialLibrary.h"
+#include "engine/Texture.h"
+#include "engine/TextureDecoder.h"
+#include "engine/GLState.h"
+#include "engine/Shader.h"
+#include <algorithm>
+#include <climits>
+#include <iostream>
+
+namespace {
+
+    // names in material.glsl
+    constexpr UniformName PAGE_UNIFORMS[MaterialLibrary::MAX_PAGES] = {
+        "materialPage0", "materialPage1", "materialPage2", "materialPage3",
+    };
+    constexpr UniformName TABLE_UNIFORM("materialTable");
+
+    int log2Floor(int value) {
+        int result = 0;
+        while (value > 1) {
+            value >>= 1;
+            ++result;
+        }
+        return result;
+    }
+
+} // namespace
+
+thread_local int MaterialLibrary::currentDrawMaterial = INT_MIN;
+
+MaterialLibrary::MaterialLibrary(const MaterialLibraryOptions& libraryOptions) : options(libraryOptions) {
+    options.layersPerPage = std::max(1, options.layersPerPage);
+    options.atlasPadding = std::max(0, options.atlasPadding);
+}
+
+MaterialLibrary::~MaterialLibrary() {
+    for (Page& page : pages)
+        if (page.ID != 0) GLState::deleteTexture(page.ID);
+    if (tableTexture != 0) GLState::deleteTexture(tableTexture);
+    if (tableBuffer != 0) GLState::deleteBuffer(tableBuffer);
+}
+
+MaterialTextureRef MaterialLibrary::addTexture(const BakedTexture& texture, bool allowAtlas) {
+    if (!texture.isValid()) return MaterialTextureRef();
+
+    const int atlasLimit = std::min(options.atlasMaxTexture, options.atlasSize - 2 * options.atlasPadding);
+    if (allowAtlas && options.atlasSize > 0 && texture.width <= atlasLimit && texture.height <= atlasLimit) {
+        // the atlas rebuilds its own mips, only level 0 is kept
+        std::vector<uint8_t> rgba = TextureBaker::decodeLevel(texture, 0);
+        MaterialTextureRef ref = addToAtlas(rgba.data(), texture.width, texture.height);
+        if (ref.valid()) return ref;
+    }
+
+    // block formats the driver cannot sample go in as RGBA8
+    std::vector<std::vector<uint8_t>> levels = texture.levels;
+    TextureFormat format = texture.format;
+    if (format != TextureFormat::RGBA8 && !Texture::compressedFormat(format)) {
+        for (int level = 0; level < int(levels.size()); ++level)
+            levels[level] = TextureBaker::decodeLevel(texture, level);
+        format = TextureFormat::RGBA8;
+    }
+
+    int index = findPage(format, texture.width, texture.height, int(levels.size()));
+    if (index < 0) {
+        std::cerr << "[MaterialLibrary] No page left for a " << texture.width << "x" << texture.height
+            << " texture (" << MAX_PAGES << " pages in use)\n";
+        return MaterialTextureRef();
+    }
+    Page& page = pages[size_t(index)];
+    page.layers.push_back(std::move(levels));
+    ++textureCount;
+
+    MaterialTextureRef ref;
+    ref.page = index;
+    ref.layer = int(page.layers.size()) - 1;
+    return ref;
+}
+
+MaterialTextureRef MaterialLibrary::addTexture(const uint8_t* pixels, int width, int height, int channels,
+    const char* texType, bool allowAtlas) {
+    // RGBA8 keeps the pixels, the mip chain is still filtered like TextureBaker's
+    TextureBakeOptions bakeOptions = TextureBakeOptions::forType(texType);
+    bakeOptions.format = TextureFormat::RGBA8;
+    return addTexture(TextureBaker::bake(pixels, width, height, channels, bakeOptions), allowAtlas);
+}
+
+MaterialTextureRef MaterialLibrary::addTexture(const std::string& path, const char* texType) {
+    auto cached = pathCache.find(path);
+    if (cached != pathCache.end()) return cached->second;
+
+    MaterialTextureRef ref;
+    BakedTexture baked;
+    if ((TextureBaker::isEnabled() || TextureBaker::isContainer(path))
+        && TextureBaker::loadOrBake(path, baked, TextureBakeOptions::forType(texType))) {
+        ref = addTexture(baked);
+    }
+    else {
+        TextureRequest request;
+        request.path = path;
+        DecodedImage decoded = TextureDecoder::decode(request);
+        if (!decoded.isValid()) {
+            std::cerr << "[MaterialLibrary] Failed to load texture: " << path << "\n";
+            return ref;
+        }
+        ref = addTexture(decoded.pixels.get(), decoded.width, decoded.height, decoded.channels, texType);
+    }
+    // failures are not cached, a later call may find a free page
+    if (ref.valid()) pathCache.emplace(path, ref);
+    return ref;
+}
+
+int MaterialLibrary::addMaterial(const MaterialDesc& material) {
+    materials.push_back(material);
+    tableDirty = true;
+    return int(materials.size()) - 1;
+}
+
+void MaterialLibrary::updateMaterial(int index, const MaterialDesc& material) {
+    if (index < 0 || size_t(index) >= materials.size()) return;
+    materials[size_t(index)] = material;
+    tableDirty = true;
+}
+
+int MaterialLibrary::findPage(TextureFormat format, int width, int height, int levelCount) {
+    for (size_t i = 0; i < pages.size(); ++i) {
+        const Page& page = pages[i];
+        if (page.atlas || page.uploaded() || page.format != format) continue;
+        if (page.width != width || page.height != height || page.levelCount != levelCount) continue;
+        if (int(page.layers.size()) < options.layersPerPage) return int(i);
+    }
+    if (pages.size() >= size_t(MAX_PAGES)) return -1;
+
+    Page page;
+    page.format = format;
+    page.width = width;
+    page.height = height;
+    page.levelCount = levelCount;
+    pages.push_back(std::move(page));
+    return int(pages.size()) - 1;
+}
+
+MaterialTextureRef MaterialLibrary::addToAtlas(const uint8_t* rgba, int width, int height) {
+    MaterialTextureRef ref;
+    if (!rgba) return ref;
+    const int size = options.atlasSize, padding = options.atlasPadding;
+    const int paddedWidth = width + 2 * padding, paddedHeight = height + 2 * padding;
+
+    int index = -1;
+    for (size_t i = 0; i < pages.size(); ++i)
+        if (pages[i].atlas && !pages[i].uploaded()) index = int(i);
+    if (index < 0) {
+        if (pages.size() >= size_t(MAX_PAGES)) return ref;
+        Page page;
+        page.atlas = true;
+        page.width = page.height = size;
+        // mips stay clean while the padding still covers a texel
+        page.levelCount = std::min(log2Floor(std::max(1, padding)), log2Floor(size)) + 1;
+        pages.push_back(std::move(page));
+        index = int(pages.size()) - 1;
+    }
+    Page& page = pages[size_t(index)];
+
+    // shelf packing: left to right, a new shelf above the tallest entry of the last one
+    if (!page.layers.empty() && page.shelfX + paddedWidth > size) {
+        page.shelfX = 0;
+        page.shelfY += page.shelfHeight;
+        page.shelfHeight = 0;
+    }
+    if (page.layers.empty() || page.shelfY + paddedHeight > size) {
+        if (int(page.layers.size()) >= options.layersPerPage) return ref;
+        page.layers.emplace_back(1, std::vector<uint8_t>(size_t(size) * size * 4, 0));
+        page.shelfX = page.shelfY = page.shelfHeight = 0;
+    }
+
+    // copy with the edge texels replicated into the padding
+    std::vector<uint8_t>& pixels = page.layers.back()[0];
+    for (int y = -padding; y < height + padding; ++y) {
+        int sy = std::clamp(y, 0, height - 1);
+        uint8_t* row = pixels.data() + (size_t(page.shelfY + padding + y) * size + page.shelfX + padding) * 4;
+        for (int x = -padding; x < width + padding; ++x) {
+            int sx = std::clamp(x, 0, width - 1);
+            std::copy_n(rgba + (size_t(sy) * width + sx) * 4, 4, row + ptrdiff_t(x) * 4);
+        }
+    }
+
+    ref.page = index;
+    ref.layer = int(page.layers.size()) - 1;
+    ref.scale = glm::vec2(float(width), float(height)) / float(size);
+    ref.offset = glm::vec2(float(page.shelfX + padding), float(page.shelfY + padding)) / float(size);
+    page.shelfX += paddedWidth;
+    page.shelfHeight = std::max(page.shelfHeight, paddedHeight);
+    ++textureCount;
+    ++atlasTextureCount;
+    return ref;
+}
+
+void MaterialLibrary::uploadPage(Page& page) {
+    const GLsizei layerCount = GLsizei(page.layers.size());
+    const GLenum compressed = page.format == TextureFormat::RGBA8 ? 0 : Texture::compressedFormat(page.format);
+
+    glGenTextures(1, &page.ID);
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, page.ID);
+    // same sampling as file textures; atlas entries wrap in the shader instead
+    GLenum wrap = page.atlas ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, wrap);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, wrap);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, page.levelCount - 1);
+
+    // every level at once, layers back to back
+    page.gpuBytes = 0;
+    const int uploadLevels = page.atlas ? 1 : page.levelCount;
+    std::vector<uint8_t> data;
+    for (int level = 0; level < uploadLevels; ++level) {
+        GLsizei w = std::max(1, page.width >> level), h = std::max(1, page.height >> level);
+        data.clear();
+        for (const auto& layer : page.layers)
+            data.insert(data.end(), layer[size_t(level)].begin(), layer[size_t(level)].end());
+        if (compressed)
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, compressed, w, h, layerCount, 0,
+                GLsizei(data.size()), data.data());
+        else
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, w, h, layerCount, 0,
+                GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+        page.gpuBytes += data.size();
+    }
+    if (page.atlas) {
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        page.gpuBytes += page.gpuBytes / 3;
+    }
+
+    // the CPU copies are not needed anymore, the layer count stays
+    for (auto& layer : page.layers) std::vector<std::vector<uint8_t>>().swap(layer);
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void MaterialLibrary::uploadTable() {
+    // texel layout read by loadMaterial in material.glsl
+    std::vector<glm::vec4> texels(materials.size() * TEXELS_PER_MATERIAL);
+    for (size_t m = 0; m < materials.size(); ++m) {
+        const MaterialDesc& material = materials[m];
+        glm::vec4* out = texels.data() + m * TEXELS_PER_MATERIAL;
+        out[0] = material.baseColor;
+        out[1] = material.params;
+        for (size_t s = 0; s < size_t(MaterialSlot::Count); ++s) {
+            const MaterialTextureRef& ref = material.textures[s];
+            // refs pointing at pages that do not exist read as empty slots
+            bool valid = ref.valid() && size_t(ref.page) < pages.size();
+            bool atlas = valid && pages[size_t(ref.page)].atlas;
+            out[2 + s * 2] = glm::vec4(valid ? float(ref.page) : -1.0f, float(ref.layer), atlas ? 1.0f : 0.0f, 0.0f);
+            out[3 + s * 2] = glm::vec4(ref.scale, ref.offset);
+        }
+    }
+
+    if (tableBuffer == 0) {
+        glGenBuffers(1, &tableBuffer);
+        glGenTextures(1, &tableTexture);
+        // the buffer texture follows reallocations of its buffer, attached once
+        GLState::bindBuffer(GL_TEXTURE_BUFFER, tableBuffer);
+        GLState::bindTexture(GL_TEXTURE_BUFFER, tableTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, tableBuffer);
+        GLState::bindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+    GLState::bindBuffer(GL_TEXTURE_BUFFER, tableBuffer);
+    // grow with headroom, orphan otherwise so draws still reading the old table do not stall
+    if (texels.size() > tableCapacity) tableCapacity = std::max(texels.size(), tableCapacity + tableCapacity / 2);
+    glBufferData(GL_TEXTURE_BUFFER, tableCapacity * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+    if (!texels.empty())
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, texels.size() * sizeof(glm::vec4), texels.data());
+    GLState::bindBuffer(GL_TEXTURE_BUFFER, 0);
+    tableDirty = false;
+}
+
+void MaterialLibrary::bind(const Shader& shader) {
+    for (Page& page : pages)
+        if (!page.uploaded() && !page.layers.empty()) uploadPage(page);
+    if (tableDirty) uploadTable();
+
+    // every sampler gets its own unit, even unused ones: two sampler types on
+    // one unit fail the draw
+    for (int i = 0; i < MAX_PAGES; ++i) {
+        GLuint unit = options.firstUnit + GLuint(i);
+        GLuint id = size_t(i) < pages.size() ? pages[size_t(i)].ID : 0;
+        GLState::bindTexture(unit, GL_TEXTURE_2D_ARRAY, id);
+        shader.setInt(PAGE_UNIFORMS[i], int(unit));
+    }
+    GLuint tableUnit = options.firstUnit + GLuint(MAX_PAGES);
+    GLState::bindTexture(tableUnit, GL_TEXTURE_BUFFER, tableTexture);
+    shader.setInt(TABLE_UNIFORM, int(tableUnit));
+    ++bindCount;
+}
+
+void MaterialLibrary::setDrawMaterial(int index) {
+    if (index == currentDrawMaterial) return;
+    glVertexAttribI4i(MATERIAL_ATTRIBUTE, index, 0, 0, 0);
+    currentDrawMaterial = index;
+}
+
+void MaterialLibrary::linkInstanceMaterials(GLuint buffer) {
+    GLState::bindBuffer(GL_ARRAY_BUFFER, buffer);
+    glVertexAttribIPointer(MATERIAL_ATTRIBUTE, 1, GL_INT, sizeof(GLint), (void*)0);
+    glEnableVertexAttribArray(MATERIAL_ATTRIBUTE);
+    glVertexAttribDivisor(MATERIAL_ATTRIBUTE, 1);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void MaterialLibrary::unlinkInstanceMaterials() {
+    glVertexAttribDivisor(MATERIAL_ATTRIBUTE, 0);
+    glDisableVertexAttribArray(MATERIAL_ATTRIBUTE);
+    // current values of an array-fed attribute are undefined after a draw
+    currentDrawMaterial = INT_MIN;
+}
+
+MaterialStats MaterialLibrary::getStats() const {
+    MaterialStats stats;
+    stats.materials = materials.size();
+    stats.textures = textureCount;
+    stats.atlasTextures = atlasTextureCount;
+    stats.pages = pages.size();
+    for (const Page& page : pages) {
+        stats.layers += page.layers.size();
+        stats.gpuBytes += page.gpuBytes;
+    }
+    stats.gpuBytes += tableCapacity * sizeof(glm::vec4);
+    stats.binds = bindCount;
+    return stats;
+}
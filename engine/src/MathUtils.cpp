@@ -39,4 +39,16 @@ float MathUtils::clamp01(float t) {
 float MathUtils::easeInOut(float t) {
     t = clamp01(t);
     return t * t * (3.0f - 2.0f * t);
-}
\ No newline at end of file
+}
+
+// AABB transform using the absolute rotation/scale part (Arvo)
+void MathUtils::transformAABB(const glm::vec3& min, const glm::vec3& max, const glm::mat4& m,
+                              glm::vec3& outMin, glm::vec3& outMax) {
+    glm::vec3 center = glm::vec3(m * glm::vec4((min + max) * 0.5f, 1.0f));
+    glm::vec3 extent = (max - min) * 0.5f;
+    glm::mat3 absM = glm::mat3(m);
+    for (int c = 0; c < 3; ++c) absM[c] = glm::abs(absM[c]);
+    glm::vec3 worldExtent = absM * extent;
+    outMin = center - worldExtent;
+    outMax = center + worldExtent;
+}
@@ -1,28 +1,90 @@
 #include "engine/Mesh.h"
 #include "engine/Shader.h"
+#include "engine/MeshOptimizer.h"
+#include "engine/MaterialLibrary.h"
 #include <glm/gtc/matrix_transform.hpp>
-#include <string>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 
 // Constructor that generates a Mesh, need to initialze vbo and ebo
 Mesh::Mesh(const std::vector <Vertex>& vert, 
 			const std::vector <GLuint>& inds, 
 			const std::vector<std::shared_ptr<Texture>>& texs)
-	: vertices(vert), indices(inds), textures(texs), vbo(vertices), ebo(indices) {
-	// bind vao since default constructor is already called
-	vao.Bind();
-	ebo.Bind(); // sync with vao
-
-	// link vertex positions (3 floats)
-	vao.LinkVBO(vbo, 0, 3, sizeof(Vertex), (void*)0);
-	// link normals (3 floats, start after first 3)
-	vao.LinkVBO(vbo, 1, 3, sizeof(Vertex), (void*)(3 * sizeof(float)));
-	// link vertex colors (3 floats, start after first 6)
-	vao.LinkVBO(vbo, 2, 3, sizeof(Vertex), (void*)(6 * sizeof(float)));
-	// link texture coordinates (2 floats, start after first 9)
-	vao.LinkVBO(vbo, 3, 2, sizeof(Vertex), (void*)(9 * sizeof(float)));
+	: vertices(vert), indices(inds), textures(texs),
+	  indexCount(static_cast<GLsizei>(inds.size())),
+	  indexType(GL_UNSIGNED_INT),
+	  vertexBytes(vert.size() * sizeof(Vertex)),
+	  indexBytes(inds.size() * (indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint))),
+	  vbo(std::make_unique<VBO>(vertices)),
+	  ebo(std::make_unique<EBO>(indices.data(), indices.size(), indexType)) {
+	setupVertexArray();
+}
+
+// Constructor that uploads directly from memory, vertices and indices stay empty
+Mesh::Mesh(const Vertex* vert, size_t vertCount,
+			const GLuint* inds, size_t indCount,
+			const std::vector<std::shared_ptr<Texture>>& texs,
+			bool deferVertexArray, bool shortIndices)
+	: Mesh(static_cast<const void*>(vert), vertCount, VertexFormat::standard(),
+		   inds, indCount, texs, deferVertexArray, shortIndices) {}
+
+// Constructor for vertices encoded in a compact VertexFormat
+Mesh::Mesh(const void* vertexData, size_t vertCount, const VertexFormat& vertexFormat,
+			const GLuint* inds, size_t indCount,
+			const std::vector<std::shared_ptr<Texture>>& texs,
+			bool deferVertexArray, bool shortIndices)
+	: textures(texs), indexCount(static_cast<GLsizei>(indCount)),
+	  indexType(shortIndices && MeshOptimizer::fitsShortIndices(vertCount) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT),
+	  format(vertexFormat), vertexBytes(vertCount * vertexFormat.stride()),
+	  indexBytes(indCount * (indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint))),
+	  vbo(std::make_unique<VBO>(vertexData, vertexBytes)),
+	  ebo(std::make_unique<EBO>(inds, indCount, indexType)) {
+	if (!deferVertexArray) setupVertexArray();
+}
+
+// Constructor that suballocates from a GeometryArena, indices stay relative to the mesh
+Mesh::Mesh(GeometryArena& geometryArena, const void* vertexData, size_t vertCount,
+			const GLuint* inds, size_t indCount,
+			const std::vector<std::shared_ptr<Texture>>& texs,
+			bool shortIndices)
+	: textures(texs), indexCount(static_cast<GLsizei>(indCount)),
+	  indexType(shortIndices && MeshOptimizer::fitsShortIndices(vertCount) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT),
+	  format(geometryArena.getFormat()), vertexBytes(vertCount * geometryArena.getStride()),
+	  indexBytes(indCount * (indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint))),
+	  arena(&geometryArena) {
+	if (indexType == GL_UNSIGNED_SHORT) {
+		std::vector<GLushort> narrow(inds, inds + indCount);
+		arenaHandle = arena->allocate(vertexData, vertCount, narrow.data(), indexBytes);
+	}
+	else {
+		arenaHandle = arena->allocate(vertexData, vertCount, inds, indexBytes);
+	}
+}
+
+void Mesh::setupVertexArray() {
+	// generate and bind the vao on the current context
+	vao = std::make_unique<VAO>();
+	vao->Bind();
+	ebo->Bind(); // sync with vao
+
+	if (format.isStandard()) {
+		// link vertex positions (3 floats)
+		vao->LinkVBO(*vbo, 0, 3, sizeof(Vertex), (void*)0);
+		// link normals (3 floats, start after first 3)
+		vao->LinkVBO(*vbo, 1, 3, sizeof(Vertex), (void*)(3 * sizeof(float)));
+		// link vertex colors (3 floats, start after first 6)
+		vao->LinkVBO(*vbo, 2, 3, sizeof(Vertex), (void*)(6 * sizeof(float)));
+		// link texture coordinates (2 floats, start after first 9)
+		vao->LinkVBO(*vbo, 3, 2, sizeof(Vertex), (void*)(9 * sizeof(float)));
+	}
+	else {
+		// packed / quantized attributes
+		format.link(*vao, *vbo);
+	}
 
 	// unbind to prevent accidental modification
-	vao.Unbind(); vbo.Unbind(); ebo.Unbind();
+	vao->Unbind(); vbo->Unbind(); ebo->Unbind();
 }
 
 void Mesh::setModelMatrix(const glm::mat4& m) {
@@ -49,28 +111,156 @@ void Mesh::setScale(const glm::vec3& scale) {
 	modelMatrix = glm::scale(modelMatrix, scale);
 }
 
+void Mesh::setLods(const std::vector<MeshLod>& levels) {
+	lods = levels;
+	currentLod = 0;
+	if (!lods.empty()) indexCount = static_cast<GLsizei>(lods[0].indexCount);
+}
+
+GLsizei Mesh::getDrawIndexCount() const {
+	return lods.empty() ? indexCount : static_cast<GLsizei>(lods[currentLod].indexCount);
+}
+
+void Mesh::setInstances(const glm::mat4* transforms, size_t count) {
+	instanceTransforms.assign(transforms, transforms + count);
+	if (count == 0) {
+		instanceBuffer.reset();
+		return;
+	}
+	if (!instanceBuffer) instanceBuffer = std::make_unique<InstanceBuffer>(count);
+	uploadInstances();
+}
+
+void Mesh::setInstanceParent(const glm::mat4& parent) {
+	if (parent == instanceParent) return;
+	instanceParent = parent;
+	if (instanceBuffer) uploadInstances();
+}
+
+void Mesh::uploadInstances() {
+	std::vector<glm::mat4> placed(instanceTransforms.size());
+	for (size_t i = 0; i < placed.size(); ++i) placed[i] = instanceParent * instanceTransforms[i];
+	instanceBuffer->update(placed);
+}
+
+void Mesh::setInstanceMaterials(const GLint* materialIndices, size_t count) {
+	instanceMaterialCount = count;
+	if (count == 0) {
+		instanceMaterials.reset();
+		return;
+	}
+	instanceMaterials = std::make_unique<VBO>(static_cast<const void*>(materialIndices), count * sizeof(GLint));
+	instanceMaterials->Unbind();
+}
+
+GLsizei Mesh::getInstanceCount() const {
+	return instanceBuffer ? static_cast<GLsizei>(instanceBuffer->getCount()) : 1;
+}
+
 void Mesh::Draw(Shader& shader) {
+	bindTextures(shader);
+	DrawGeometry();
+}
+
+void Mesh::DrawGeometry() {
+	submit(instanceBuffer.get(), getInstanceCount());
+}
+
+GLuint Mesh::getVertexArrayID() const {
+	if (arena) return arena->getVertexArrayID();
+	return vao ? vao->ID : 0;
+}
+
+void Mesh::DrawInstanced(Shader& shader, InstanceBuffer& instances) {
+	bindTextures(shader);
+	submit(&instances, static_cast<GLsizei>(instances.getCount()));
+}
+
+void Mesh::DrawInstanced(Shader& shader, const glm::mat4* transforms, size_t count) {
+	if (count == 0) return;
+	if (!scratchInstances) scratchInstances = std::make_unique<InstanceBuffer>(count);
+	scratchInstances->update(transforms, count);
+	DrawInstanced(shader, *scratchInstances);
+}
+
+void Mesh::bindTextures(Shader& shader) {
+	// the material library is bound once for every material mesh
+	if (materialIndex >= 0) return;
+
 	// Keep track of how many of each type of textures we have
 	unsigned int numDiffuse = 0;
 	unsigned int numSpecular = 0;
 
+	// sampler names ("diffuse0", ...) are built on the stack, no allocation per draw
+	char name[64];
+	const size_t maxType = sizeof(name) - 16;
+
 	// bind textures in order
 	for (unsigned int i = 0; i < textures.size(); i++) {
-		std::string num;
-		std::string type = textures[i]->type;
-		if (type == "diffuse") {
-			num = std::to_string(numDiffuse++);
+		const char* type = textures[i]->type;
+		size_t length = std::min(std::strlen(type), maxType);
+		std::memcpy(name, type, length);
+		char* end = name + length;
+		if (std::strcmp(type, "diffuse") == 0) {
+			end = std::to_chars(end, name + sizeof(name) - 1, numDiffuse++).ptr;
 		}
-		else if (type == "specular") {
-			num = std::to_string(numSpecular++);
+		else if (std::strcmp(type, "specular") == 0) {
+			end = std::to_chars(end, name + sizeof(name) - 1, numSpecular++).ptr;
 		}
-		textures[i]->texUnit(shader, (type + num).c_str(), i);
-		textures[i]->Bind();
+		*end = '\0';
+		textures[i]->texUnit(shader, name, i);
+		// shared textures may carry another mesh's slot, bind to this unit
+		textures[i]->Bind(i);
 	}
+}
 
-	// Draw the actual mesh
-	vao.Bind();
-	glDrawElements(drawMode, indices.size(), GL_UNSIGNED_INT, 0);
-	vao.Unbind();
+void Mesh::submit(InstanceBuffer* instances, GLsizei instanceCount) {
+	if (instances && instanceCount == 0) return;
+
+	// LODs are consecutive ranges of the same EBO
+	size_t firstIndex = lods.empty() ? 0 : lods[currentLod].indexOffset;
+	size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	size_t indexOffset = firstIndex * indexSize;
+	GLint baseVertex = 0;
+
+	if (arena) {
+		// the arena VAO stays bound across meshes
+		const GeometryBlock& block = arena->getBlock(arenaHandle);
+		arena->Bind();
+		indexOffset += block.indexOffset;
+		baseVertex = block.getBaseVertex(arena->getStride());
+	}
+	else {
+		if (!vao) setupVertexArray();
+		vao->Bind();
+	}
 
-}
\ No newline at end of file
+	// layouts without color read the constant attribute value
+	if (!format.includeColor) glVertexAttrib4f(2, 1.0f, 1.0f, 1.0f, 1.0f);
+
+	// material index of the draw, or of each instance
+	bool perInstanceMaterials = instances && instanceMaterials && instanceMaterialCount >= size_t(instanceCount);
+	if (materialIndex >= 0 && !perInstanceMaterials) MaterialLibrary::setDrawMaterial(materialIndex);
+
+	// Draw the actual mesh
+	if (instances) {
+		instances->link();
+		if (perInstanceMaterials) MaterialLibrary::linkInstanceMaterials(instanceMaterials->ID);
+		if (arena)
+			glDrawElementsInstancedBaseVertex(drawMode, getDrawIndexCount(), indexType,
+				(void*)indexOffset, instanceCount, baseVertex);
+		else
+			glDrawElementsInstanced(drawMode, getDrawIndexCount(), indexType,
+				(void*)indexOffset, instanceCount);
+		InstanceBuffer::unlink();
+		if (perInstanceMaterials) MaterialLibrary::unlinkInstanceMaterials();
+	}
+	else {
+		InstanceBuffer::setDefaultIdentity();
+		if (arena)
+			glDrawElementsBaseVertex(drawMode, getDrawIndexCount(), indexType, (void*)indexOffset, baseVertex);
+		else
+			glDrawElements(drawMode, getDrawIndexCount(), indexType, (void*)indexOffset);
+	}
+	// the VAO stays bound, GLState skips rebinding it for the next draw
+}
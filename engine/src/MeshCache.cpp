@@ -0,0 +1,410 @@
+#include "engine/MeshCache.h"
+#include <fstream>
+#include <filesystem>
+#include <set>
+#include <mutex>
+#include <cstring>
+#include <cstdio>
+#include <type_traits>
+namespace fs = std::filesystem;
+
+namespace {
+
+    const char MAGIC[4] = { 'E', 'M', 'S', 'H' };
+    const size_t ALIGNMENT = 16;
+
+    // On-disk layout: header, mesh/texture/embedded/LOD/instance tables, payload
+    struct FileHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t vertexStride;
+        uint32_t importFlags;
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        uint64_t settingsHash;
+        uint32_t meshCount;
+        uint32_t textureCount;
+        uint32_t embeddedCount;
+        uint32_t lodCount;
+        uint32_t instanceCount;
+        uint32_t reserved;
+    };
+
+    struct MeshRecord {
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        float aabbMin[3];
+        float aabbMax[3];
+        uint32_t firstTexture;
+        uint32_t textureCount;
+        uint32_t firstLod;
+        uint32_t lodCount;
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+    };
+
+    struct TextureRecord {
+        uint64_t stringOffset; // type string followed by key string
+        uint32_t typeLength;
+        uint32_t keyLength;
+        uint32_t slot;
+        uint32_t fallback;
+    };
+
+    struct EmbeddedRecord {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct LodRecord {
+        uint32_t indexOffset;
+        uint32_t indexCount;
+        float error;
+        uint32_t reserved;
+    };
+
+    // column-major model matrix
+    struct InstanceRecord {
+        float matrix[16];
+    };
+
+    static_assert(std::is_trivially_copyable<Vertex>::value, "Vertex must be trivially copyable");
+    static_assert(sizeof(Vertex) == 11 * sizeof(float), "Vertex must be tightly packed");
+
+    size_t alignUp(size_t v) {
+        return (v + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+
+    uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // Texture::type is a raw pointer, so strings read back need static storage.
+    // Models load on several threads (AsyncModelLoader), hence the lock; set
+    // nodes never move, so returned pointers stay valid after it is released.
+    const char* internTextureType(const std::string& type) {
+        static const char* known[] = { "diffuse", "specular", "normal" };
+        for (const char* k : known) {
+            if (type == k) return k;
+        }
+        static std::mutex othersMutex;
+        static std::set<std::string> others;
+        std::lock_guard<std::mutex> lock(othersMutex);
+        return others.insert(type).first->c_str();
+    }
+
+    bool inRange(uint64_t offset, uint64_t size, size_t fileSize) {
+        return offset <= fileSize && size <= fileSize - offset;
+    }
+
+} // namespace
+
+std::string MeshCache::cachePathFor(const std::string& sourcePath, const MeshCacheKey& key) {
+    // loads with different options get files of their own instead of
+    // overwriting each other's cache
+    uint64_t hash = fnv1a(key.settingsHash, &key.importFlags, sizeof(key.importFlags));
+    char name[32];
+    std::snprintf(name, sizeof(name), ".%08x.meshcache", uint32_t(hash ^ (hash >> 32)));
+    return sourcePath + name;
+}
+
+bool MeshCache::makeKey(const std::string& sourcePath, uint32_t importFlags,
+    const std::vector<std::string>& skipNames, MeshCacheKey& key, uint32_t pipelineFlags) {
+    std::error_code ec;
+    uint64_t size = fs::file_size(sourcePath, ec);
+    if (ec) return false;
+    auto time = fs::last_write_time(sourcePath, ec);
+    if (ec) return false;
+
+    key.sourceSize = size;
+    key.sourceTime = static_cast<int64_t>(time.time_since_epoch().count());
+    key.importFlags = importFlags;
+
+    // hash pipeline, path and skip list, separated so {"ab"} and {"a","b"} differ
+    uint64_t hash = 14695981039346656037ull;
+    hash = fnv1a(hash, &pipelineFlags, sizeof(pipelineFlags));
+    hash = fnv1a(hash, sourcePath.data(), sourcePath.size());
+    for (const auto& s : skipNames) {
+        hash = fnv1a(hash, "\0", 1);
+        hash = fnv1a(hash, s.data(), s.size());
+    }
+    key.settingsHash = hash;
+    return true;
+}
+
+bool MeshCache::write(const std::string& cachePath, const MeshCacheKey& key,
+    const std::vector<MeshData>& meshes, const std::vector<EmbeddedTexture>& embedded) {
+
+    size_t textureCount = 0, lodCount = 0, instanceCount = 0;
+    for (const auto& m : meshes) {
+        textureCount += m.textures.size();
+        lodCount += m.lods.size();
+        instanceCount += m.instances.size();
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.vertexStride = sizeof(Vertex);
+    header.importFlags = key.importFlags;
+    header.sourceSize = key.sourceSize;
+    header.sourceTime = key.sourceTime;
+    header.settingsHash = key.settingsHash;
+    header.meshCount = static_cast<uint32_t>(meshes.size());
+    header.textureCount = static_cast<uint32_t>(textureCount);
+    header.embeddedCount = static_cast<uint32_t>(embedded.size());
+    header.lodCount = static_cast<uint32_t>(lodCount);
+    header.instanceCount = static_cast<uint32_t>(instanceCount);
+
+    // lay out the payload after the tables
+    size_t cursor = alignUp(sizeof(FileHeader)
+        + meshes.size() * sizeof(MeshRecord)
+        + textureCount * sizeof(TextureRecord)
+        + embedded.size() * sizeof(EmbeddedRecord)
+        + lodCount * sizeof(LodRecord)
+        + instanceCount * sizeof(InstanceRecord));
+
+    std::vector<MeshRecord> meshRecords;
+    std::vector<LodRecord> lodRecords;
+    std::vector<InstanceRecord> instanceRecords;
+    std::vector<TextureRecord> textureRecords;
+    std::vector<EmbeddedRecord> embeddedRecords;
+    meshRecords.reserve(meshes.size());
+    textureRecords.reserve(textureCount);
+
+    for (const auto& m : meshes) {
+        MeshRecord r{};
+        r.vertexCount = static_cast<uint32_t>(m.vertices.size());
+        r.indexCount = static_cast<uint32_t>(m.indices.size());
+        r.vertexOffset = cursor;
+        cursor = alignUp(cursor + m.vertices.size() * sizeof(Vertex));
+        r.indexOffset = cursor;
+        cursor = alignUp(cursor + m.indices.size() * sizeof(GLuint));
+        for (int i = 0; i < 3; ++i) {
+            r.aabbMin[i] = m.aabbMin[i];
+            r.aabbMax[i] = m.aabbMax[i];
+        }
+        r.firstTexture = static_cast<uint32_t>(textureRecords.size());
+        r.textureCount = static_cast<uint32_t>(m.textures.size());
+        r.firstLod = static_cast<uint32_t>(lodRecords.size());
+        r.lodCount = static_cast<uint32_t>(m.lods.size());
+        r.firstInstance = static_cast<uint32_t>(instanceRecords.size());
+        r.instanceCount = static_cast<uint32_t>(m.instances.size());
+        meshRecords.push_back(r);
+
+        for (const auto& t : m.instances) {
+            InstanceRecord ir;
+            std::memcpy(ir.matrix, &t[0][0], sizeof(ir.matrix));
+            instanceRecords.push_back(ir);
+        }
+
+        for (const auto& l : m.lods) lodRecords.push_back({ l.indexOffset, l.indexCount, l.error, 0 });
+
+        for (const auto& t : m.textures) {
+            TextureRecord tr{};
+            tr.typeLength = static_cast<uint32_t>(std::strlen(t.type));
+            tr.keyLength = static_cast<uint32_t>(t.key.size());
+            tr.slot = t.slot;
+            tr.fallback = t.fallback ? 1u : 0u;
+            textureRecords.push_back(tr);
+        }
+    }
+    // strings are packed together after the geometry
+    for (auto& tr : textureRecords) {
+        tr.stringOffset = cursor;
+        cursor += tr.typeLength + tr.keyLength;
+    }
+    cursor = alignUp(cursor);
+    for (const auto& e : embedded) {
+        EmbeddedRecord er{};
+        er.offset = cursor;
+        er.size = e.size;
+        embeddedRecords.push_back(er);
+        cursor = alignUp(cursor + e.size);
+    }
+
+    // write to a temporary file and swap it in, so readers never see a partial cache
+    std::string tmpPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+
+        size_t written = 0;
+        auto put = [&](const void* data, size_t size) {
+            out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+            written += size;
+        };
+        auto pad = [&]() {
+            static const char zeros[ALIGNMENT] = {};
+            put(zeros, alignUp(written) - written);
+        };
+
+        put(&header, sizeof(header));
+        put(meshRecords.data(), meshRecords.size() * sizeof(MeshRecord));
+        put(textureRecords.data(), textureRecords.size() * sizeof(TextureRecord));
+        put(embeddedRecords.data(), embeddedRecords.size() * sizeof(EmbeddedRecord));
+        put(lodRecords.data(), lodRecords.size() * sizeof(LodRecord));
+        put(instanceRecords.data(), instanceRecords.size() * sizeof(InstanceRecord));
+        pad();
+
+        for (const auto& m : meshes) {
+            put(m.vertices.data(), m.vertices.size() * sizeof(Vertex));
+            pad();
+            put(m.indices.data(), m.indices.size() * sizeof(GLuint));
+            pad();
+        }
+        for (const auto& m : meshes) {
+            for (const auto& t : m.textures) {
+                put(t.type, std::strlen(t.type));
+                put(t.key.data(), t.key.size());
+            }
+        }
+        pad();
+        for (const auto& e : embedded) {
+            put(e.data, e.size);
+            pad();
+        }
+
+        if (!out) {
+            out.close();
+            std::error_code ec;
+            fs::remove(tmpPath, ec);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tmpPath, cachePath, ec);
+    if (ec) {
+        // some platforms refuse to rename over an existing file
+        fs::remove(cachePath, ec);
+        fs::rename(tmpPath, cachePath, ec);
+    }
+    return !ec;
+}
+
+bool MeshCache::open(const std::string& cachePath, const MeshCacheKey& key) {
+    close();
+    if (!file.open(cachePath)) return false;
+
+    const unsigned char* base = file.data();
+    const size_t size = file.size();
+
+    FileHeader header;
+    if (size < sizeof(header)) { close(); return false; }
+    std::memcpy(&header, base, sizeof(header));
+
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header.version != VERSION ||
+        header.vertexStride != sizeof(Vertex) ||
+        header.importFlags != key.importFlags ||
+        header.sourceSize != key.sourceSize ||
+        header.sourceTime != key.sourceTime ||
+        header.settingsHash != key.settingsHash) {
+        close();
+        return false;
+    }
+
+    // validate the tables before trusting any offsets
+    uint64_t tablesSize = uint64_t(header.meshCount) * sizeof(MeshRecord)
+        + uint64_t(header.textureCount) * sizeof(TextureRecord)
+        + uint64_t(header.embeddedCount) * sizeof(EmbeddedRecord)
+        + uint64_t(header.lodCount) * sizeof(LodRecord)
+        + uint64_t(header.instanceCount) * sizeof(InstanceRecord);
+    if (!inRange(sizeof(FileHeader), tablesSize, size)) { close(); return false; }
+
+    const unsigned char* cursor = base + sizeof(FileHeader);
+    std::vector<MeshRecord> meshRecords(header.meshCount);
+    std::memcpy(meshRecords.data(), cursor, meshRecords.size() * sizeof(MeshRecord));
+    cursor += meshRecords.size() * sizeof(MeshRecord);
+    std::vector<TextureRecord> textureRecords(header.textureCount);
+    std::memcpy(textureRecords.data(), cursor, textureRecords.size() * sizeof(TextureRecord));
+    cursor += textureRecords.size() * sizeof(TextureRecord);
+    std::vector<EmbeddedRecord> embeddedRecords(header.embeddedCount);
+    std::memcpy(embeddedRecords.data(), cursor, embeddedRecords.size() * sizeof(EmbeddedRecord));
+    cursor += embeddedRecords.size() * sizeof(EmbeddedRecord);
+    std::vector<LodRecord> lodRecords(header.lodCount);
+    std::memcpy(lodRecords.data(), cursor, lodRecords.size() * sizeof(LodRecord));
+    cursor += lodRecords.size() * sizeof(LodRecord);
+    std::vector<InstanceRecord> instanceRecords(header.instanceCount);
+    std::memcpy(instanceRecords.data(), cursor, instanceRecords.size() * sizeof(InstanceRecord));
+
+    meshes.reserve(meshRecords.size());
+    for (const auto& r : meshRecords) {
+        if (!inRange(r.vertexOffset, uint64_t(r.vertexCount) * sizeof(Vertex), size) ||
+            !inRange(r.indexOffset, uint64_t(r.indexCount) * sizeof(GLuint), size) ||
+            r.vertexOffset % alignof(Vertex) != 0 || r.indexOffset % alignof(GLuint) != 0 ||
+            uint64_t(r.firstTexture) + r.textureCount > textureRecords.size() ||
+            uint64_t(r.firstLod) + r.lodCount > lodRecords.size() ||
+            uint64_t(r.firstInstance) + r.instanceCount > instanceRecords.size()) {
+            close();
+            return false;
+        }
+
+        // out of range indices would reach the GPU and index remap tables
+        const GLuint* indices = reinterpret_cast<const GLuint*>(base + r.indexOffset);
+        for (uint32_t i = 0; i < r.indexCount; ++i) {
+            if (indices[i] >= r.vertexCount) {
+                close();
+                return false;
+            }
+        }
+
+        CachedMesh m;
+        m.vertices = reinterpret_cast<const Vertex*>(base + r.vertexOffset);
+        m.vertexCount = r.vertexCount;
+        m.indices = indices;
+        m.indexCount = r.indexCount;
+        m.aabbMin = glm::vec3(r.aabbMin[0], r.aabbMin[1], r.aabbMin[2]);
+        m.aabbMax = glm::vec3(r.aabbMax[0], r.aabbMax[1], r.aabbMax[2]);
+
+        for (uint32_t i = 0; i < r.lodCount; ++i) {
+            const LodRecord& lr = lodRecords[r.firstLod + i];
+            if (uint64_t(lr.indexOffset) + lr.indexCount > r.indexCount) {
+                close();
+                return false;
+            }
+            m.lods.push_back({ lr.indexOffset, lr.indexCount, lr.error });
+        }
+        for (uint32_t i = 0; i < r.instanceCount; ++i) {
+            glm::mat4 t;
+            std::memcpy(&t[0][0], instanceRecords[r.firstInstance + i].matrix, sizeof(float) * 16);
+            m.instances.push_back(t);
+        }
+
+        for (uint32_t i = 0; i < r.textureCount; ++i) {
+            const TextureRecord& tr = textureRecords[r.firstTexture + i];
+            if (!inRange(tr.stringOffset, uint64_t(tr.typeLength) + tr.keyLength, size)) {
+                close();
+                return false;
+            }
+            const char* str = reinterpret_cast<const char*>(base + tr.stringOffset);
+            MeshTextureRef ref;
+            ref.type = internTextureType(std::string(str, tr.typeLength));
+            ref.key.assign(str + tr.typeLength, tr.keyLength);
+            ref.fallback = tr.fallback != 0;
+            ref.slot = tr.slot;
+            m.textures.push_back(std::move(ref));
+        }
+        meshes.push_back(std::move(m));
+    }
+
+    for (const auto& er : embeddedRecords) {
+        if (!inRange(er.offset, er.size, size)) { close(); return false; }
+        embedded.push_back({ base + er.offset, static_cast<size_t>(er.size) });
+    }
+    return true;
+}
+
+void MeshCache::close() {
+    meshes.clear();
+    embedded.clear();
+    file.close();
+}
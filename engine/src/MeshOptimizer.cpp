@@ -0,0 +1,290 @@
+#include "engine/MeshOptimizer.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+    // Forsyth scoring constants, tuned for a 32-entry LRU cache
+    const int CACHE_SIZE = 32;
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float LAST_TRI_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    float vertexScore(int cachePos, unsigned remaining) {
+        // no triangles left to emit, this vertex no longer matters
+        if (remaining == 0) return -1.0f;
+
+        float score = 0.0f;
+        if (cachePos >= 0) {
+            // vertices of the last triangle get a fixed score so the next one
+            // does not just reuse the same edge
+            if (cachePos < 3) {
+                score = LAST_TRI_SCORE;
+            }
+            else {
+                float s = 1.0f - float(cachePos - 3) / float(CACHE_SIZE - 3);
+                score = std::pow(s, CACHE_DECAY_POWER);
+            }
+        }
+        // favour vertices with few triangles left, to finish them off
+        score += VALENCE_BOOST_SCALE * std::pow(float(remaining), -VALENCE_BOOST_POWER);
+        return score;
+    }
+
+    // FIFO cache simulation that can be cleared in O(1) by advancing time
+    struct FifoCache {
+        std::vector<unsigned> stamp;
+        unsigned time = 0;
+        unsigned size;
+
+        FifoCache(size_t vertexCount, unsigned cacheSize)
+            : stamp(vertexCount, 0), time(cacheSize + 1), size(cacheSize) {}
+
+        // returns true on a miss
+        bool access(GLuint v) {
+            if (time - stamp[v] >= size) {
+                stamp[v] = time++;
+                return true;
+            }
+            return false;
+        }
+        void clear() { time += size + 1; }
+    };
+
+} // namespace
+
+VertexCacheStats MeshOptimizer::analyzeVertexCache(const GLuint* indices, size_t indexCount,
+    size_t vertexCount, unsigned cacheSize) {
+    VertexCacheStats stats;
+    stats.triangles = indexCount / 3;
+    if (stats.triangles == 0 || vertexCount == 0) return stats;
+
+    FifoCache cache(vertexCount, cacheSize);
+    for (size_t i = 0; i < stats.triangles * 3; ++i) {
+        if (cache.access(indices[i])) ++stats.transformed;
+    }
+    stats.acmr = float(stats.transformed) / float(stats.triangles);
+    stats.atvr = float(stats.transformed) / float(vertexCount);
+    return stats;
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<GLuint>& indices, size_t vertexCount) {
+    const size_t triCount = indices.size() / 3;
+    if (triCount == 0 || vertexCount == 0) return;
+
+    // vertex -> triangles adjacency, the live ones are kept at the front of each range
+    std::vector<unsigned> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triCount * 3; ++i) ++remaining[indices[i]];
+
+    std::vector<size_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + remaining[v];
+
+    std::vector<unsigned> adjacency(triCount * 3);
+    {
+        std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t t = 0; t < triCount; ++t) {
+            for (int k = 0; k < 3; ++k) adjacency[fill[indices[t * 3 + k]]++] = static_cast<unsigned>(t);
+        }
+    }
+
+    std::vector<int> cachePos(vertexCount, -1);
+    std::vector<float> vScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) vScore[v] = vertexScore(-1, remaining[v]);
+
+    std::vector<float> tScore(triCount);
+    std::vector<char> emitted(triCount, 0);
+    long best = -1;
+    float bestScore = -1.0f;
+    for (size_t t = 0; t < triCount; ++t) {
+        tScore[t] = vScore[indices[t * 3]] + vScore[indices[t * 3 + 1]] + vScore[indices[t * 3 + 2]];
+        if (tScore[t] > bestScore) {
+            bestScore = tScore[t];
+            best = static_cast<long>(t);
+        }
+    }
+
+    std::vector<GLuint> out;
+    out.reserve(triCount * 3);
+    std::vector<GLuint> cache, newCache;
+    cache.reserve(CACHE_SIZE + 3);
+    newCache.reserve(CACHE_SIZE + 3);
+    size_t scanCursor = 0;
+
+    for (size_t emittedCount = 0; emittedCount < triCount; ++emittedCount) {
+        // nothing adjacent to the cache: continue with the next triangle in input order
+        if (best < 0) {
+            while (emitted[scanCursor]) ++scanCursor;
+            best = static_cast<long>(scanCursor);
+        }
+
+        const size_t t = static_cast<size_t>(best);
+        const GLuint tri[3] = { indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2] };
+        out.insert(out.end(), tri, tri + 3);
+        emitted[t] = 1;
+
+        // drop the triangle from its vertices' live lists
+        for (GLuint v : tri) {
+            size_t begin = offsets[v];
+            size_t end = begin + remaining[v];
+            for (size_t i = begin; i < end; ++i) {
+                if (adjacency[i] == t) {
+                    std::swap(adjacency[i], adjacency[end - 1]);
+                    --remaining[v];
+                    break;
+                }
+            }
+        }
+
+        // move the triangle's vertices to the front of the LRU cache
+        newCache.clear();
+        for (GLuint v : tri) {
+            if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) newCache.push_back(v);
+        }
+        for (GLuint v : cache) {
+            if (v != tri[0] && v != tri[1] && v != tri[2]) newCache.push_back(v);
+        }
+
+        for (size_t i = 0; i < newCache.size(); ++i) {
+            GLuint v = newCache[i];
+            cachePos[v] = i < size_t(CACHE_SIZE) ? static_cast<int>(i) : -1;
+            vScore[v] = vertexScore(cachePos[v], remaining[v]);
+        }
+
+        // rescore triangles touching the cache (including evicted vertices) and pick the best
+        best = -1;
+        bestScore = -1.0f;
+        for (GLuint v : newCache) {
+            size_t begin = offsets[v];
+            size_t end = begin + remaining[v];
+            for (size_t i = begin; i < end; ++i) {
+                unsigned adj = adjacency[i];
+                float score = vScore[indices[adj * 3]] + vScore[indices[adj * 3 + 1]] + vScore[indices[adj * 3 + 2]];
+                tScore[adj] = score;
+                if (score > bestScore) {
+                    bestScore = score;
+                    best = static_cast<long>(adj);
+                }
+            }
+        }
+
+        if (newCache.size() > size_t(CACHE_SIZE)) newCache.resize(CACHE_SIZE);
+        cache.swap(newCache);
+    }
+
+    // keep any trailing indices that did not form a triangle
+    out.insert(out.end(), indices.begin() + triCount * 3, indices.end());
+    indices.swap(out);
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<GLuint>& indices,
+    const std::vector<Vertex>& vertices, float threshold) {
+    const size_t triCount = indices.size() / 3;
+    if (triCount < 2 || vertices.empty()) return;
+
+    const unsigned cacheSize = 16;
+    FifoCache cache(vertices.size(), cacheSize);
+
+    // hard boundaries: triangles whose three vertices all miss the cache
+    std::vector<size_t> hard;
+    for (size_t t = 0; t < triCount; ++t) {
+        int misses = 0;
+        for (int k = 0; k < 3; ++k) misses += cache.access(indices[t * 3 + k]) ? 1 : 0;
+        if (t == 0 || misses == 3) hard.push_back(t);
+    }
+    hard.push_back(triCount);
+
+    // soft boundaries: split a hard cluster wherever its running ACMR is
+    // already within threshold of the whole cluster's ACMR
+    std::vector<size_t> clusters;
+    for (size_t h = 0; h + 1 < hard.size(); ++h) {
+        size_t start = hard[h], end = hard[h + 1];
+
+        cache.clear();
+        size_t clusterMisses = 0;
+        for (size_t i = start * 3; i < end * 3; ++i) clusterMisses += cache.access(indices[i]) ? 1 : 0;
+        float clusterAcmr = float(clusterMisses) / float(end - start);
+
+        cache.clear();
+        size_t misses = 0;
+        clusters.push_back(start);
+        for (size_t t = start; t < end; ++t) {
+            for (int k = 0; k < 3; ++k) misses += cache.access(indices[t * 3 + k]) ? 1 : 0;
+            float acmr = float(misses) / float(t - clusters.back() + 1);
+            if (t + 1 < end && acmr <= clusterAcmr * threshold) {
+                clusters.push_back(t + 1);
+                cache.clear();
+                misses = 0;
+            }
+        }
+    }
+    clusters.push_back(triCount);
+
+    // mesh centroid, area weighted
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t t = 0; t < triCount; ++t) {
+        const glm::vec3& a = vertices[indices[t * 3]].position;
+        const glm::vec3& b = vertices[indices[t * 3 + 1]].position;
+        const glm::vec3& c = vertices[indices[t * 3 + 2]].position;
+        float area = glm::length(glm::cross(b - a, c - a));
+        meshCentroid += (a + b + c) * (area / 3.0f);
+        meshArea += area;
+    }
+    if (meshArea > 0.0f) meshCentroid /= meshArea;
+
+    // sort clusters so those facing away from the centre (likely occluders) come first
+    struct Cluster { size_t start, end; float sortKey; };
+    std::vector<Cluster> sorted;
+    for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+            const glm::vec3& a = vertices[indices[t * 3]].position;
+            const glm::vec3& b = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& cc = vertices[indices[t * 3 + 2]].position;
+            glm::vec3 n = glm::cross(b - a, cc - a);
+            float triArea = glm::length(n);
+            centroid += (a + b + cc) * (triArea / 3.0f);
+            normal += n;
+            area += triArea;
+        }
+        if (area > 0.0f) centroid /= area;
+        float len = glm::length(normal);
+        float key = len > 0.0f ? glm::dot(centroid - meshCentroid, normal / len) : 0.0f;
+        sorted.push_back({ clusters[c], clusters[c + 1], key });
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+        [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+    std::vector<GLuint> out;
+    out.reserve(indices.size());
+    for (const auto& c : sorted) {
+        out.insert(out.end(), indices.begin() + c.start * 3, indices.begin() + c.end * 3);
+    }
+    out.insert(out.end(), indices.begin() + triCount * 3, indices.end());
+    indices.swap(out);
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices) {
+    const GLuint unused = ~0u;
+    std::vector<GLuint> remap(vertices.size(), unused);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+
+    for (GLuint& idx : indices) {
+        if (remap[idx] == unused) {
+            remap[idx] = static_cast<GLuint>(reordered.size());
+            reordered.push_back(vertices[idx]);
+        }
+        idx = remap[idx];
+    }
+    vertices.swap(reordered);
+}
+
+void MeshOptimizer::optimize(std::vector<Vertex>& vertices, std::vector<GLuint>& indices) {
+    optimizeVertexCache(indices, vertices.size());
+    optimizeOverdraw(indices, vertices);
+    optimizeVertexFetch(vertices, indices);
+}
@@ -0,0 +1,264 @@
+#include "engine/MeshSimplifier.h"
+#include "engine/MeshOptimizer.h"
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+
+namespace {
+
+    // Levels stop once they would drop below this many triangles
+    const size_t MIN_LOD_TRIANGLES = 16;
+
+    // Symmetric 4x4 quadric of the squared distance to a set of planes
+    struct Quadric {
+        double a2 = 0, ab = 0, ac = 0, ad = 0;
+        double b2 = 0, bc = 0, bd = 0;
+        double c2 = 0, cd = 0;
+        double d2 = 0;
+
+        void addPlane(const glm::dvec3& n, double d) {
+            a2 += n.x * n.x; ab += n.x * n.y; ac += n.x * n.z; ad += n.x * d;
+            b2 += n.y * n.y; bc += n.y * n.z; bd += n.y * d;
+            c2 += n.z * n.z; cd += n.z * d;
+            d2 += d * d;
+        }
+        void add(const Quadric& q) {
+            a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+            b2 += q.b2; bc += q.bc; bd += q.bd;
+            c2 += q.c2; cd += q.cd;
+            d2 += q.d2;
+        }
+        double eval(const glm::vec3& p) const {
+            double x = p.x, y = p.y, z = p.z;
+            double r = a2 * x * x + b2 * y * y + c2 * z * z
+                + 2.0 * (ab * x * y + ac * x * z + bc * y * z)
+                + 2.0 * (ad * x + bd * y + cd * z) + d2;
+            return r > 0.0 ? r : 0.0;
+        }
+    };
+
+    struct PositionHash {
+        size_t operator()(const glm::vec3& p) const {
+            uint32_t bits[3];
+            std::memcpy(bits, &p, sizeof(bits));
+            return size_t(bits[0]) * 73856093u ^ size_t(bits[1]) * 19349663u ^ size_t(bits[2]) * 83492791u;
+        }
+    };
+
+    uint64_t edgeKey(GLuint a, GLuint b) {
+        if (a > b) std::swap(a, b);
+        return (uint64_t(a) << 32) | b;
+    }
+
+    struct Collapse {
+        GLuint from, to; // position ids
+        double cost;
+    };
+
+} // namespace
+
+std::vector<GLuint> MeshSimplifier::simplify(const std::vector<Vertex>& vertices,
+    const std::vector<GLuint>& indices, size_t targetIndexCount,
+    float maxError, float* resultError) {
+    std::vector<GLuint> tris(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+    if (resultError) *resultError = 0.0f;
+    if (tris.size() <= targetIndexCount || vertices.empty()) return tris;
+
+    // vertices sharing a position (split by normals/UVs) collapse together
+    const size_t vertexCount = vertices.size();
+    std::vector<GLuint> pid(vertexCount);
+    std::vector<glm::vec3> positions;
+    {
+        std::unordered_map<glm::vec3, GLuint, PositionHash> ids;
+        ids.reserve(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v) {
+            auto it = ids.emplace(vertices[v].position, static_cast<GLuint>(positions.size()));
+            if (it.second) positions.push_back(vertices[v].position);
+            pid[v] = it.first->second;
+        }
+    }
+    const size_t posCount = positions.size();
+
+    // plane quadrics, and borders / non-manifold edges which stay locked
+    std::vector<Quadric> quadrics(posCount);
+    std::vector<char> locked(posCount, 0);
+    {
+        std::unordered_map<uint64_t, unsigned> edgeUse;
+        edgeUse.reserve(tris.size());
+        for (size_t t = 0; t < tris.size(); t += 3) {
+            GLuint p[3] = { pid[tris[t]], pid[tris[t + 1]], pid[tris[t + 2]] };
+            glm::dvec3 a(positions[p[0]]), b(positions[p[1]]), c(positions[p[2]]);
+            glm::dvec3 n = glm::cross(b - a, c - a);
+            double len = glm::length(n);
+            if (len > 0.0) {
+                n /= len;
+                for (GLuint q : p) quadrics[q].addPlane(n, -glm::dot(n, a));
+            }
+            for (int k = 0; k < 3; ++k) {
+                if (p[k] != p[(k + 1) % 3]) ++edgeUse[edgeKey(p[k], p[(k + 1) % 3])];
+            }
+        }
+        for (const auto& e : edgeUse) {
+            if (e.second != 2) {
+                locked[GLuint(e.first >> 32)] = 1;
+                locked[GLuint(e.first & 0xFFFFFFFFu)] = 1;
+            }
+        }
+    }
+
+    const double maxCost = double(maxError) * double(maxError);
+    double worstCost = 0.0;
+
+    std::vector<size_t> adjOffsets(posCount + 1);
+    std::vector<GLuint> adjacency;
+    std::vector<uint64_t> edges;
+    std::vector<Collapse> collapses;
+    std::vector<char> touched(posCount);
+    std::vector<GLuint> vremap(vertexCount);
+    std::vector<std::pair<GLuint, GLuint>> wedgeMap;
+
+    while (tris.size() > targetIndexCount) {
+        const size_t triCount = tris.size() / 3;
+
+        // position -> triangles
+        std::fill(adjOffsets.begin(), adjOffsets.end(), 0);
+        for (GLuint v : tris) ++adjOffsets[pid[v] + 1];
+        for (size_t p = 0; p < posCount; ++p) adjOffsets[p + 1] += adjOffsets[p];
+        adjacency.resize(tris.size());
+        {
+            std::vector<size_t> fill(adjOffsets.begin(), adjOffsets.end() - 1);
+            for (size_t i = 0; i < tris.size(); ++i) adjacency[fill[pid[tris[i]]]++] = GLuint(i / 3);
+        }
+
+        // unique edges, each costed in its cheaper valid direction
+        edges.clear();
+        for (size_t t = 0; t < tris.size(); t += 3) {
+            for (int k = 0; k < 3; ++k) edges.push_back(edgeKey(pid[tris[t + k]], pid[tris[t + (k + 1) % 3]]));
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        collapses.clear();
+        for (uint64_t e : edges) {
+            GLuint a = GLuint(e >> 32), b = GLuint(e & 0xFFFFFFFFu);
+            Quadric q = quadrics[a];
+            q.add(quadrics[b]);
+            double costAB = locked[a] ? DBL_MAX : q.eval(positions[b]);
+            double costBA = locked[b] ? DBL_MAX : q.eval(positions[a]);
+            if (costAB == DBL_MAX && costBA == DBL_MAX) continue;
+            if (costAB <= costBA) collapses.push_back({ a, b, costAB });
+            else collapses.push_back({ b, a, costBA });
+        }
+        std::sort(collapses.begin(), collapses.end(),
+            [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        std::fill(touched.begin(), touched.end(), 0);
+        for (size_t v = 0; v < vertexCount; ++v) vremap[v] = GLuint(v);
+
+        size_t removed = 0;
+        const size_t wanted = triCount - targetIndexCount / 3;
+        for (const Collapse& c : collapses) {
+            if (c.cost > maxCost || removed >= wanted) break;
+            if (touched[c.from] || touched[c.to]) continue;
+
+            // each wedge of `from` must slide onto a wedge of `to` along a shared triangle
+            wedgeMap.clear();
+            size_t sharedTris = 0;
+            for (size_t i = adjOffsets[c.from]; i < adjOffsets[c.from + 1]; ++i) {
+                const GLuint* tri = &tris[size_t(adjacency[i]) * 3];
+                int ka = -1, kb = -1;
+                for (int k = 0; k < 3; ++k) {
+                    if (pid[tri[k]] == c.from) ka = k;
+                    else if (pid[tri[k]] == c.to) kb = k;
+                }
+                if (ka < 0 || kb < 0) continue;
+                ++sharedTris;
+                bool known = false;
+                for (const auto& m : wedgeMap) known |= m.first == tri[ka];
+                if (!known) wedgeMap.push_back({ tri[ka], tri[kb] });
+            }
+
+            bool valid = sharedTris > 0;
+            for (size_t i = adjOffsets[c.from]; valid && i < adjOffsets[c.from + 1]; ++i) {
+                const GLuint* tri = &tris[size_t(adjacency[i]) * 3];
+                glm::vec3 p[3];
+                bool hasTo = false;
+                for (int k = 0; k < 3; ++k) {
+                    p[k] = positions[pid[tri[k]]];
+                    hasTo |= pid[tri[k]] == c.to;
+                }
+                // a wedge with no path to `to` would smear attributes across a seam
+                for (int k = 0; k < 3; ++k) {
+                    if (pid[tri[k]] != c.from) continue;
+                    bool mapped = false;
+                    for (const auto& m : wedgeMap) mapped |= m.first == tri[k];
+                    if (!mapped) valid = false;
+                }
+                if (!valid || hasTo) continue;
+
+                // reject collapses that flip a surviving triangle
+                glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                for (int k = 0; k < 3; ++k) {
+                    if (pid[tri[k]] == c.from) p[k] = positions[c.to];
+                }
+                glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+                if (glm::dot(before, after) <= 0.0f) valid = false;
+            }
+            if (!valid) continue;
+
+            for (const auto& m : wedgeMap) vremap[m.first] = m.second;
+            quadrics[c.to].add(quadrics[c.from]);
+            // freeze the neighbourhood so flip checks stay valid within this pass
+            for (size_t i = adjOffsets[c.from]; i < adjOffsets[c.from + 1]; ++i) {
+                const GLuint* tri = &tris[size_t(adjacency[i]) * 3];
+                for (int k = 0; k < 3; ++k) touched[pid[tri[k]]] = 1;
+            }
+            removed += sharedTris;
+            worstCost = std::max(worstCost, c.cost);
+        }
+        if (removed == 0) break;
+
+        // apply the collapses and drop triangles that became degenerate
+        size_t write = 0;
+        for (size_t t = 0; t < tris.size(); t += 3) {
+            GLuint a = vremap[tris[t]], b = vremap[tris[t + 1]], c = vremap[tris[t + 2]];
+            if (pid[a] == pid[b] || pid[b] == pid[c] || pid[a] == pid[c]) continue;
+            tris[write++] = a;
+            tris[write++] = b;
+            tris[write++] = c;
+        }
+        tris.resize(write);
+    }
+
+    if (resultError) *resultError = static_cast<float>(std::sqrt(worstCost));
+    return tris;
+}
+
+void MeshSimplifier::buildLodChain(const std::vector<Vertex>& vertices, std::vector<GLuint>& indices,
+    std::vector<MeshLod>& lods, size_t maxLevels, float reduction, bool optimizeLevels) {
+    lods.clear();
+    lods.push_back({ 0, static_cast<GLuint>(indices.size()), 0.0f });
+    maxLevels = std::min(maxLevels, MAX_LODS);
+
+    std::vector<GLuint> current(indices);
+    float error = 0.0f;
+    for (size_t level = 1; level < maxLevels; ++level) {
+        size_t target = size_t(float(current.size() / 3) * reduction) * 3;
+        if (target < MIN_LOD_TRIANGLES * 3) break;
+
+        float levelError = 0.0f;
+        std::vector<GLuint> next = simplify(vertices, current, target, FLT_MAX, &levelError);
+        // locked borders/seams can stall the simplifier, a level must actually be cheaper
+        if (next.size() * 10 > current.size() * 9) break;
+
+        if (optimizeLevels) MeshOptimizer::optimizeVertexCache(next, vertices.size());
+        // each level is simplified from the previous one, so deviations add up
+        error += levelError;
+        lods.push_back({ static_cast<GLuint>(indices.size()), static_cast<GLuint>(next.size()), error });
+        indices.insert(indices.end(), next.begin(), next.end());
+        current.swap(next);
+    }
+}
@@ -1,5 +1,11 @@
 #include "engine/Model.h"
 #include "engine/Shader.h"
+#include "engine/Camera.h"
+#include "engine/OcclusionCuller.h"
+#include "engine/ThreadPool.h"
+#include "engine/MeshOptimizer.h"
+#include "engine/MeshSimplifier.h"
+#include "engine/TextureRegistry.h"
 #include <iostream>
 #include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
@@ -11,6 +17,7 @@
 
 #include <filesystem>
 #include <algorithm>
+#include <chrono>
 namespace fs = std::filesystem;
 
 static std::string toLower(std::string s) {
@@ -38,6 +45,20 @@ static std::string findFirstMatchingTexture(
     return "";
 }
 
+// LOD statistics of the current frame (drawing happens on the context thread)
+static LodStats lodStats;
+
+// engine-side processing folded into the mesh cache key
+static uint32_t pipelineFlags(const ModelOptions& o) {
+    uint32_t flags = o.optimizeIndices ? 1u : 0u;
+    if (o.generateLods) {
+        flags |= 2u;
+        flags |= uint32_t(std::min<size_t>(o.lodLevels, 255)) << 8;
+        flags |= uint32_t(glm::clamp(o.lodReduction, 0.0f, 1.0f) * 255.0f) << 16;
+    }
+    return flags;
+}
+
 // helper to extract model path
 static std::string getModelDirectory(const std::string& modelPath) {
     size_t lastSlash = modelPath.find_last_of("/\\");
@@ -58,17 +79,47 @@ Model::Model(const std::string& path, const std::vector<std::string>& skipNames)
     loadModel(path);
 }
 
-void Model::setPosition(const glm::vec3& pos) { position = pos; }
+// Constructor with explicit loading options
+Model::Model(const std::string& path, const ModelOptions& opts,
+    const std::vector<std::string>& skipNames)
+    : options(opts), meshNameSkips(skipNames) {
+    loadModel(path);
+}
+
+Model::~Model() {
+    if (sceneIndex) sceneIndex->remove(sceneProxy);
+}
+
+unsigned int Model::importFlags(bool preserveHierarchy) {
+    unsigned int flags =
+        aiProcess_Triangulate           | // Ensures all faces are triangles
+        aiProcess_GenNormals            | // Generates normals if missing
+        aiProcess_JoinIdenticalVertices;  // Optimizes geometry
+    if (preserveHierarchy) return flags; // meshes stay shared between nodes
+    return flags |
+        aiProcess_PreTransformVertices  | // Bake node transforms into vertices
+        aiProcess_OptimizeMeshes; // Merge tiny meshes to reduce draw calls
+}
+
+void Model::setPosition(const glm::vec3& pos) {
+    position = pos;
+    transformChanged();
+}
 
 void Model::setRotation(float angleDeg, const glm::vec3& axis) {
     rotation = glm::angleAxis(glm::radians(angleDeg), glm::normalize(axis));
+    transformChanged();
 }
 
-void Model::setScale(const glm::vec3& s) { scale = s; }
+void Model::setScale(const glm::vec3& s) {
+    scale = s;
+    transformChanged();
+}
 
 // Quaternion handling
 void Model::setRotationQuat(const glm::quat& q) {
     rotation = glm::normalize(q);
+    transformChanged();
 }
 
 glm::quat Model::getRotationQuat() const {
@@ -77,6 +128,23 @@ glm::quat Model::getRotationQuat() const {
 
 void Model::setRotationEuler(float pitchDeg, float yawDeg, float rollDeg, RotationOrder order) {
     rotation = glm::normalize(MathUtils::eulerToQuat(pitchDeg, yawDeg, rollDeg, order));
+    transformChanged();
+}
+
+void Model::getWorldAABB(glm::vec3& outMin, glm::vec3& outMax) const {
+    // nothing loaded: a point at the model's position
+    if (aabbMin.x > aabbMax.x) {
+        outMin = outMax = position;
+        return;
+    }
+    MathUtils::transformAABB(aabbMin, aabbMax, getModelMatrix(), outMin, outMax);
+}
+
+void Model::transformChanged() {
+    if (!sceneIndex) return;
+    glm::vec3 worldMin, worldMax;
+    getWorldAABB(worldMin, worldMax);
+    sceneIndex->update(sceneProxy, worldMin, worldMax);
 }
 
 void Model::Draw(Shader& shader) {
@@ -84,27 +152,271 @@ void Model::Draw(Shader& shader) {
     glm::mat4 computedMatrix = getModelMatrix();  // Compute TRS from components
     // draws each mesh onto scene
     for (auto& mesh : meshes) {
-        // combine model transform with mesh
-        glm::mat4 finalMatrix = computedMatrix * mesh->getModelMatrix();
-        // export the finalMatrix to the Vertex Shader of model
-        shader.setMat4("model", finalMatrix);
-        // issue the actual draw for this mesh
-        mesh->Draw(shader);
+        drawMesh(shader, *mesh, computedMatrix * mesh->getModelMatrix());
+    }
+    GeometryArena::Unbind();
+}
+
+void Model::Draw(Shader& shader, const Camera& camera, const OcclusionCuller* occlusion) {
+    if (meshes.empty()) return; // guard
+    prepareVisible(camera, occlusion);
+    glm::mat4 computedMatrix = getModelMatrix();
+    for (size_t i : visibleMeshes) {
+        Mesh& mesh = *meshes[i];
+        drawMesh(shader, mesh, computedMatrix * mesh.getModelMatrix());
+    }
+    GeometryArena::Unbind();
+}
+
+void Model::Submit(RenderQueue& queue, Shader& shader, const Camera& camera,
+    const OcclusionCuller* occlusion, RenderPass pass) {
+    if (meshes.empty()) return; // guard
+    prepareVisible(camera, occlusion);
+    glm::mat4 computedMatrix = getModelMatrix();
+    for (size_t i : visibleMeshes) {
+        Mesh& mesh = *meshes[i];
+        glm::vec3 center = (meshWorldMin[i] + meshWorldMax[i]) * 0.5f;
+        queue.submit(mesh, shader, meshUniform(mesh, computedMatrix * mesh.getModelMatrix()),
+            glm::length(center - camera.Position), pass);
+        countDrawn(mesh);
+    }
+}
+
+void Model::prepareVisible(const Camera& camera, const OcclusionCuller* occlusion) {
+    glm::mat4 computedMatrix = getModelMatrix();
+    // screen pixels covered by one world unit at distance 1
+    float pixelsPerUnit = camera.height * 0.5f / std::tan(glm::radians(camera.FOV) * 0.5f);
+
+    meshWorldMin.resize(meshes.size());
+    meshWorldMax.resize(meshes.size());
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        meshWorldBounds(*meshes[i], computedMatrix * meshes[i]->getModelMatrix(),
+            meshWorldMin[i], meshWorldMax[i]);
+    }
+    // test every mesh in one batch before drawing any
+    if (frustumCulling) {
+        culler.clear();
+        culler.reserve(meshes.size());
+        for (size_t i = 0; i < meshes.size(); ++i) culler.add(meshWorldMin[i], meshWorldMax[i]);
+        culler.cull(camera.getFrustum(), meshVisible);
     }
+
+    visibleMeshes.clear();
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        Mesh* mesh = meshes[i].get();
+        if (frustumCulling && !meshVisible[i]) {
+            ++lodStats.meshesCulled;
+            continue;
+        }
+        if (occlusion && !occlusion->isVisible(meshWorldMin[i], meshWorldMax[i])) {
+            ++lodStats.meshesOccluded;
+            continue;
+        }
+        selectLod(*mesh, computedMatrix * mesh->getModelMatrix(), camera.Position, pixelsPerUnit);
+        visibleMeshes.push_back(i);
+    }
+}
+
+void Model::DrawInstanced(Shader& shader, const glm::mat4* transforms, size_t count) {
+    if (meshes.empty() || count == 0) return;
+    if (!instanceScratch) instanceScratch = std::make_unique<InstanceBuffer>(count);
+    instanceScratch->update(transforms, count);
+    DrawInstanced(shader, *instanceScratch);
+}
+
+void Model::DrawInstanced(Shader& shader, InstanceBuffer& instances) {
+    const size_t copies = instances.getCount();
+    if (meshes.empty() || copies == 0) return;
+
+    for (auto& mesh : meshes) {
+        const auto& nodes = mesh->getInstanceTransforms();
+        size_t drawn = copies;
+        if (nodes.empty()) {
+            // the copy transform streams per instance, the mesh part stays a uniform
+            shader.setModelMatrix(mesh->getModelMatrix() * mesh->dequantizeMatrix);
+            mesh->DrawInstanced(shader, instances);
+        }
+        else {
+            // every copy times every node using the mesh, with the mesh's own
+            // transform in between like Draw's instance parent
+            const auto& copyTransforms = instances.getTransforms();
+            const glm::mat4& meshMatrix = mesh->getModelMatrix();
+            nestedTransforms.resize(copies * nodes.size());
+            for (size_t c = 0; c < copies; ++c) {
+                const glm::mat4 parent = copyTransforms[c] * meshMatrix;
+                for (size_t n = 0; n < nodes.size(); ++n)
+                    nestedTransforms[c * nodes.size() + n] = parent * nodes[n];
+            }
+            if (!nestedScratch) nestedScratch = std::make_unique<InstanceBuffer>(nestedTransforms.size());
+            nestedScratch->update(nestedTransforms);
+            shader.setModelMatrix(mesh->dequantizeMatrix);
+            mesh->DrawInstanced(shader, *nestedScratch);
+            drawn = nestedTransforms.size();
+        }
+
+        ++lodStats.meshesDrawn;
+        lodStats.instancesDrawn += drawn;
+        lodStats.trianglesDrawn += size_t(mesh->getDrawIndexCount()) / 3 * drawn;
+        lodStats.trianglesFull += size_t(mesh->indexCount) / 3 * drawn;
+        ++lodStats.meshesPerLod[mesh->currentLod];
+    }
+    GeometryArena::Unbind();
+}
+
+glm::mat4 Model::meshUniform(Mesh& mesh, const glm::mat4& meshMatrix) {
+    // combine model transform with mesh (and its position dequantization)
+    if (mesh.getInstanceTransforms().empty()) return meshMatrix * mesh.dequantizeMatrix;
+    // node instances carry the placement, re-uploaded only when the model moves
+    mesh.setInstanceParent(meshMatrix);
+    return mesh.dequantizeMatrix;
+}
+
+void Model::drawMesh(Shader& shader, Mesh& mesh, const glm::mat4& meshMatrix) {
+    // export the final matrix to the Vertex Shader of model
+    shader.setModelMatrix(meshUniform(mesh, meshMatrix));
+    // issue the actual draw for this mesh
+    mesh.Draw(shader);
+    countDrawn(mesh);
+}
+
+void Model::countDrawn(const Mesh& mesh) {
+    size_t instances = std::max<size_t>(1, mesh.getInstanceTransforms().size());
+    ++lodStats.meshesDrawn;
+    lodStats.instancesDrawn += instances;
+    lodStats.trianglesDrawn += size_t(mesh.getDrawIndexCount()) / 3 * instances;
+    lodStats.trianglesFull += size_t(mesh.indexCount) / 3 * instances;
+    ++lodStats.meshesPerLod[mesh.currentLod];
+}
+
+void Model::meshWorldBounds(const Mesh& mesh, const glm::mat4& meshMatrix,
+    glm::vec3& outMin, glm::vec3& outMax) const {
+    const auto& nodes = mesh.getInstanceTransforms();
+    if (nodes.empty()) {
+        MathUtils::transformAABB(mesh.aabbMin, mesh.aabbMax, meshMatrix, outMin, outMax);
+        return;
+    }
+    outMin = glm::vec3(std::numeric_limits<float>::max());
+    outMax = glm::vec3(-std::numeric_limits<float>::max());
+    for (const auto& t : nodes) {
+        glm::vec3 placedMin, placedMax;
+        MathUtils::transformAABB(mesh.aabbMin, mesh.aabbMax, meshMatrix * t, placedMin, placedMax);
+        outMin = glm::min(outMin, placedMin);
+        outMax = glm::max(outMax, placedMax);
+    }
+}
+
+void Model::selectLod(Mesh& mesh, const glm::mat4& meshMatrix,
+    const glm::vec3& cameraPos, float pixelsPerUnit) {
+    if (mesh.lods.size() < 2) return;
+
+    // world space bounding sphere of the mesh, instanced meshes use the nearest instance
+    const glm::vec3& localCenter = mesh.sphereCenter;
+    float localRadius = mesh.sphereRadius;
+    float distance = std::numeric_limits<float>::max();
+    float scale = 1.0f;
+    auto measure = [&](const glm::mat4& m) {
+        glm::vec3 center = glm::vec3(m * glm::vec4(localCenter, 1.0f));
+        float s = std::max(std::max(glm::length(glm::vec3(m[0])),
+            glm::length(glm::vec3(m[1]))), glm::length(glm::vec3(m[2])));
+        float d = glm::length(center - cameraPos) - localRadius * s;
+        if (d < distance) {
+            distance = d;
+            scale = s;
+        }
+    };
+    if (mesh.getInstanceTransforms().empty()) {
+        measure(meshMatrix);
+    }
+    else {
+        for (const auto& t : mesh.getInstanceTransforms()) measure(meshMatrix * t);
+    }
+
+    size_t lod = mesh.currentLod;
+    if (distance <= 0.0f) {
+        lod = 0; // camera inside the bounds
+    }
+    else {
+        // model space error -> pixels at the nearest point of the sphere
+        float errorToPixels = scale * pixelsPerUnit / distance;
+        // refine while the current level is visibly too coarse
+        while (lod > 0 && mesh.lods[lod].error * errorToPixels > lodPixelError * (1.0f + lodHysteresis))
+            --lod;
+        // coarsen while the next level stays clearly under the threshold
+        while (lod + 1 < mesh.lods.size() &&
+            mesh.lods[lod + 1].error * errorToPixels <= lodPixelError * (1.0f - lodHysteresis))
+            ++lod;
+    }
+
+    if (lod != mesh.currentLod) {
+        mesh.currentLod = lod;
+        ++lodStats.lodSwitches;
+    }
+}
+
+void Model::setLodThreshold(float pixelError, float hysteresis) {
+    lodPixelError = pixelError;
+    lodHysteresis = glm::clamp(hysteresis, 0.0f, 0.9f);
+}
+
+LodStats Model::getLodStats() {
+    return lodStats;
+}
+
+void Model::resetLodStats() {
+    lodStats = LodStats();
+}
+
+size_t Model::getGeometryBytes() const {
+    size_t bytes = 0;
+    for (const auto& mesh : meshes) bytes += mesh->vertexBytes + mesh->indexBytes;
+    return bytes;
 }
 
 void Model::loadModel(const std::string& path) {
+    auto startTime = std::chrono::steady_clock::now();
+    auto elapsedMs = [&]() {
+        return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - startTime).count();
+    };
+
+    unsigned int flags = importFlags(options.preserveHierarchy);
+
+    // warm load: map the cache and upload straight from it
+    MeshCacheKey cacheKey;
+    bool cacheable = options.useMeshCache &&
+        MeshCache::makeKey(path, flags, meshNameSkips, cacheKey, pipelineFlags(options));
+    std::string cachePath = MeshCache::cachePathFor(path, cacheKey);
+
+    if (cacheable) {
+        MeshCache cache;
+        if (cache.open(cachePath, cacheKey)) {
+            modelPath = path;
+            directory = getModelDirectory(path);
+            texturesDir = directory + "textures/";
+
+            embeddedTextures = cache.getEmbeddedTextures();
+            const auto& cached = cache.getMeshes();
+            std::vector<const std::vector<MeshTextureRef>*> refs;
+            for (const auto& m : cached) refs.push_back(&m.textures);
+            auto textures = LoadTextures(refs);
+
+            for (size_t i = 0; i < cached.size(); ++i) {
+                const CachedMesh& m = cached[i];
+                createMesh(m.vertices, m.vertexCount, m.indices, m.indexCount,
+                    m.aabbMin, m.aabbMax, m.lods, m.instances, textures[i]);
+            }
+            embeddedTextures.clear();
+            loaded = true;
+
+            std::cout << "[Model] Loaded " << path << " from mesh cache in "
+                << elapsedMs() << " ms\n";
+            return;
+        }
+    }
+
     // create Assimp importer
     Assimp::Importer importer;
 
-    // import flags
-    unsigned int flags =
-        aiProcess_Triangulate           | // Ensures all faces are triangles
-        aiProcess_GenNormals            | // Generates normals if missing
-        aiProcess_JoinIdenticalVertices |  // Optimizes geometry
-        aiProcess_PreTransformVertices  | // Bake node transforms into vertices
-        aiProcess_OptimizeMeshes; // Merge tiny meshes to reduce draw calls
-
     // import the 3D model file
     const aiScene* scene = importer.ReadFile(path, flags);
 
@@ -120,7 +432,118 @@ void Model::loadModel(const std::string& path) {
 
 
     // begin recursively processing the model hierarchy
-    processNode(scene->mRootNode, scene);
+    std::vector<aiMesh*> sceneMeshes;
+    std::vector<std::vector<glm::mat4>> sceneInstances;
+    if (options.preserveHierarchy) {
+        std::unordered_map<aiMesh*, size_t> seen;
+        processNodeInstanced(scene->mRootNode, scene, glm::mat4(1.0f), seen, sceneMeshes, sceneInstances);
+    }
+    else {
+        processNode(scene->mRootNode, scene, sceneMeshes);
+    }
+
+    // CPU phase: convert each aiMesh independently, results keep traversal order
+    std::vector<MeshData> meshData(sceneMeshes.size());
+    std::vector<VertexCacheStats> cacheBefore(sceneMeshes.size()), cacheAfter(sceneMeshes.size());
+    auto convert = [&](size_t i) {
+        meshData[i] = processMesh(sceneMeshes[i]);
+        if (options.preserveHierarchy) meshData[i].instances = std::move(sceneInstances[i]);
+        if (options.optimizeIndices) {
+            MeshData& m = meshData[i];
+            cacheBefore[i] = MeshOptimizer::analyzeVertexCache(m.indices.data(), m.indices.size(), m.vertices.size());
+            MeshOptimizer::optimize(m.vertices, m.indices);
+            cacheAfter[i] = MeshOptimizer::analyzeVertexCache(m.indices.data(), m.indices.size(), m.vertices.size());
+        }
+        if (options.generateLods) {
+            MeshData& m = meshData[i];
+            MeshSimplifier::buildLodChain(m.vertices, m.indices, m.lods,
+                options.lodLevels, options.lodReduction, options.optimizeIndices);
+        }
+    };
+    if (options.parallelImport) {
+        ThreadPool::shared().parallelFor(sceneMeshes.size(), convert);
+    }
+    else {
+        for (size_t i = 0; i < sceneMeshes.size(); ++i) convert(i);
+    }
+
+    // texture references, collected on this thread so the material log stays
+    // in order and the fallback folder is scanned at most once per model
+    std::vector<MeshTextureRef> fallbackTextures;
+    bool fallbackScanned = false;
+    for (size_t i = 0; i < sceneMeshes.size(); ++i) {
+        std::vector<MeshTextureRef>& textures = meshData[i].textures;
+        if (sceneMeshes[i]->mMaterialIndex >= 0)
+            AttachTextures(textures, scene->mMaterials[sceneMeshes[i]->mMaterialIndex]);
+        // fallback to forced textures if none loaded
+        if (textures.empty() && scene->mNumTextures == 0) {
+            if (!fallbackScanned) {
+                fallbackTextures = FindFallbackTextures();
+                fallbackScanned = true;
+            }
+            textures = fallbackTextures;
+        }
+    }
+
+    if (options.optimizeIndices) {
+        // triangle/vertex weighted totals over all meshes
+        size_t triangles = 0, vertices = 0, missesBefore = 0, missesAfter = 0;
+        for (size_t i = 0; i < meshData.size(); ++i) {
+            triangles += cacheAfter[i].triangles;
+            vertices += meshData[i].vertices.size();
+            missesBefore += cacheBefore[i].transformed;
+            missesAfter += cacheAfter[i].transformed;
+        }
+        if (triangles > 0 && vertices > 0) {
+            std::cout << "[Model] Index optimization: ACMR "
+                << float(missesBefore) / triangles << " -> " << float(missesAfter) / triangles
+                << ", ATVR " << float(missesBefore) / vertices << " -> " << float(missesAfter) / vertices << "\n";
+        }
+    }
+
+    // compressed bytes of embedded textures, addressed as "*N"
+    for (unsigned int i = 0; i < scene->mNumTextures; ++i) {
+        const aiTexture* aiTex = scene->mTextures[i];
+        size_t size = aiTex->mHeight == 0
+            ? aiTex->mWidth
+            : size_t(aiTex->mWidth) * aiTex->mHeight * sizeof(aiTexel);
+        embeddedTextures.push_back({
+            reinterpret_cast<const unsigned char*>(aiTex->pcData), size });
+    }
+
+    // serial phase: GL objects are created on the context thread
+    std::vector<const std::vector<MeshTextureRef>*> refs;
+    for (const auto& m : meshData) refs.push_back(&m.textures);
+    auto textures = LoadTextures(refs);
+
+    for (size_t i = 0; i < meshData.size(); ++i) {
+        const MeshData& m = meshData[i];
+        createMesh(m.vertices.data(), m.vertices.size(), m.indices.data(), m.indices.size(),
+            m.aabbMin, m.aabbMax, m.lods, m.instances, textures[i]);
+    }
+
+    if (cacheable) {
+        if (MeshCache::write(cachePath, cacheKey, meshData, embeddedTextures))
+            std::cout << "[Model] Wrote mesh cache: " << cachePath << "\n";
+        else
+            std::cerr << "[Model] Could not write mesh cache: " << cachePath << "\n";
+    }
+    embeddedTextures.clear();
+    loaded = true;
+
+    if (options.preserveHierarchy) {
+        size_t instances = 0, storedVertices = 0, flattenedVertices = 0;
+        for (const auto& m : meshData) {
+            instances += m.instances.size();
+            storedVertices += m.vertices.size();
+            flattenedVertices += m.vertices.size() * m.instances.size();
+        }
+        std::cout << "[Model] " << meshData.size() << " unique meshes, " << instances
+            << " instances (" << storedVertices << " vertices stored instead of "
+            << flattenedVertices << ")\n";
+    }
+
+    std::cout << "[Model] Imported " << path << " in " << elapsedMs() << " ms\n";
 }
 
 
@@ -131,7 +554,7 @@ bool Model::shouldSkipMesh(const std::string& name) const {
     return false;
 }
 
-void Model::processNode(aiNode* node, const aiScene* scene) {
+void Model::processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& out) {
     // process all the node's meshes (if any)
     for (unsigned int i = 0; i < node->mNumMeshes; i++) {
         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
@@ -146,73 +569,101 @@ void Model::processNode(aiNode* node, const aiScene* scene) {
             continue;
         }
 
-        for (unsigned i = 0; i < mesh->mNumVertices; ++i) {
-            const aiVector3D& v = mesh->mVertices[i];
-            // expand model-space AABB
-            aabbMin.x = std::min(aabbMin.x, v.x);
-            aabbMin.y = std::min(aabbMin.y, v.y);
-            aabbMin.z = std::min(aabbMin.z, v.z);
-            aabbMax.x = std::max(aabbMax.x, v.x);
-            aabbMax.y = std::max(aabbMax.y, v.y);
-            aabbMax.z = std::max(aabbMax.z, v.z);
-        }
-
-        // store mesh
-        meshes.emplace_back(processMesh(mesh, scene));
+        // queue mesh for conversion
+        out.push_back(mesh);
     }
     // then do the same for each of its children
     for (unsigned int i = 0; i < node->mNumChildren; i++) {
-        processNode(node->mChildren[i], scene);
+        processNode(node->mChildren[i], scene, out);
     }
 }
 
+void Model::processNodeInstanced(aiNode* node, const aiScene* scene, const glm::mat4& parent,
+    std::unordered_map<aiMesh*, size_t>& seen, std::vector<aiMesh*>& out,
+    std::vector<std::vector<glm::mat4>>& instances) {
+    // aiMatrix4x4 is row-major
+    const aiMatrix4x4& t = node->mTransformation;
+    glm::mat4 local = glm::transpose(glm::mat4(
+        t.a1, t.a2, t.a3, t.a4,
+        t.b1, t.b2, t.b3, t.b4,
+        t.c1, t.c2, t.c3, t.c4,
+        t.d1, t.d2, t.d3, t.d4));
+    glm::mat4 transform = parent * local;
 
-std::shared_ptr<Texture> Model::LoadTexture(const aiString& path,
-    const char* typeName, const aiScene* scene, GLuint slot) {
-
-    std::string key = path.C_Str();
-
-    // cache hit
-    auto it = textureCache.find(key);
-    if (it != textureCache.end())
-        return it->second;
-
-    std::shared_ptr<Texture> tex;
-
-    if (!key.empty() && key[0] == '*') {
-        std::cout << "[Texture] Embedded texture detected: "
-            << key << "\n";
+    for (unsigned int i = 0; i < node->mNumMeshes; i++) {
+        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+        if (shouldSkipMesh(mesh->mName.C_Str())) continue;
+
+        // first reference converts the mesh, later ones only add a transform
+        auto it = seen.find(mesh);
+        if (it == seen.end()) {
+            it = seen.emplace(mesh, out.size()).first;
+            out.push_back(mesh);
+            instances.emplace_back();
+        }
+        instances[it->second].push_back(transform);
     }
-    else {
-        std::cout << "[Texture] External texture detected: "
-            << directory << "/" << key << "\n";
+    for (unsigned int i = 0; i < node->mNumChildren; i++) {
+        processNodeInstanced(node->mChildren[i], scene, transform, seen, out, instances);
     }
+}
 
 
-    // embedded texture
-    if (!key.empty() && key[0] == '*') {
-        int idx = std::atoi(key.c_str() + 1);
-        const aiTexture* aiTex = scene->mTextures[idx];
-
-        const unsigned char* bytes =
-            reinterpret_cast<const unsigned char*>(aiTex->pcData);
-
-        size_t size = aiTex->mWidth;
-        tex = std::make_shared<Texture>(bytes, size, typeName, slot, GL_UNSIGNED_BYTE);
+std::vector<std::vector<std::shared_ptr<Texture>>> Model::LoadTextures(
+    const std::vector<const std::vector<MeshTextureRef>*>& perMesh) {
+    // flatten every mesh's references into one registry batch
+    std::vector<TextureLoad> loads;
+    for (const auto* refs : perMesh) {
+        for (const auto& ref : *refs) {
+            TextureLoad load;
+            load.type = ref.type;
+            load.slot = ref.slot;
+            const std::string& key = ref.key;
+
+            // fallback folder textures are already full paths
+            if (ref.fallback) {
+                load.path = key;
+            }
+            // embedded texture
+            else if (!key.empty() && key[0] == '*') {
+                size_t idx = static_cast<size_t>(std::atoi(key.c_str() + 1));
+                if (idx < embeddedTextures.size()) {
+                    load.data = embeddedTextures[idx].data;
+                    load.size = embeddedTextures[idx].size;
+                }
+                else {
+                    std::cerr << "[Texture] Missing embedded texture: " << key << "\n";
+                }
+            }
+            // external texture
+            else {
+                load.path = directory + "/" + key;
+            }
+            loads.push_back(load);
+        }
     }
-    // external texture
-    else {
-        std::string fullPath = directory + "/" + key;
-        tex = std::make_shared<Texture>(fullPath.c_str(), typeName, slot, GL_UNSIGNED_BYTE);
+
+    auto start = std::chrono::steady_clock::now();
+    auto flat = TextureRegistry::instance().loadBatch(loads);
+    if (!loads.empty()) {
+        std::cout << "[Texture] Resolved " << loads.size() << " textures in "
+            << std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count() << " ms\n";
     }
 
-    textureCache[key] = tex;
-    return tex;
+    // split back per mesh, skipping references with no source
+    std::vector<std::vector<std::shared_ptr<Texture>>> result(perMesh.size());
+    size_t next = 0;
+    for (size_t m = 0; m < perMesh.size(); ++m) {
+        for (size_t i = 0; i < perMesh[m]->size(); ++i, ++next) {
+            if (flat[next]) result[m].push_back(flat[next]);
+        }
+    }
+    return result;
 }
 
 
-void Model::AttachTextures(std::vector<std::shared_ptr<Texture>>& textures,
-    aiMaterial* material, const aiScene* scene) {
+void Model::AttachTextures(std::vector<MeshTextureRef>& textures, aiMaterial* material) {
     std::cout << "\n[Material] Processing material\n";
 
     static const std::vector<std::pair<aiTextureType, const char*>> types = {
@@ -237,45 +688,47 @@ void Model::AttachTextures(std::vector<std::shared_ptr<Texture>>& textures,
                 << path.C_Str()
                 << "\" (type = " << name << ")\n";
 
-            auto tex = LoadTexture(path, name, scene, slot++);
-            textures.push_back(tex);
+            MeshTextureRef ref;
+            ref.type = name;
+            ref.key = path.C_Str();
+            ref.slot = slot++;
+            textures.push_back(ref);
         }
     }
+}
 
-	// Fallback to forced textures if none loaded
-    if (textures.empty() && scene->mNumTextures == 0) {
-        std::cout << "[Texture] No material textures; trying fallback folder\n";
-
-        std::string diffuseFile = findFirstMatchingTexture(
-            texturesDir, { "basecolor","albedo","diffuse","color" }
-        );
-        std::string normalFile = findFirstMatchingTexture(
-            texturesDir, { "normal","nrm" }
-        );
+std::vector<MeshTextureRef> Model::FindFallbackTextures() const {
+    std::vector<MeshTextureRef> textures;
+    std::cout << "[Texture] No material textures; trying fallback folder\n";
 
-        GLuint slot = 0;
+    std::string diffuseFile = findFirstMatchingTexture(
+        texturesDir, { "basecolor","albedo","diffuse","color" }
+    );
+    std::string normalFile = findFirstMatchingTexture(
+        texturesDir, { "normal","nrm" }
+    );
 
-        if (!diffuseFile.empty()) {
-            std::cout << "[Texture] Fallback diffuse: " << diffuseFile << "\n";
-            textures.push_back(std::make_shared<Texture>(
-                diffuseFile.c_str(), "diffuse", slot++, GL_UNSIGNED_BYTE));
-        }
+    GLuint slot = 0;
 
-        if (!normalFile.empty()) {
-            std::cout << "[Texture] Fallback normal: " << normalFile << "\n";
-            textures.push_back(std::make_shared<Texture>(
-                normalFile.c_str(), "normal", slot++, GL_UNSIGNED_BYTE));
-        }
+    if (!diffuseFile.empty()) {
+        std::cout << "[Texture] Fallback diffuse: " << diffuseFile << "\n";
+        textures.push_back({ "diffuse", diffuseFile, true, slot++ });
     }
 
+    if (!normalFile.empty()) {
+        std::cout << "[Texture] Fallback normal: " << normalFile << "\n";
+        textures.push_back({ "normal", normalFile, true, slot++ });
+    }
+    return textures;
 }
 
 
 
-std::shared_ptr<Mesh> Model::processMesh(aiMesh* mesh, const aiScene* scene) {
-    std::vector<Vertex> vertices;
-    std::vector<GLuint> indices;
-    std::vector<std::shared_ptr<Texture>> textures;
+MeshData Model::processMesh(aiMesh* mesh) {
+    MeshData data;
+    std::vector<Vertex>& vertices = data.vertices;
+    std::vector<GLuint>& indices = data.indices;
+    vertices.reserve(mesh->mNumVertices);
 
     // extract vertex data
     for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
@@ -283,6 +736,9 @@ std::shared_ptr<Mesh> Model::processMesh(aiMesh* mesh, const aiScene* scene) {
         
         // Vertex position
         vertex.position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+        // expand mesh-space AABB
+        data.aabbMin = glm::min(data.aabbMin, vertex.position);
+        data.aabbMax = glm::max(data.aabbMax, vertex.position);
 
         // Normals (if they exist)
         if (mesh->HasNormals())
@@ -303,19 +759,115 @@ std::shared_ptr<Mesh> Model::processMesh(aiMesh* mesh, const aiScene* scene) {
     }
 
     // process indices
+    indices.reserve(size_t(mesh->mNumFaces) * 3);
     for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-        aiFace face = mesh->mFaces[i];
+        const aiFace& face = mesh->mFaces[i];
         for (unsigned int j = 0; j < face.mNumIndices; j++) {
             indices.push_back(static_cast<GLuint>(face.mIndices[j]));
         }
     }
 
-    // process textures
-    if (mesh->mMaterialIndex >= 0) {
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-        AttachTextures(textures, material, scene);
-    }
+    // texture references are collected by loadModel after the parallel phase
+    return data;
+}
+
 
+void Model::createMesh(const Vertex* vertices, size_t vertexCount,
+    const GLuint* indices, size_t indexCount,
+    const glm::vec3& meshMin, const glm::vec3& meshMax,
+    const std::vector<MeshLod>& lods,
+    const std::vector<glm::mat4>& instances,
+    const std::vector<std::shared_ptr<Texture>>& textures) {
     // construct Mesh in place once and transfer ownership into Model
-    return std::make_shared<Mesh>(vertices, indices, textures);
-}
\ No newline at end of file
+    std::shared_ptr<Mesh> mesh;
+    bool useArena = options.useGeometryArena && !options.deferVertexArrays;
+    if (useArena && options.vertexFormat.isStandard()) {
+        mesh = std::make_shared<Mesh>(GeometryArena::forFormat(options.vertexFormat),
+            vertices, vertexCount, indices, indexCount, textures, options.optimizeIndices);
+    }
+    else if (options.vertexFormat.isStandard()) {
+        mesh = std::make_shared<Mesh>(vertices, vertexCount, indices, indexCount, textures,
+            options.deferVertexArrays, options.optimizeIndices);
+    }
+    else {
+        // re-encode into the compact layout before upload
+        glm::vec3 quantMin;
+        float quantScale;
+        std::vector<unsigned char> encoded = options.vertexFormat.encode(
+            vertices, vertexCount, meshMin, meshMax, quantMin, quantScale);
+        if (useArena) {
+            mesh = std::make_shared<Mesh>(GeometryArena::forFormat(options.vertexFormat),
+                encoded.data(), vertexCount, indices, indexCount, textures, options.optimizeIndices);
+        }
+        else {
+            mesh = std::make_shared<Mesh>(encoded.data(), vertexCount, options.vertexFormat,
+                indices, indexCount, textures, options.deferVertexArrays, options.optimizeIndices);
+        }
+        mesh->dequantizeMatrix = glm::translate(glm::mat4(1.0f), quantMin)
+            * glm::scale(glm::mat4(1.0f), glm::vec3(quantScale));
+    }
+    mesh->aabbMin = meshMin;
+    mesh->aabbMax = meshMax;
+    // sphere around the box center through the farthest vertex, tighter than the half diagonal
+    mesh->sphereCenter = (meshMin + meshMax) * 0.5f;
+    float radiusSq = 0.0f;
+    for (size_t i = 0; i < vertexCount; ++i) {
+        glm::vec3 d = vertices[i].position - mesh->sphereCenter;
+        radiusSq = std::max(radiusSq, glm::dot(d, d));
+    }
+    mesh->sphereRadius = std::sqrt(radiusSq);
+    if (!lods.empty()) mesh->setLods(lods);
+    // a mesh used by a single node keeps a plain draw with the node transform
+    if (instances.size() == 1) mesh->setModelMatrix(instances[0]);
+    else if (instances.size() > 1) mesh->setInstances(instances);
+    meshes.push_back(mesh);
+    if (options.occluder) addOccluderGeometry(vertices, vertexCount, indices, indexCount, lods, instances);
+
+    // expand model-space AABB
+    if (vertexCount == 0) return;
+    if (instances.empty()) {
+        aabbMin = glm::min(aabbMin, meshMin);
+        aabbMax = glm::max(aabbMax, meshMax);
+    }
+    for (const auto& t : instances) {
+        glm::vec3 placedMin, placedMax;
+        MathUtils::transformAABB(meshMin, meshMax, t, placedMin, placedMax);
+        aabbMin = glm::min(aabbMin, placedMin);
+        aabbMax = glm::max(aabbMax, placedMax);
+    }
+}
+void Model::addOccluderGeometry(const Vertex* vertices, size_t vertexCount,
+    const GLuint* indices, size_t indexCount, const std::vector<MeshLod>& lods,
+    const std::vector<glm::mat4>& instances) {
+    // coarsest LOD when there is a chain, otherwise simplify now
+    std::vector<GLuint> coarse;
+    if (lods.size() > 1) {
+        const MeshLod& last = lods.back();
+        coarse.assign(indices + last.indexOffset, indices + last.indexOffset + last.indexCount);
+    }
+    else {
+        coarse.assign(indices, indices + indexCount);
+    }
+    std::vector<Vertex> vertexCopy;
+    if (coarse.size() > options.occluderTriangles * 3) {
+        vertexCopy.assign(vertices, vertices + vertexCount);
+        coarse = MeshSimplifier::simplify(vertexCopy, coarse, options.occluderTriangles * 3);
+    }
+
+    // only the referenced positions, once per node transform
+    std::vector<GLuint> remap(vertexCount, ~0u);
+    std::vector<glm::vec3> used;
+    for (GLuint& index : coarse) {
+        if (remap[index] == ~0u) {
+            remap[index] = static_cast<GLuint>(used.size());
+            used.push_back(vertices[index].position);
+        }
+        index = remap[index];
+    }
+    const std::vector<glm::mat4> identity(1, glm::mat4(1.0f));
+    for (const auto& t : instances.empty() ? identity : instances) {
+        GLuint base = static_cast<GLuint>(occluderPositions.size());
+        for (const auto& p : used) occluderPositions.push_back(glm::vec3(t * glm::vec4(p, 1.0f)));
+        for (GLuint index : coarse) occluderIndices.push_back(base + index);
+    }
+}
@@ -0,0 +1,280 @@
+#include "engine/OcclusionCuller.h"
+#include "engine/Model.h"
+#include "engine/ThreadPool.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ENGINE_OCCLUSION_SSE 1
+#endif
+
+namespace {
+
+    // rows rasterized by one task
+    const int BAND_HEIGHT = 16;
+    // clip w below this is treated as behind the camera
+    const float MIN_W = 1e-4f;
+
+} // namespace
+
+OcclusionCuller::OcclusionCuller(int w, int h)
+    : width(std::max(4, (w + 3) & ~3)), height(std::max(1, h)) {
+    depth.assign(size_t(width) * height, 1.0f);
+}
+
+void OcclusionCuller::beginFrame(const glm::mat4& vp) {
+    viewProjection = vp;
+    std::fill(depth.begin(), depth.end(), 1.0f);
+    occluders.clear();
+    stats = OcclusionStats();
+}
+
+void OcclusionCuller::addOccluder(const glm::vec3* positions, const uint32_t* indices, size_t indexCount,
+    const glm::mat4& transform) {
+    if (indexCount < 3) return;
+    Occluder o;
+    o.positions = positions;
+    o.indices = indices;
+    o.indexCount = indexCount - indexCount % 3;
+    o.transform = viewProjection * transform;
+    o.firstTriangle = 0;
+    occluders.push_back(o);
+}
+
+void OcclusionCuller::addOccluder(const Model& model) {
+    const auto& indices = model.getOccluderIndices();
+    if (indices.empty()) return;
+    addOccluder(model.getOccluderPositions().data(), indices.data(), indices.size(), model.getModelMatrix());
+}
+
+bool OcclusionCuller::setupTriangle(const glm::vec4 clip[3], Triangle& t) const {
+    // triangles reaching in front of the near plane are dropped (the GPU would
+    // clip that part away), occluders may only under-occlude
+    glm::vec3 v[3];
+    for (int i = 0; i < 3; ++i) {
+        if (clip[i].w < MIN_W || clip[i].z < -clip[i].w) return false;
+        float invW = 1.0f / clip[i].w;
+        v[i] = glm::vec3((clip[i].x * invW * 0.5f + 0.5f) * width,
+            (clip[i].y * invW * 0.5f + 0.5f) * height,
+            clip[i].z * invW * 0.5f + 0.5f);
+    }
+    if (v[0].z > 1.0f && v[1].z > 1.0f && v[2].z > 1.0f) return false;
+
+    // either winding is fine (walls are often single sided), make it counter-clockwise
+    float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+    if (std::fabs(area) < 1e-6f) return false;
+    if (area < 0.0f) {
+        std::swap(v[1], v[2]);
+        area = -area;
+    }
+
+    t.minX = std::max(0, int(std::floor(std::min(std::min(v[0].x, v[1].x), v[2].x))));
+    t.maxX = std::min(width - 1, int(std::ceil(std::max(std::max(v[0].x, v[1].x), v[2].x))));
+    t.minY = std::max(0, int(std::floor(std::min(std::min(v[0].y, v[1].y), v[2].y))));
+    t.maxY = std::min(height - 1, int(std::ceil(std::max(std::max(v[0].y, v[1].y), v[2].y))));
+    if (t.minX > t.maxX || t.minY > t.maxY) return false;
+
+    // edge i runs from v[i] to v[i + 1], the opposite vertex is v[i + 2]
+    for (int i = 0; i < 3; ++i) {
+        const glm::vec3& a = v[i];
+        const glm::vec3& b = v[(i + 1) % 3];
+        t.ea[i] = a.y - b.y;
+        t.eb[i] = b.x - a.x;
+        t.ec[i] = -(t.ea[i] * a.x + t.eb[i] * a.y);
+    }
+    // barycentric weight of v[i] is edge (i + 1) over the area
+    float invArea = 1.0f / area;
+    t.za = (t.ea[1] * v[0].z + t.ea[2] * v[1].z + t.ea[0] * v[2].z) * invArea;
+    t.zb = (t.eb[1] * v[0].z + t.eb[2] * v[1].z + t.eb[0] * v[2].z) * invArea;
+    t.zc = (t.ec[1] * v[0].z + t.ec[2] * v[1].z + t.ec[0] * v[2].z) * invArea;
+    return true;
+}
+
+void OcclusionCuller::rasterize() {
+    auto start = std::chrono::steady_clock::now();
+    ThreadPool& pool = ThreadPool::shared();
+
+    size_t triangleCount = 0;
+    for (auto& o : occluders) {
+        o.firstTriangle = triangleCount;
+        triangleCount += o.indexCount / 3;
+    }
+    triangles.resize(triangleCount);
+    stats.occluderTriangles = triangleCount;
+
+    // transform and set up every triangle, one task per occluder
+    pool.parallelFor(occluders.size(), [&](size_t i) {
+        const Occluder& o = occluders[i];
+        for (size_t k = 0; k < o.indexCount; k += 3) {
+            glm::vec4 clip[3];
+            for (int j = 0; j < 3; ++j)
+                clip[j] = o.transform * glm::vec4(o.positions[o.indices[k + j]], 1.0f);
+            Triangle& t = triangles[o.firstTriangle + k / 3];
+            t.valid = setupTriangle(clip, t);
+        }
+    });
+    for (const auto& t : triangles) stats.rasterizedTriangles += t.valid ? 1 : 0;
+
+    // bands own disjoint rows, so no two tasks write the same pixel
+    int bands = (height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+    pool.parallelFor(size_t(bands), [&](size_t band) {
+        int rowBegin = int(band) * BAND_HEIGHT;
+        rasterizeBand(rowBegin, std::min(height, rowBegin + BAND_HEIGHT));
+    });
+
+    buildPyramid();
+    stats.rasterMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+void OcclusionCuller::rasterizeBand(int rowBegin, int rowEnd) {
+    for (const Triangle& t : triangles) {
+        if (!t.valid || t.maxY < rowBegin || t.minY >= rowEnd) continue;
+        int yBegin = std::max(t.minY, rowBegin);
+        int yEnd = std::min(t.maxY + 1, rowEnd);
+        // 4-aligned so SIMD steps never cross the row end (width is a multiple of 4)
+        int xBegin = t.minX & ~3;
+
+        for (int y = yBegin; y < yEnd; ++y) {
+            float py = y + 0.5f;
+            float* row = &depth[size_t(y) * width];
+#if defined(ENGINE_OCCLUSION_SSE)
+            __m128 e0 = _mm_set1_ps(t.eb[0] * py + t.ec[0]);
+            __m128 e1 = _mm_set1_ps(t.eb[1] * py + t.ec[1]);
+            __m128 e2 = _mm_set1_ps(t.eb[2] * py + t.ec[2]);
+            __m128 zRow = _mm_set1_ps(t.zb * py + t.zc);
+            __m128 a0 = _mm_set1_ps(t.ea[0]), a1 = _mm_set1_ps(t.ea[1]), a2 = _mm_set1_ps(t.ea[2]);
+            __m128 za = _mm_set1_ps(t.za);
+            __m128 zero = _mm_setzero_ps();
+            for (int x = xBegin; x <= t.maxX; x += 4) {
+                float fx = x + 0.5f;
+                __m128 px = _mm_add_ps(_mm_set1_ps(fx), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+                __m128 inside = _mm_and_ps(_mm_and_ps(
+                    _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), e0), zero),
+                    _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), e1), zero)),
+                    _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), e2), zero));
+                if (_mm_movemask_ps(inside) == 0) continue;
+                // every vertex is past the near plane, the clamp only absorbs rounding
+                __m128 z = _mm_max_ps(_mm_add_ps(_mm_mul_ps(za, px), zRow), zero);
+                __m128 d = _mm_loadu_ps(row + x);
+                __m128 write = _mm_and_ps(inside, _mm_cmplt_ps(z, d));
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(write, z), _mm_andnot_ps(write, d)));
+            }
+#else
+            for (int x = xBegin; x <= t.maxX; ++x) {
+                float px = x + 0.5f;
+                if (t.ea[0] * px + t.eb[0] * py + t.ec[0] < 0.0f ||
+                    t.ea[1] * px + t.eb[1] * py + t.ec[1] < 0.0f ||
+                    t.ea[2] * px + t.eb[2] * py + t.ec[2] < 0.0f) continue;
+                // every vertex is past the near plane, the clamp only absorbs rounding
+                float z = std::max(t.za * px + t.zb * py + t.zc, 0.0f);
+                if (z < row[x]) row[x] = z;
+            }
+#endif
+        }
+    }
+}
+
+void OcclusionCuller::buildPyramid() {
+    if (pyramid.empty()) {
+        glm::ivec2 size(width, height);
+        pyramidSize.push_back(size);
+        while (size.x > 1 || size.y > 1) {
+            size = glm::ivec2((size.x + 1) / 2, (size.y + 1) / 2);
+            pyramidSize.push_back(size);
+        }
+        pyramid.resize(pyramidSize.size());
+        for (size_t l = 0; l < pyramid.size(); ++l)
+            pyramid[l].resize(size_t(pyramidSize[l].x) * pyramidSize[l].y);
+    }
+
+    pyramid[0] = depth;
+    for (size_t l = 1; l < pyramid.size(); ++l) {
+        const std::vector<float>& src = pyramid[l - 1];
+        std::vector<float>& dst = pyramid[l];
+        glm::ivec2 s = pyramidSize[l - 1], d = pyramidSize[l];
+        // farthest of the (up to) 2x2 children, so a texel never hides more than its pixels do
+        for (int y = 0; y < d.y; ++y) {
+            int y0 = 2 * y, y1 = std::min(2 * y + 1, s.y - 1);
+            for (int x = 0; x < d.x; ++x) {
+                int x0 = 2 * x, x1 = std::min(2 * x + 1, s.x - 1);
+                dst[size_t(y) * d.x + x] = std::max(
+                    std::max(src[size_t(y0) * s.x + x0], src[size_t(y0) * s.x + x1]),
+                    std::max(src[size_t(y1) * s.x + x0], src[size_t(y1) * s.x + x1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::isVisible(const glm::vec3& worldMin, const glm::vec3& worldMax) const {
+    ++stats.tested;
+    if (pyramid.empty()) return true;
+
+    // screen rectangle and nearest depth of the box
+    glm::vec2 rectMin(std::numeric_limits<float>::max());
+    glm::vec2 rectMax(-std::numeric_limits<float>::max());
+    float nearest = std::numeric_limits<float>::max();
+    for (int i = 0; i < 8; ++i) {
+        glm::vec3 corner((i & 1) ? worldMax.x : worldMin.x,
+            (i & 2) ? worldMax.y : worldMin.y,
+            (i & 4) ? worldMax.z : worldMin.z);
+        glm::vec4 clip = viewProjection * glm::vec4(corner, 1.0f);
+        if (clip.w < MIN_W || clip.z < -clip.w) return true;
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        glm::vec2 screen((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height);
+        rectMin = glm::min(rectMin, screen);
+        rectMax = glm::max(rectMax, screen);
+        nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+    }
+
+    // off screen boxes are left to frustum culling
+    int x0 = std::max(0, int(std::floor(rectMin.x)));
+    int y0 = std::max(0, int(std::floor(rectMin.y)));
+    int x1 = std::min(width - 1, int(std::floor(rectMax.x)));
+    int y1 = std::min(height - 1, int(std::floor(rectMax.y)));
+    if (x0 > x1 || y0 > y1) return true;
+
+    // coarsest level where the rectangle still spans at most about 4x4 texels
+    size_t level = 0;
+    int extent = std::max(x1 - x0, y1 - y0);
+    while ((extent >> level) > 3 && level + 1 < pyramid.size()) ++level;
+
+    const std::vector<float>& texels = pyramid[level];
+    int levelWidth = pyramidSize[level].x;
+    for (int y = y0 >> level; y <= (y1 >> level); ++y) {
+        for (int x = x0 >> level; x <= (x1 >> level); ++x) {
+            if (nearest <= texels[size_t(y) * levelWidth + x]) return true;
+        }
+    }
+    ++stats.occluded;
+    return false;
+}
+
+bool OcclusionCuller::selfTest() {
+    // 90 degree camera at the origin looking down -z, near plane at 0.1
+    OcclusionCuller culler(64, 64);
+    glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+    culler.beginFrame(projection);
+    const uint32_t quad[] = { 0, 1, 2, 0, 2, 3 };
+
+    // wall facing the camera at z = -2, a box behind it is hidden
+    const glm::vec3 wall[] = { { -1.0f, -1.0f, -2.0f }, { 1.0f, -1.0f, -2.0f },
+        { 1.0f, 1.0f, -2.0f }, { -1.0f, 1.0f, -2.0f } };
+    culler.addOccluder(wall, quad, 6, glm::mat4(1.0f));
+    // side wall at x = 0.05 running from z = -0.01 (in front of the near plane)
+    // to z = -10. In front of the near plane it would cover the right edge of
+    // the screen, which the GPU clips away.
+    const glm::vec3 side[] = { { 0.05f, -1.0f, -0.01f }, { 0.05f, 1.0f, -0.01f },
+        { 0.05f, 1.0f, -10.0f }, { 0.05f, -1.0f, -10.0f } };
+    culler.addOccluder(side, quad, 6, glm::mat4(1.0f));
+    culler.rasterize();
+
+    bool hidden = !culler.isVisible(glm::vec3(-0.2f, -0.2f, -5.2f), glm::vec3(0.2f, 0.2f, -4.8f));
+    // at ndc x = 0.8, where only the clipped part of the side wall would land
+    bool visible = culler.isVisible(glm::vec3(3.8f, -0.2f, -5.2f), glm::vec3(4.2f, 0.2f, -4.8f));
+    return hidden && visible;
+}
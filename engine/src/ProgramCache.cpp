@@ -0,0 +1,246 @@
+#include "engine/ProgramCache.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+namespace fs = std::filesystem;
+
+// GL 4.1 / ARB_get_program_binary and KHR_parallel_shader_compile, not in glad's 3.3 header
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+namespace {
+
+    typedef void (APIENTRYP GetProgramBinaryProc)(GLuint, GLsizei, GLsizei*, GLenum*, void*);
+    typedef void (APIENTRYP ProgramBinaryProc)(GLuint, GLenum, const void*, GLsizei);
+    typedef void (APIENTRYP ProgramParameteriProc)(GLuint, GLenum, GLint);
+    typedef void (APIENTRYP MaxCompilerThreadsProc)(GLuint);
+
+    const char MAGIC[4] = { 'E', 'P', 'R', 'G' };
+
+    struct FileHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t key;
+        uint32_t format;
+        uint32_t length;
+    };
+
+    struct Driver {
+        bool resolved = false;
+        bool supported = false;
+        GetProgramBinaryProc getProgramBinary = nullptr;
+        ProgramBinaryProc programBinary = nullptr;
+        ProgramParameteriProc programParameteri = nullptr;
+        uint64_t identity = 0; // vendor, renderer and version strings
+    };
+
+    Driver driver;
+    bool enabled = true;
+    std::string directory = "shader_cache/";
+    ProgramCacheStats stats;
+
+    uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint64_t hashString(uint64_t hash, const char* text) {
+        if (!text) return hash;
+        // separator, so ("ab", "c") and ("a", "bc") differ
+        hash = fnv1a(hash, "\0", 1);
+        return fnv1a(hash, text, std::char_traits<char>::length(text));
+    }
+
+    // entry points and driver identity, resolved on first use with a context current
+    const Driver& resolve() {
+        if (driver.resolved) return driver;
+        driver.resolved = true;
+
+        uint64_t hash = 14695981039346656037ull;
+        hash = hashString(hash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+        hash = hashString(hash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+        hash = hashString(hash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+        driver.identity = hash;
+
+        driver.getProgramBinary = reinterpret_cast<GetProgramBinaryProc>(glfwGetProcAddress("glGetProgramBinary"));
+        driver.programBinary = reinterpret_cast<ProgramBinaryProc>(glfwGetProcAddress("glProgramBinary"));
+        driver.programParameteri = reinterpret_cast<ProgramParameteriProc>(glfwGetProcAddress("glProgramParameteri"));
+
+        GLint formats = 0;
+        if (driver.getProgramBinary && driver.programBinary && driver.programParameteri)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        // drain the error an unknown enum raises on drivers without the extension
+        while (glGetError() != GL_NO_ERROR) {}
+        driver.supported = formats > 0;
+        if (!driver.supported)
+            std::cout << "[ProgramCache] Program binaries not supported, compiling from source\n";
+        return driver;
+    }
+
+    std::string pathFor(uint64_t key) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+        return (fs::path(directory) / name).string();
+    }
+
+    double msSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+} // namespace
+
+bool ProgramCache::isSupported() {
+    return resolve().supported;
+}
+
+void ProgramCache::setEnabled(bool on) {
+    enabled = on;
+}
+
+bool ProgramCache::isEnabled() {
+    return enabled && isSupported();
+}
+
+void ProgramCache::setDirectory(const std::string& dir) {
+    directory = dir;
+}
+
+const std::string& ProgramCache::getDirectory() {
+    return directory;
+}
+
+uint64_t ProgramCache::keyFor(const std::string& vertexSource, const std::string& fragmentSource) {
+    uint64_t hash = resolve().identity;
+    hash = fnv1a(hash, &VERSION, sizeof(VERSION));
+    hash = hashString(hash, vertexSource.c_str());
+    hash = hashString(hash, fragmentSource.c_str());
+    return hash;
+}
+
+GLuint ProgramCache::load(uint64_t key) {
+    if (!isEnabled()) return 0;
+    auto start = std::chrono::steady_clock::now();
+
+    std::ifstream in(pathFor(key), std::ios::binary);
+    FileHeader header{};
+    std::vector<char> binary;
+    bool valid = in && in.read(reinterpret_cast<char*>(&header), sizeof(header))
+        && std::equal(MAGIC, MAGIC + 4, header.magic)
+        && header.version == VERSION && header.key == key && header.length > 0;
+    if (valid) {
+        binary.resize(header.length);
+        valid = bool(in.read(binary.data(), header.length));
+    }
+    if (!valid) {
+        ++stats.misses;
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    driver.programBinary(program, header.format, binary.data(), GLsizei(header.length));
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked != GL_TRUE) {
+        // driver changed its mind (e.g. same version string, new build): rebuild and overwrite
+        glDeleteProgram(program);
+        while (glGetError() != GL_NO_ERROR) {}
+        ++stats.rejected;
+        return 0;
+    }
+    ++stats.hits;
+    stats.binaryMs += msSince(start);
+    return program;
+}
+
+void ProgramCache::prepare(GLuint program) {
+    if (!isEnabled()) return;
+    driver.programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool ProgramCache::store(uint64_t key, GLuint program) {
+    if (!isEnabled()) return false;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return false;
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLenum format = 0;
+    driver.getProgramBinary(program, length, &length, &format, binary.data());
+    if (length <= 0) return false;
+
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+
+    FileHeader header{};
+    std::copy(MAGIC, MAGIC + 4, header.magic);
+    header.version = VERSION;
+    header.key = key;
+    header.format = format;
+    header.length = static_cast<uint32_t>(length);
+
+    // write to a temporary file and swap it in, so readers never see a partial binary
+    std::string path = pathFor(key);
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(binary.data(), length);
+        if (!out) {
+            out.close();
+            fs::remove(tmpPath, ec);
+            return false;
+        }
+    }
+    fs::rename(tmpPath, path, ec);
+    if (ec) {
+        // some platforms refuse to rename over an existing file
+        fs::remove(path, ec);
+        fs::rename(tmpPath, path, ec);
+    }
+    if (!ec) ++stats.stored;
+    return !ec;
+}
+
+void ProgramCache::enableParallelCompile() {
+    const char* names[][2] = {
+        { "GL_KHR_parallel_shader_compile", "glMaxShaderCompilerThreadsKHR" },
+        { "GL_ARB_parallel_shader_compile", "glMaxShaderCompilerThreadsARB" },
+    };
+    for (const auto& n : names) {
+        if (!glfwExtensionSupported(n[0])) continue;
+        auto maxThreads = reinterpret_cast<MaxCompilerThreadsProc>(glfwGetProcAddress(n[1]));
+        if (!maxThreads) continue;
+        // 0xFFFFFFFF: as many as the implementation likes
+        maxThreads(0xFFFFFFFFu);
+        return;
+    }
+}
+
+ProgramCacheStats ProgramCache::getStats() {
+    return stats;
+}
+
+void ProgramCache::addCompileTime(double ms) {
+    stats.compileMs += ms;
+}
+
+void ProgramCache::resetStats() {
+    stats = ProgramCacheStats();
+}
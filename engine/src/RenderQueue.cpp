@@ -0,0 +1,216 @@
+#include "engine/RenderQueue.h"
+#include "engine/Mesh.h"
+#include "engine/Shader.h"
+#include "engine/GeometryArena.h"
+#include "engine/UniformBuffer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+    const uint32_t PROGRAM_BITS = 10;
+    const uint32_t TEXTURE_BITS = 14;
+    const uint32_t VAO_BITS = 14;
+    const uint32_t DEPTH_BITS = 24;
+
+    uint64_t field(uint32_t value, uint32_t bits) {
+        return std::min<uint64_t>(value, (1ull << bits) - 1);
+    }
+
+    // positive floats order like their bit patterns, the top 24 bits keep that order
+    uint32_t depthBits(float depth) {
+        depth = std::max(depth, 0.0f);
+        uint32_t bits;
+        std::memcpy(&bits, &depth, sizeof(bits));
+        return bits >> (32 - DEPTH_BITS);
+    }
+
+    uint64_t textureSetOf(const Mesh& mesh) {
+        // material meshes all share the library's bindings
+        if (mesh.materialIndex >= 0) return 0;
+        // FNV-1a over the bound texture ids, in unit order
+        uint64_t hash = 1469598103934665603ull;
+        for (const auto& texture : mesh.textures) {
+            hash ^= texture->ID;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    template <typename Map, typename Key>
+    uint32_t denseId(Map& map, const Key& key) {
+        auto it = map.find(key);
+        if (it != map.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(map.size());
+        map.emplace(key, id);
+        return id;
+    }
+
+} // namespace
+
+uint64_t RenderQueue::makeKey(RenderPass pass, uint32_t program, uint32_t textureSet,
+    uint32_t vertexArray, float depth) {
+    uint64_t state = (field(program, PROGRAM_BITS) << (TEXTURE_BITS + VAO_BITS))
+        | (field(textureSet, TEXTURE_BITS) << VAO_BITS)
+        | field(vertexArray, VAO_BITS);
+    uint64_t key = uint64_t(pass) << 62;
+    if (pass == RenderPass::Transparent) {
+        // farthest first, state only breaks ties
+        uint64_t inverted = ((1ull << DEPTH_BITS) - 1) - depthBits(depth);
+        return key | (inverted << (PROGRAM_BITS + TEXTURE_BITS + VAO_BITS)) | state;
+    }
+    if (pass == RenderPass::Overlay) depth = 0.0f;
+    return key | (state << DEPTH_BITS) | depthBits(depth);
+}
+
+void RenderQueue::clear() {
+    packets.clear();
+    keys.clear();
+    order.clear();
+    programIds.clear();
+    textureSetIds.clear();
+    vertexArrayIds.clear();
+    sorted = true;
+    stats = RenderQueueStats();
+}
+
+void RenderQueue::submit(Mesh& mesh, Shader& shader, const glm::mat4& transform, float depth, RenderPass pass) {
+    DrawPacket packet;
+    packet.mesh = &mesh;
+    packet.shader = &shader;
+    packet.transform = transform;
+    packet.depth = depth;
+    packet.pass = pass;
+    submit(packet);
+}
+
+void RenderQueue::submit(const DrawPacket& packet) {
+    Queued q;
+    q.packet = packet;
+    q.textureSet = textureSetOf(*packet.mesh);
+    q.vertexArray = packet.mesh->getVertexArrayID();
+    keys.push_back(makeKey(packet.pass, denseId(programIds, packet.shader->ID),
+        denseId(textureSetIds, q.textureSet), denseId(vertexArrayIds, q.vertexArray), packet.depth));
+    order.push_back(static_cast<uint32_t>(packets.size()));
+    packets.push_back(q);
+    sorted = false;
+    ++stats.packets;
+}
+
+void RenderQueue::sort() {
+    if (sorted || keys.empty()) return;
+    auto start = std::chrono::steady_clock::now();
+
+    // what drawing in submission order would have switched
+    stats.programChangesUnsorted = stats.textureChangesUnsorted = stats.vaoChangesUnsorted = 0;
+    for (size_t i = 0; i < packets.size(); ++i) {
+        const Queued& q = packets[i];
+        const Queued* prev = i > 0 ? &packets[i - 1] : nullptr;
+        bool programChanged = !prev || prev->packet.shader->ID != q.packet.shader->ID;
+        stats.programChangesUnsorted += programChanged;
+        stats.textureChangesUnsorted += programChanged || prev->textureSet != q.textureSet;
+        stats.vaoChangesUnsorted += !prev || prev->vertexArray != q.vertexArray;
+    }
+
+    // LSD radix sort of (key, index) pairs, one byte per pass; stable, so
+    // equal keys keep submission order. Bytes equal in every key are skipped.
+    const size_t n = keys.size();
+    keyScratch.resize(n);
+    orderScratch.resize(n);
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        size_t counts[256] = {};
+        for (uint64_t key : keys) ++counts[(key >> shift) & 0xFF];
+        if (counts[(keys[0] >> shift) & 0xFF] == n) continue;
+
+        size_t offsets[256];
+        size_t sum = 0;
+        for (int b = 0; b < 256; ++b) {
+            offsets[b] = sum;
+            sum += counts[b];
+        }
+        for (size_t i = 0; i < n; ++i) {
+            size_t dst = offsets[(keys[i] >> shift) & 0xFF]++;
+            keyScratch[dst] = keys[i];
+            orderScratch[dst] = order[i];
+        }
+        keys.swap(keyScratch);
+        order.swap(orderScratch);
+    }
+
+    sorted = true;
+    stats.sortMs += std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+void RenderQueue::execute() {
+    sort();
+    executeRange(0, order.size());
+}
+
+void RenderQueue::execute(RenderPass pass) {
+    sort();
+    // the pass occupies the top bits, so its packets are contiguous
+    uint64_t passBits = uint64_t(pass) << 62;
+    auto first = std::lower_bound(keys.begin(), keys.end(), passBits);
+    auto last = std::lower_bound(first, keys.end(), passBits + (1ull << 62));
+    executeRange(size_t(first - keys.begin()), size_t(last - keys.begin()));
+}
+
+void RenderQueue::executeRange(size_t begin, size_t end) {
+    // ObjectData blocks of the whole range in one upload, bound per draw
+    const GLsizeiptr objectStride = UniformBuffer::alignedSize(sizeof(ObjectUniforms));
+    GLintptr objectBase = 0;
+    bool anyObjectBlock = false;
+    for (size_t i = begin; i < end && !anyObjectBlock; ++i)
+        anyObjectBlock = packets[order[i]].packet.shader->hasObjectBlock();
+    if (anyObjectBlock) {
+        objectScratch.assign((end - begin) * size_t(objectStride), 0);
+        for (size_t i = begin; i < end; ++i) {
+            const DrawPacket& packet = packets[order[i]].packet;
+            if (!packet.shader->hasObjectBlock()) continue;
+            ObjectUniforms block = ObjectUniforms::fromModel(packet.transform);
+            std::memcpy(&objectScratch[(i - begin) * size_t(objectStride)], &block, sizeof(block));
+        }
+        objectBase = UniformBuffer::objects().streamBatch(objectScratch.data(), sizeof(ObjectUniforms), end - begin);
+    }
+
+    GLuint program = 0;
+    uint64_t textureSet = 0;
+    bool texturesValid = false;
+    GLuint vertexArray = 0;
+    bool vertexArrayValid = false;
+
+    for (size_t i = begin; i < end; ++i) {
+        const Queued& q = packets[order[i]];
+        Shader& shader = *q.packet.shader;
+        Mesh& mesh = *q.packet.mesh;
+
+        if (shader.ID != program) {
+            shader.Activate();
+            program = shader.ID;
+            // sampler uniforms belong to the program, set them again
+            texturesValid = false;
+            ++stats.programChanges;
+        }
+        if (!texturesValid || q.textureSet != textureSet) {
+            mesh.bindTextures(shader);
+            textureSet = q.textureSet;
+            texturesValid = true;
+            ++stats.textureChanges;
+        }
+        if (!vertexArrayValid || q.vertexArray != vertexArray) {
+            vertexArray = q.vertexArray;
+            vertexArrayValid = true;
+            ++stats.vaoChanges;
+        }
+
+        if (shader.hasObjectBlock())
+            UniformBuffer::objects().bindRange(objectBase + GLintptr(i - begin) * objectStride, sizeof(ObjectUniforms));
+        else
+            shader.setMat4("model", q.packet.transform);
+        mesh.DrawGeometry();
+        ++stats.drawCalls;
+    }
+    GeometryArena::Unbind();
+}
@@ -0,0 +1,551 @@
+#include "engine/SceneBVH.h"
+#include "engine/Model.h"
+#include "engine/MathUtils.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <limits>
+
+namespace {
+
+    float surfaceArea(const glm::vec3& min, const glm::vec3& max) {
+        glm::vec3 d = max - min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    float unionArea(const glm::vec3& aMin, const glm::vec3& aMax, const glm::vec3& bMin, const glm::vec3& bMax) {
+        return surfaceArea(glm::min(aMin, bMin), glm::max(aMax, bMax));
+    }
+
+    bool contains(const glm::vec3& outerMin, const glm::vec3& outerMax,
+        const glm::vec3& innerMin, const glm::vec3& innerMax) {
+        return glm::all(glm::lessThanEqual(outerMin, innerMin)) &&
+            glm::all(glm::greaterThanEqual(outerMax, innerMax));
+    }
+
+    // slab test, entry distance of the ray into the box or a negative value on a miss
+    float rayEntry(const glm::vec3& origin, const glm::vec3& invDir, float maxDistance,
+        const glm::vec3& min, const glm::vec3& max) {
+        glm::vec3 t0 = (min - origin) * invDir;
+        glm::vec3 t1 = (max - origin) * invDir;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+        float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+        return enter <= exit ? enter : -1.0f;
+    }
+
+    bool sphereOverlaps(const glm::vec3& center, float radius, const glm::vec3& min, const glm::vec3& max) {
+        glm::vec3 d = center - glm::clamp(center, min, max);
+        return glm::dot(d, d) <= radius * radius;
+    }
+
+    // -1 outside a plane, 1 inside all planes of mask (cleared bits), 0 straddling
+    int classify(const Frustum& frustum, const glm::vec3& min, const glm::vec3& max, uint32_t& mask) {
+        glm::vec3 c = (min + max) * 0.5f;
+        glm::vec3 e = (max - min) * 0.5f;
+        for (int i = 0; i < 6; ++i) {
+            if (!(mask & (1u << i))) continue;
+            const glm::vec4& p = frustum.planes[i];
+            glm::vec3 n(p);
+            float d = glm::dot(n, c) + p.w;
+            float r = glm::dot(glm::abs(n), e);
+            if (d + r < 0.0f) return -1;
+            // children of a box fully inside a plane are inside it too
+            if (d - r >= 0.0f) mask &= ~(1u << i);
+        }
+        return mask == 0 ? 1 : 0;
+    }
+
+} // namespace
+
+SceneBVH::SceneBVH(float fatMargin) : margin(fatMargin) {}
+
+SceneBVH::~SceneBVH() {
+    clear();
+}
+
+void SceneBVH::clear() {
+    for (auto& node : nodes) {
+        if (node.height == 0 && node.model && node.model->sceneIndex == this) {
+            node.model->sceneIndex = nullptr;
+            node.model->sceneProxy = INVALID_PROXY;
+        }
+    }
+    nodes.clear();
+    root = NULL_NODE;
+    freeList = NULL_NODE;
+    leafCount = 0;
+}
+
+int32_t SceneBVH::allocateNode() {
+    int32_t index;
+    if (freeList != NULL_NODE) {
+        index = freeList;
+        freeList = nodes[index].parent;
+        nodes[index] = Node();
+    }
+    else {
+        index = static_cast<int32_t>(nodes.size());
+        nodes.emplace_back();
+    }
+    nodes[index].height = 0;
+    return index;
+}
+
+void SceneBVH::freeNode(int32_t index) {
+    nodes[index] = Node();
+    nodes[index].parent = freeList;
+    freeList = index;
+}
+
+SceneProxy SceneBVH::insert(Model& model) {
+    if (model.sceneIndex) model.sceneIndex->remove(model.sceneProxy);
+    glm::vec3 min, max;
+    model.getWorldAABB(min, max);
+    SceneProxy proxy = insert(min, max, &model);
+    model.sceneIndex = this;
+    model.sceneProxy = proxy;
+    return proxy;
+}
+
+SceneProxy SceneBVH::insert(const glm::vec3& min, const glm::vec3& max, Model* model) {
+    int32_t leaf = allocateNode();
+    // margin is relative to the box size, so small and large objects both get slack
+    glm::vec3 fat = (max - min) * margin;
+    nodes[leaf].min = min - fat;
+    nodes[leaf].max = max + fat;
+    nodes[leaf].model = model;
+    insertLeaf(leaf);
+    ++leafCount;
+    return leaf;
+}
+
+void SceneBVH::remove(SceneProxy proxy) {
+    if (proxy < 0 || proxy >= static_cast<int32_t>(nodes.size()) || nodes[proxy].height != 0) return;
+    Model* model = nodes[proxy].model;
+    if (model && model->sceneIndex == this) {
+        model->sceneIndex = nullptr;
+        model->sceneProxy = INVALID_PROXY;
+    }
+    removeLeaf(proxy);
+    freeNode(proxy);
+    --leafCount;
+}
+
+bool SceneBVH::update(SceneProxy proxy, const glm::vec3& min, const glm::vec3& max) {
+    if (proxy < 0 || proxy >= static_cast<int32_t>(nodes.size()) || nodes[proxy].height != 0) return false;
+    Node& leaf = nodes[proxy];
+    if (contains(leaf.min, leaf.max, min, max)) {
+        ++refits;
+        return false;
+    }
+
+    glm::vec3 fat = (max - min) * margin;
+    glm::vec3 fatMin = min - fat, fatMax = max + fat;
+    // still inside the parent: refit the leaf only, ancestors stay valid
+    if (leaf.parent != NULL_NODE && contains(nodes[leaf.parent].min, nodes[leaf.parent].max, fatMin, fatMax)) {
+        leaf.min = fatMin;
+        leaf.max = fatMax;
+        ++refits;
+        return false;
+    }
+
+    removeLeaf(proxy);
+    nodes[proxy].min = fatMin;
+    nodes[proxy].max = fatMax;
+    insertLeaf(proxy);
+    ++reinserts;
+    return true;
+}
+
+void SceneBVH::insertLeaf(int32_t leaf) {
+    if (root == NULL_NODE) {
+        root = leaf;
+        nodes[root].parent = NULL_NODE;
+        return;
+    }
+
+    // descend towards the sibling adding the least surface area
+    const glm::vec3 leafMin = nodes[leaf].min, leafMax = nodes[leaf].max;
+    int32_t index = root;
+    while (!nodes[index].isLeaf()) {
+        const Node& node = nodes[index];
+        float area = surfaceArea(node.min, node.max);
+        float combined = unionArea(node.min, node.max, leafMin, leafMax);
+        // cost of a new parent here, and the growth pushed onto every ancestor below
+        float cost = 2.0f * combined;
+        float inheritance = 2.0f * (combined - area);
+
+        auto childCost = [&](int32_t child) {
+            const Node& c = nodes[child];
+            float grown = unionArea(c.min, c.max, leafMin, leafMax);
+            return (c.isLeaf() ? grown : grown - surfaceArea(c.min, c.max)) + inheritance;
+        };
+        float costLeft = childCost(node.left);
+        float costRight = childCost(node.right);
+
+        if (cost < costLeft && cost < costRight) break;
+        index = costLeft < costRight ? node.left : node.right;
+    }
+
+    int32_t sibling = index;
+    int32_t oldParent = nodes[sibling].parent;
+    int32_t newParent = allocateNode(); // may reallocate nodes
+    Node& parent = nodes[newParent];
+    parent.parent = oldParent;
+    parent.min = glm::min(leafMin, nodes[sibling].min);
+    parent.max = glm::max(leafMax, nodes[sibling].max);
+    parent.height = nodes[sibling].height + 1;
+    parent.left = sibling;
+    parent.right = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent == NULL_NODE) {
+        root = newParent;
+    }
+    else if (nodes[oldParent].left == sibling) {
+        nodes[oldParent].left = newParent;
+    }
+    else {
+        nodes[oldParent].right = newParent;
+    }
+
+    fixUpwards(nodes[leaf].parent);
+}
+
+void SceneBVH::removeLeaf(int32_t leaf) {
+    if (leaf == root) {
+        root = NULL_NODE;
+        return;
+    }
+
+    int32_t parent = nodes[leaf].parent;
+    int32_t grandParent = nodes[parent].parent;
+    int32_t sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+    // the sibling takes the parent's place
+    if (grandParent == NULL_NODE) {
+        root = sibling;
+        nodes[sibling].parent = NULL_NODE;
+        freeNode(parent);
+        return;
+    }
+    if (nodes[grandParent].left == parent) nodes[grandParent].left = sibling;
+    else nodes[grandParent].right = sibling;
+    nodes[sibling].parent = grandParent;
+    freeNode(parent);
+    fixUpwards(grandParent);
+}
+
+void SceneBVH::fixUpwards(int32_t index) {
+    while (index != NULL_NODE) {
+        index = balance(index);
+        Node& node = nodes[index];
+        const Node& left = nodes[node.left];
+        const Node& right = nodes[node.right];
+        node.height = 1 + std::max(left.height, right.height);
+        node.min = glm::min(left.min, right.min);
+        node.max = glm::max(left.max, right.max);
+        index = node.parent;
+    }
+}
+
+int32_t SceneBVH::balance(int32_t iA) {
+    Node& A = nodes[iA];
+    if (A.isLeaf() || A.height < 2) return iA;
+
+    int32_t iB = A.left, iC = A.right;
+    Node& B = nodes[iB];
+    Node& C = nodes[iC];
+
+    auto replaceInParent = [&](int32_t oldChild, int32_t newChild) {
+        int32_t p = nodes[newChild].parent;
+        if (p == NULL_NODE) root = newChild;
+        else if (nodes[p].left == oldChild) nodes[p].left = newChild;
+        else nodes[p].right = newChild;
+    };
+
+    int32_t diff = C.height - B.height;
+    if (diff > 1) {
+        // rotate C up, A keeps B and the lower child of C
+        int32_t iF = C.left, iG = C.right;
+        Node& F = nodes[iF];
+        Node& G = nodes[iG];
+        C.left = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+        replaceInParent(iA, iC);
+
+        int32_t iKeep = F.height > G.height ? iF : iG;
+        int32_t iMove = F.height > G.height ? iG : iF;
+        C.right = iKeep;
+        A.right = iMove;
+        nodes[iMove].parent = iA;
+        A.min = glm::min(B.min, nodes[iMove].min);
+        A.max = glm::max(B.max, nodes[iMove].max);
+        A.height = 1 + std::max(B.height, nodes[iMove].height);
+        C.min = glm::min(A.min, nodes[iKeep].min);
+        C.max = glm::max(A.max, nodes[iKeep].max);
+        C.height = 1 + std::max(A.height, nodes[iKeep].height);
+        return iC;
+    }
+    if (diff < -1) {
+        // rotate B up, A keeps C and the lower child of B
+        int32_t iD = B.left, iE = B.right;
+        Node& D = nodes[iD];
+        Node& E = nodes[iE];
+        B.left = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+        replaceInParent(iA, iB);
+
+        int32_t iKeep = D.height > E.height ? iD : iE;
+        int32_t iMove = D.height > E.height ? iE : iD;
+        B.right = iKeep;
+        A.left = iMove;
+        nodes[iMove].parent = iA;
+        A.min = glm::min(C.min, nodes[iMove].min);
+        A.max = glm::max(C.max, nodes[iMove].max);
+        A.height = 1 + std::max(C.height, nodes[iMove].height);
+        B.min = glm::min(A.min, nodes[iKeep].min);
+        B.max = glm::max(A.max, nodes[iKeep].max);
+        B.height = 1 + std::max(A.height, nodes[iKeep].height);
+        return iB;
+    }
+    return iA;
+}
+
+void SceneBVH::queryFrustum(const Frustum& frustum, std::vector<SceneProxy>& out) const {
+    if (root == NULL_NODE) return;
+    struct Entry { int32_t node; uint32_t mask; };
+    std::vector<Entry> stack;
+    stack.reserve(64);
+    stack.push_back({ root, 0x3Fu });
+
+    while (!stack.empty()) {
+        Entry e = stack.back();
+        stack.pop_back();
+        const Node& node = nodes[e.node];
+        // once a subtree is inside every plane its leaves are taken untested
+        if (e.mask != 0 && classify(frustum, node.min, node.max, e.mask) < 0) continue;
+        if (node.isLeaf()) {
+            out.push_back(e.node);
+            continue;
+        }
+        stack.push_back({ node.left, e.mask });
+        stack.push_back({ node.right, e.mask });
+    }
+}
+
+void SceneBVH::querySphere(const glm::vec3& center, float radius, std::vector<SceneProxy>& out) const {
+    if (root == NULL_NODE) return;
+    std::vector<int32_t> stack;
+    stack.reserve(64);
+    stack.push_back(root);
+
+    while (!stack.empty()) {
+        int32_t index = stack.back();
+        stack.pop_back();
+        const Node& node = nodes[index];
+        if (!sphereOverlaps(center, radius, node.min, node.max)) continue;
+        if (node.isLeaf()) {
+            out.push_back(index);
+            continue;
+        }
+        stack.push_back(node.left);
+        stack.push_back(node.right);
+    }
+}
+
+bool SceneBVH::raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDistance, SceneRayHit& hit) const {
+    if (root == NULL_NODE) return false;
+    glm::vec3 invDir = 1.0f / dir;
+    float best = maxDistance;
+    SceneProxy bestProxy = INVALID_PROXY;
+
+    struct Entry { int32_t node; float entry; };
+    std::vector<Entry> stack;
+    stack.reserve(64);
+    float rootEntry = rayEntry(origin, invDir, best, nodes[root].min, nodes[root].max);
+    if (rootEntry >= 0.0f) stack.push_back({ root, rootEntry });
+
+    while (!stack.empty()) {
+        Entry e = stack.back();
+        stack.pop_back();
+        if (e.entry > best) continue; // a closer hit was found meanwhile
+        const Node& node = nodes[e.node];
+        if (node.isLeaf()) {
+            best = e.entry;
+            bestProxy = e.node;
+            continue;
+        }
+        float tLeft = rayEntry(origin, invDir, best, nodes[node.left].min, nodes[node.left].max);
+        float tRight = rayEntry(origin, invDir, best, nodes[node.right].min, nodes[node.right].max);
+        // push the farther child first so the nearer one is visited first
+        if (tLeft >= 0.0f && tRight >= 0.0f) {
+            bool leftFirst = tLeft <= tRight;
+            stack.push_back(leftFirst ? Entry{ node.right, tRight } : Entry{ node.left, tLeft });
+            stack.push_back(leftFirst ? Entry{ node.left, tLeft } : Entry{ node.right, tRight });
+        }
+        else if (tLeft >= 0.0f) {
+            stack.push_back({ node.left, tLeft });
+        }
+        else if (tRight >= 0.0f) {
+            stack.push_back({ node.right, tRight });
+        }
+    }
+
+    if (bestProxy == INVALID_PROXY) return false;
+    hit.proxy = bestProxy;
+    hit.model = nodes[bestProxy].model;
+    hit.distance = best;
+    return true;
+}
+
+void SceneBVH::getBounds(SceneProxy proxy, glm::vec3& outMin, glm::vec3& outMax) const {
+    outMin = nodes[proxy].min;
+    outMax = nodes[proxy].max;
+}
+
+SceneBVHStats SceneBVH::getStats() const {
+    SceneBVHStats stats;
+    stats.leaves = leafCount;
+    stats.nodes = leafCount == 0 ? 0 : leafCount * 2 - 1;
+    stats.height = root == NULL_NODE ? 0 : nodes[root].height;
+    stats.refits = refits;
+    stats.reinserts = reinserts;
+    return stats;
+}
+
+SceneBVHBenchmark SceneBVH::benchmark(size_t objectCount, unsigned seed) {
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+
+    // constant density: the world grows with the object count
+    std::mt19937 rng(seed);
+    float worldSize = 10.0f * std::cbrt(float(objectCount));
+    std::uniform_real_distribution<float> position(-worldSize * 0.5f, worldSize * 0.5f);
+    std::uniform_real_distribution<float> size(0.5f, 2.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    SceneBVHBenchmark result;
+    result.objects = objectCount;
+    SceneBVH tree;
+    std::vector<SceneProxy> proxies(objectCount);
+    std::vector<glm::vec3> mins(objectCount), maxs(objectCount);
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < objectCount; ++i) {
+        mins[i] = glm::vec3(position(rng), position(rng), position(rng));
+        maxs[i] = mins[i] + glm::vec3(size(rng), size(rng), size(rng));
+        proxies[i] = tree.insert(mins[i], maxs[i]);
+    }
+    result.buildMs = ms(start, Clock::now());
+
+    start = Clock::now();
+    for (size_t i = 0; i < objectCount; i += 10) {
+        glm::vec3 offset(unit(rng), unit(rng), unit(rng));
+        mins[i] += offset;
+        maxs[i] += offset;
+        tree.update(proxies[i], mins[i], maxs[i]);
+    }
+    result.updateMs = ms(start, Clock::now());
+
+    // brute force runs over the same fat boxes the tree stores
+    std::vector<glm::vec3> fatMins(objectCount), fatMaxs(objectCount);
+    for (size_t i = 0; i < objectCount; ++i) tree.getBounds(proxies[i], fatMins[i], fatMaxs[i]);
+
+    const int queries = 32;
+    std::vector<Frustum> frusta;
+    std::vector<glm::vec3> centers, dirs;
+    for (int q = 0; q < queries; ++q) {
+        glm::vec3 eye(position(rng), position(rng), position(rng));
+        glm::vec3 dir = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 1e-3f));
+        glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, worldSize * 0.25f)
+            * glm::lookAt(eye, eye + dir, std::abs(dir.y) > 0.99f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0));
+        frusta.push_back(Frustum::fromMatrix(viewProjection));
+        centers.push_back(eye);
+        dirs.push_back(dir);
+    }
+
+    bool matches = true;
+    std::vector<SceneProxy> found, brute;
+    auto sameSet = [&]() {
+        std::sort(found.begin(), found.end());
+        std::sort(brute.begin(), brute.end());
+        return found == brute;
+    };
+
+    double treeTime = 0.0, bruteTime = 0.0;
+    for (int q = 0; q < queries; ++q) {
+        found.clear();
+        brute.clear();
+        auto t0 = Clock::now();
+        tree.queryFrustum(frusta[q], found);
+        auto t1 = Clock::now();
+        for (size_t i = 0; i < objectCount; ++i) {
+            if (frusta[q].intersectsAABB(fatMins[i], fatMaxs[i])) brute.push_back(proxies[i]);
+        }
+        auto t2 = Clock::now();
+        treeTime += ms(t0, t1);
+        bruteTime += ms(t1, t2);
+        matches = matches && sameSet();
+    }
+    result.frustumMs = treeTime / queries;
+    result.frustumBruteMs = bruteTime / queries;
+
+    treeTime = bruteTime = 0.0;
+    float radius = 10.0f;
+    for (int q = 0; q < queries; ++q) {
+        found.clear();
+        brute.clear();
+        auto t0 = Clock::now();
+        tree.querySphere(centers[q], radius, found);
+        auto t1 = Clock::now();
+        for (size_t i = 0; i < objectCount; ++i) {
+            if (sphereOverlaps(centers[q], radius, fatMins[i], fatMaxs[i])) brute.push_back(proxies[i]);
+        }
+        auto t2 = Clock::now();
+        treeTime += ms(t0, t1);
+        bruteTime += ms(t1, t2);
+        matches = matches && sameSet();
+    }
+    result.sphereMs = treeTime / queries;
+    result.sphereBruteMs = bruteTime / queries;
+
+    treeTime = bruteTime = 0.0;
+    for (int q = 0; q < queries; ++q) {
+        float maxDistance = worldSize * 2.0f;
+        SceneRayHit hit;
+        auto t0 = Clock::now();
+        bool treeHit = tree.raycast(centers[q], dirs[q], maxDistance, hit);
+        auto t1 = Clock::now();
+        glm::vec3 invDir = 1.0f / dirs[q];
+        float nearest = -1.0f;
+        for (size_t i = 0; i < objectCount; ++i) {
+            float t = rayEntry(centers[q], invDir, maxDistance, fatMins[i], fatMaxs[i]);
+            if (t >= 0.0f && (nearest < 0.0f || t < nearest)) nearest = t;
+        }
+        auto t2 = Clock::now();
+        treeTime += ms(t0, t1);
+        bruteTime += ms(t1, t2);
+        matches = matches && treeHit == (nearest >= 0.0f) && (!treeHit || hit.distance == nearest);
+    }
+    result.rayMs = treeTime / queries;
+    result.rayBruteMs = bruteTime / queries;
+    result.matchesBruteForce = matches;
+
+    std::cout << "[SceneBVH] " << objectCount << " objects (height " << tree.getStats().height
+        << "): build " << result.buildMs << " ms, update " << result.updateMs << " ms"
+        << " | frustum " << result.frustumMs << " vs " << result.frustumBruteMs << " ms"
+        << " | sphere " << result.sphereMs << " vs " << result.sphereBruteMs << " ms"
+        << " | ray " << result.rayMs << " vs " << result.rayBruteMs << " ms"
+        << (matches ? "" : " | MISMATCH") << "\n";
+    return result;
+}
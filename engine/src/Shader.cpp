@@ -1,8 +1,24 @@
 #include "engine/Shader.h"
+#include "engine/GLState.h"
+#include "engine/UniformBuffer.h"
+#include "engine/ProgramCache.h"
+#include "engine/ShaderPreprocessor.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <cerrno>
+#include <chrono>
+
+namespace {
+
+	// hashed at compile time
+	constexpr UniformName MODEL_UNIFORM("model");
+
+	double msSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+} // namespace
 
 // Reads a text file and outputs a string with everything in the text file
 std::string get_file_contents(const std::string& filename) {
@@ -20,96 +36,154 @@ std::string get_file_contents(const std::string& filename) {
 	throw(std::runtime_error("Failed to open file: " + filename));
 }
 
-// Constructor that build the Shader Program from 2 different shaders
-Shader::Shader(const std::string& vertexFile, const std::string& fragmentFile) {
+ShaderSource ShaderSource::fromFiles(const std::string& vertexFile, const std::string& fragmentFile,
+	const std::vector<std::string>& defines) {
 	// Read vertexFile and fragmentFile and store the strings
-	std::string vertexCode = get_file_contents(vertexFile);
-	std::string fragmentCode = get_file_contents(fragmentFile);
+	ShaderSource source;
+	source.vertex = ShaderPreprocessor::process(get_file_contents(vertexFile), vertexFile, defines).source;
+	source.fragment = ShaderPreprocessor::process(get_file_contents(fragmentFile), fragmentFile, defines).source;
+	source.name = vertexFile;
+	return source;
+}
+
+// Constructor that build the Shader Program from 2 different shaders
+Shader::Shader(const std::string& vertexFile, const std::string& fragmentFile)
+	: Shader(ShaderSource::fromFiles(vertexFile, fragmentFile)) {}
+
+Shader::Shader(const ShaderSource& source) : Shader(source, Deferred()) {
+	auto start = std::chrono::steady_clock::now();
+	bool compiled = pendingVertex != 0;
+	finish();
+	if (compiled) ProgramCache::addCompileTime(msSince(start) + submitMs);
+}
+
+Shader::Shader(const ShaderSource& source, Deferred) : name(source.name) {
+	auto start = std::chrono::steady_clock::now();
+	submit(source);
+	submitMs = msSince(start);
+}
+
+std::vector<std::unique_ptr<Shader>> Shader::compileBatch(const std::vector<ShaderSource>& sources) {
+	auto start = std::chrono::steady_clock::now();
+	ProgramCache::enableParallelCompile();
+
+	// submit everything first: the driver may compile in the background
+	// until the first status query of finish
+	std::vector<std::unique_ptr<Shader>> shaders;
+	shaders.reserve(sources.size());
+	for (const auto& source : sources)
+		shaders.push_back(std::unique_ptr<Shader>(new Shader(source, Deferred())));
+	size_t compiled = 0;
+	for (auto& shader : shaders) {
+		compiled += shader->pendingVertex != 0;
+		shader->finish();
+	}
+
+	double ms = msSince(start);
+	std::cout << "[Shader] Batch of " << sources.size() << " programs (" << compiled
+		<< " compiled from source) in " << ms << " ms\n";
+	if (compiled > 0) ProgramCache::addCompileTime(ms);
+	return shaders;
+}
+
+void Shader::submit(const ShaderSource& source) {
+	// Reuse the linked binary of an earlier run when the driver accepts it
+	cacheKey = ProgramCache::keyFor(source.vertex, source.fragment);
+	ID = ProgramCache::load(cacheKey);
+	if (ID != 0) return;
 
 	// Convert the shader source strings into character arrays
-	const char* vertexSource = vertexCode.c_str();
-	const char* fragmentSource = fragmentCode.c_str();
+	const char* vertexSource = source.vertex.c_str();
+	const char* fragmentSource = source.fragment.c_str();
 
-	// Compile Vertex Shader
+	// Compile Vertex Shader (status is checked in finish)
 
 	// Create Vertex Shader Object and get its reference
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+	pendingVertex = glCreateShader(GL_VERTEX_SHADER);
 	// Attach Vertex Shader source to the Vertex Shader Object
-	glShaderSource(vertexShader, 1, &vertexSource, NULL);
+	glShaderSource(pendingVertex, 1, &vertexSource, NULL);
 	// Compile the Vertex Shader into machine code
-	glCompileShader(vertexShader);
-	checkCompileErrors(vertexShader, "VERTEX");
+	glCompileShader(pendingVertex);
 
 	// Compile Fragment Shader
 
 	// Create Fragment Shader Object and get its reference
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+	pendingFragment = glCreateShader(GL_FRAGMENT_SHADER);
 	// Attach Fragment Shader source to the Fragment Shader Object
-	glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
+	glShaderSource(pendingFragment, 1, &fragmentSource, NULL);
 	// Compile the Vertex Shader into machine code
-	glCompileShader(fragmentShader);
-	checkCompileErrors(fragmentShader, "FRAGMENT");
+	glCompileShader(pendingFragment);
 
 	// Link Shaders
 
 	// Create Shader Program Object and get its reference
 	ID = glCreateProgram();
 	// Attach the Vertex and Fragment Shaders to the Shader Program
-	glAttachShader(ID, vertexShader);
-	glAttachShader(ID, fragmentShader);
+	glAttachShader(ID, pendingVertex);
+	glAttachShader(ID, pendingFragment);
+	// Ask for a retrievable binary so the program can be cached
+	ProgramCache::prepare(ID);
 	// Wrap-up/Link all the shaders together into the Shader Program
 	glLinkProgram(ID);
-	checkCompileErrors(ID, "PROGRAM");
+}
 
-	// Delete the now useless Vertex and Fragment Shader objects
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
+void Shader::finish() {
+	if (pendingVertex != 0) {
+		// first status queries, these wait for the compiler
+		checkCompileErrors(pendingVertex, "VERTEX");
+		checkCompileErrors(pendingFragment, "FRAGMENT");
+		if (checkCompileErrors(ID, "PROGRAM")) ProgramCache::store(cacheKey, ID);
 
+		// Delete the now useless Vertex and Fragment Shader objects
+		glDeleteShader(pendingVertex);
+		glDeleteShader(pendingFragment);
+		pendingVertex = pendingFragment = 0;
+	}
+	bindUniformBlocks();
 }
 
 // Activates the Shader Program
 void Shader::Activate() {
-	glUseProgram(ID);
+	GLState::useProgram(ID);
 }
 
 // Deletes the Shader Program
 void Shader::Delete() {
-	glDeleteProgram(ID);
+	GLState::deleteProgram(ID);
 }
 
 // Uniform Helper Functions
 
-GLint Shader::getUniformLocation(const std::string& name) const {
-	auto it = uniformCache.find(name);
-	if (it != uniformCache.end()) return it->second;
+GLint Shader::getUniformLocation(const UniformName& name) const {
+	if (const GLint* cached = uniformCache.find(name.hash)) return *cached;
 
-	GLint loc = glGetUniformLocation(ID, name.c_str());
+	GLint loc = glGetUniformLocation(ID, name.name);
 	// Cache even if -1 (lets us skip repeated GL calls)
-	uniformCache[name] = loc;
+	uniformCache.insert(name, loc);
 	return loc;
 }
 
-void Shader::setBool(const std::string& name, bool value) const {
+void Shader::setBool(const UniformName& name, bool value) const {
 	glUniform1i(getUniformLocation(name), (int)value);
 }
 
-void Shader::setInt(const std::string& name, int value) const {
+void Shader::setInt(const UniformName& name, int value) const {
 	glUniform1i(getUniformLocation(name), value);
 }
 
-void Shader::setFloat(const std::string& name, float value) const {
+void Shader::setFloat(const UniformName& name, float value) const {
 	glUniform1f(getUniformLocation(name), value);
 }
 
-void Shader::setMat4(const std::string& name, const float* mat) const {
+void Shader::setMat4(const UniformName& name, const float* mat) const {
 	glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, mat);
 }
 
-void Shader::setMat4(const std::string& name, const glm::mat4& m) const {
+void Shader::setMat4(const UniformName& name, const glm::mat4& m) const {
 	glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &m[0][0]);
 }
 
-void Shader::setVec2(const std::string& name, const glm::vec2 v) const {
+void Shader::setVec2(const UniformName& name, const glm::vec2 v) const {
 	glUniform2f(getUniformLocation(name), v.x, v.y);
 }
 
@@ -117,7 +191,7 @@ void Shader::setVec2(const std::string& name, const glm::vec2 v) const {
 //	glUniform3f(getUniformLocation(name), x, y, z);
 //}
 
-void Shader::setVec3(const std::string& name, const glm::vec3& v) const {
+void Shader::setVec3(const UniformName& name, const glm::vec3& v) const {
 	glUniform3f(getUniformLocation(name), v.x, v.y, v.z);
 }
 
@@ -125,14 +199,65 @@ void Shader::setVec3(const std::string& name, const glm::vec3& v) const {
 //	glUniform4f(getUniformLocation(name), x, y, z, w);
 //}
 
-void Shader::setVec4(const std::string& name, const glm::vec4& v) const {
+void Shader::setVec4(const UniformName& name, const glm::vec4& v) const {
 	glUniform4f(getUniformLocation(name), v.x, v.y, v.z, v.w);
 }
 
+// Handle Functions
+
+UniformHandle Shader::getHandle(const UniformName& name) const {
+	return UniformHandle(getUniformLocation(name));
+}
+
+void Shader::setBool(UniformHandle handle, bool value) const {
+	glUniform1i(handle.location, (int)value);
+}
+
+void Shader::setInt(UniformHandle handle, int value) const {
+	glUniform1i(handle.location, value);
+}
+
+void Shader::setFloat(UniformHandle handle, float value) const {
+	glUniform1f(handle.location, value);
+}
+
+void Shader::setMat4(UniformHandle handle, const glm::mat4& m) const {
+	glUniformMatrix4fv(handle.location, 1, GL_FALSE, &m[0][0]);
+}
+
+void Shader::setVec2(UniformHandle handle, const glm::vec2 v) const {
+	glUniform2f(handle.location, v.x, v.y);
+}
+
+void Shader::setVec3(UniformHandle handle, const glm::vec3& v) const {
+	glUniform3f(handle.location, v.x, v.y, v.z);
+}
+
+void Shader::setVec4(UniformHandle handle, const glm::vec4& v) const {
+	glUniform4f(handle.location, v.x, v.y, v.z, v.w);
+}
+
+void Shader::setModelMatrix(const glm::mat4& m) const {
+	if (objectBlock) UniformBuffer::streamObject(m);
+	else setMat4(MODEL_UNIFORM, m);
+}
+
+// Uniform Blocks
+
+void Shader::bindUniformBlocks() {
+	GLuint frameIndex = glGetUniformBlockIndex(ID, UniformBuffer::FRAME_BLOCK);
+	frameBlock = frameIndex != GL_INVALID_INDEX;
+	if (frameBlock) glUniformBlockBinding(ID, frameIndex, UniformBuffer::FRAME_BINDING);
+
+	GLuint objectIndex = glGetUniformBlockIndex(ID, UniformBuffer::OBJECT_BLOCK);
+	objectBlock = objectIndex != GL_INVALID_INDEX;
+	if (objectBlock) glUniformBlockBinding(ID, objectIndex, UniformBuffer::OBJECT_BINDING);
+}
+
 
 // Error Handling
 
-void Shader::checkCompileErrors(GLuint shader, const std::string& type) {
+bool Shader::checkCompileErrors(GLuint shader, const std::string& type) {
 	GLint success;
 	GLchar infoLog[1024];
 
@@ -140,7 +265,7 @@ void Shader::checkCompileErrors(GLuint shader, const std::string& type) {
 		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
 		if (!success) {
 			glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-			std::cerr << "SHADER COMPILATION ERROR (" << type << "):\n"
+			std::cerr << "SHADER COMPILATION ERROR (" << type << ", " << name << "):\n"
 				<< infoLog << std::endl;
 		}
 	}
@@ -148,8 +273,9 @@ void Shader::checkCompileErrors(GLuint shader, const std::string& type) {
 		glGetProgramiv(shader, GL_LINK_STATUS, &success);
 		if (!success) {
 			glGetProgramInfoLog(shader, 1024, NULL, infoLog);
-			std::cerr << "PROGRAM LINKING ERROR:\n"
+			std::cerr << "PROGRAM LINKING ERROR (" << name << "):\n"
 				<< infoLog << std::endl;
 		}
 	}
+	return success != 0;
 }
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "engine/ShaderPreprocessor.h"
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+namespace fs = std::filesystem;
+
+namespace {
+
+    std::vector<std::string>& includeDirectories() {
+#ifdef ENGINE_SHADER_DIR
+        static std::vector<std::string> dirs = { ENGINE_SHADER_DIR };
+#else
+        static std::vector<std::string> dirs;
+#endif
+        return dirs;
+    }
+
+    bool readFile(const fs::path& path, std::string& out) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        std::ostringstream contents;
+        contents << in.rdbuf();
+        out = contents.str();
+        return true;
+    }
+
+    // true when line is the directive, rest receives what follows it
+    bool directive(const std::string& line, const char* name, std::string& rest) {
+        size_t p = line.find_first_not_of(" \t");
+        if (p == std::string::npos || line[p] != '#') return false;
+        p = line.find_first_not_of(" \t", p + 1);
+        size_t length = std::char_traits<char>::length(name);
+        if (p == std::string::npos || line.compare(p, length, name) != 0) return false;
+        rest = line.substr(p + length);
+        return true;
+    }
+
+    fs::path resolveInclude(const std::string& name, const fs::path& from) {
+        std::error_code ec;
+        fs::path local = from.parent_path() / name;
+        if (fs::exists(local, ec)) return local;
+        for (const auto& dir : includeDirectories()) {
+            fs::path candidate = fs::path(dir) / name;
+            if (fs::exists(candidate, ec)) return candidate;
+        }
+        return fs::path();
+    }
+
+    std::string identity(const fs::path& path) {
+        std::error_code ec;
+        fs::path canonical = fs::weakly_canonical(path, ec);
+        return ec ? path.lexically_normal().string() : canonical.string();
+    }
+
+    void expand(const std::string& text, const fs::path& path, size_t fileIndex,
+        ShaderPreprocessor::Result& result, std::set<std::string>& included, std::string& out) {
+        std::istringstream in(text);
+        std::string line, rest;
+        size_t lineNumber = 0;
+        while (std::getline(in, line)) {
+            ++lineNumber;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+
+            if (directive(line, "include", rest)) {
+                size_t open = rest.find_first_of("\"<");
+                size_t close = open == std::string::npos ? open : rest.find_first_of("\">", open + 1);
+                if (close == std::string::npos)
+                    throw std::runtime_error(path.string() + ":" + std::to_string(lineNumber) + ": malformed #include");
+                std::string name = rest.substr(open + 1, close - open - 1);
+
+                fs::path file = resolveInclude(name, path);
+                std::string contents;
+                if (file.empty() || !readFile(file, contents))
+                    throw std::runtime_error(path.string() + ":" + std::to_string(lineNumber) + ": cannot include " + name);
+                if (!included.insert(identity(file)).second) {
+                    out += '\n'; // already pasted, keep the line count
+                    continue;
+                }
+
+                size_t index = result.files.size();
+                result.files.push_back(file.string());
+                out += "#line 1 " + std::to_string(index) + "\n";
+                expand(contents, file, index, result, included, out);
+                out += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+                continue;
+            }
+            // once per program anyway; included files cannot carry their own #version
+            if (directive(line, "pragma", rest) && rest.find("once") != std::string::npos) {
+                out += '\n';
+                continue;
+            }
+            if (fileIndex != 0 && directive(line, "version", rest)) {
+                out += '\n';
+                continue;
+            }
+            out += line;
+            out += '\n';
+        }
+    }
+
+} // namespace
+
+ShaderPreprocessor::Result ShaderPreprocessor::processFile(const std::string& path,
+    const std::vector<std::string>& defines) {
+    std::string contents;
+    if (!readFile(path, contents)) throw std::runtime_error("Failed to open file: " + path);
+    return process(contents, path, defines);
+}
+
+ShaderPreprocessor::Result ShaderPreprocessor::process(const std::string& source, const std::string& path,
+    const std::vector<std::string>& defines) {
+    Result result;
+    result.files.push_back(path);
+    std::set<std::string> included;
+    if (!path.empty()) included.insert(identity(path));
+
+    expand(source, path, 0, result, included, result.source);
+    if (!defines.empty()) result.source = injectDefines(result.source, defines);
+    return result;
+}
+
+std::string ShaderPreprocessor::injectDefines(const std::string& source, const std::vector<std::string>& defines) {
+    if (defines.empty()) return source;
+    std::string block;
+    for (const auto& d : defines) block += "#define " + d + "\n";
+
+    // #version has to stay the first directive; only blank lines and
+    // comments (line or block) may come before it
+    size_t lineStart = 0;
+    size_t lineNumber = 1;
+    std::string rest;
+    bool inComment = false;
+    while (lineStart < source.size()) {
+        size_t lineEnd = source.find('\n', lineStart);
+        if (lineEnd == std::string::npos) lineEnd = source.size();
+        std::string line = source.substr(lineStart, lineEnd - lineStart);
+
+        // the line without its comments
+        std::string code;
+        for (size_t i = 0; i < line.size();) {
+            if (inComment) {
+                size_t close = line.find("*/", i);
+                if (close == std::string::npos) break;
+                inComment = false;
+                i = close + 2;
+            }
+            else if (line.compare(i, 2, "//") == 0) {
+                break;
+            }
+            else if (line.compare(i, 2, "/*") == 0) {
+                inComment = true;
+                i += 2;
+            }
+            else {
+                code += line[i++];
+            }
+        }
+
+        if (directive(code, "version", rest)) {
+            size_t insertAt = std::min(lineEnd + 1, source.size());
+            std::string out = source.substr(0, insertAt);
+            if (lineEnd == source.size()) out += '\n';
+            out += block;
+            out += "#line " + std::to_string(lineNumber + 1) + " 0\n";
+            out += source.substr(insertAt);
+            return out;
+        }
+        if (code.find_first_not_of(" \t\r") != std::string::npos) break;
+        lineStart = lineEnd + 1;
+        ++lineNumber;
+    }
+    // no #version: the defines simply go first
+    return block + "#line 1 0\n" + source;
+}
+
+void ShaderPreprocessor::addIncludeDirectory(const std::string& directory) {
+    includeDirectories().push_back(directory);
+}
+
+const std::vector<std::string>& ShaderPreprocessor::getIncludeDirectories() {
+    return includeDirectories();
+}
@@ -0,0 +1,57 @@
+#include "engine/ShaderVariant.h"
+#include <algorithm>
+#include <stdexcept>
+
+ShaderVariantCache::ShaderVariantCache(const std::string& vertexFile, const std::string& fragmentFile,
+    std::vector<std::string> featureList)
+    : name(vertexFile), features(std::move(featureList)) {
+    if (features.size() > MAX_FEATURES)
+        throw std::runtime_error("ShaderVariantCache: more than 32 features for " + vertexFile);
+    vertexBase = ShaderPreprocessor::processFile(vertexFile);
+    fragmentBase = ShaderPreprocessor::processFile(fragmentFile);
+}
+
+Shader& ShaderVariantCache::get(uint32_t mask) {
+    auto it = variants.find(mask);
+    if (it != variants.end()) return *it->second;
+
+    auto shader = std::make_unique<Shader>(sourceFor(mask));
+    return *variants.emplace(mask, std::move(shader)).first->second;
+}
+
+void ShaderVariantCache::precompile(const std::vector<uint32_t>& masks) {
+    std::vector<uint32_t> missing;
+    std::vector<ShaderSource> sources;
+    for (uint32_t mask : masks) {
+        if (variants.count(mask) || std::find(missing.begin(), missing.end(), mask) != missing.end()) continue;
+        missing.push_back(mask);
+        sources.push_back(sourceFor(mask));
+    }
+    if (sources.empty()) return;
+
+    auto shaders = Shader::compileBatch(sources);
+    for (size_t i = 0; i < missing.size(); ++i) variants.emplace(missing[i], std::move(shaders[i]));
+}
+
+uint32_t ShaderVariantCache::bit(const std::string& feature) const {
+    for (size_t i = 0; i < features.size(); ++i) {
+        const std::string& f = features[i];
+        // match the NAME part of "NAME value"
+        if (f.compare(0, feature.size(), feature) == 0 && (f.size() == feature.size() || f[feature.size()] == ' '))
+            return 1u << i;
+    }
+    return 0;
+}
+
+ShaderSource ShaderVariantCache::sourceFor(uint32_t mask) const {
+    std::vector<std::string> defines;
+    for (size_t i = 0; i < features.size(); ++i)
+        if (mask & (1u << i)) defines.push_back(features[i]);
+
+    ShaderSource source;
+    source.vertex = ShaderPreprocessor::injectDefines(vertexBase.source, defines);
+    source.fragment = ShaderPreprocessor::injectDefines(fragmentBase.source, defines);
+    source.name = name;
+    for (const auto& d : defines) source.name += " +" + d;
+    return source;
+}
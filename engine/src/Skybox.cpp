@@ -1,4 +1,5 @@
 #include "engine/Skybox.h"
+#include "engine/GLState.h"
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
@@ -10,8 +11,8 @@ Skybox::Skybox(Cubemap& cubemap)
 
 Skybox::~Skybox()
 {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    GLState::deleteVertexArray(VAO);
+    GLState::deleteBuffer(VBO);
 }
 
 void Skybox::initCube()
@@ -41,46 +42,50 @@ void Skybox::initCube()
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLState::bindVertexArray(VAO);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
 	// Only position attribute
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 }
 
 void Skybox::Draw(const Camera& camera, Shader& shader) {
-    // Save state
-    GLboolean wasCulling = glIsEnabled(GL_CULL_FACE);
-    GLint prevCullFace;
-    glGetIntegerv(GL_CULL_FACE_MODE, &prevCullFace);
+    // Save state (from the shadow copy, no GL round trip)
+    bool wasCulling = GLState::isEnabled(GL_CULL_FACE);
+    GLenum prevCullFace = GLState::getCullFace();
+    GLenum prevDepthFunc = GLState::getDepthFunc();
+    bool prevDepthMask = GLState::getDepthMask();
 
-    glDepthFunc(GL_LEQUAL);
-    glDepthMask(GL_FALSE);
+    GLState::depthFunc(GL_LEQUAL);
+    GLState::depthMask(false);
 
     // draw inner faces
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_FRONT);
+    GLState::setEnabled(GL_CULL_FACE, true);
+    GLState::cullFace(GL_FRONT);
 
-    // remove translation from view matrix
-    glm::mat4 view = glm::mat4(glm::mat3(camera.view));
-    shader.setMat4("view", view);
-    shader.setMat4("projection", camera.projection);
+    // shaders reading FrameData drop the translation themselves
+    if (!shader.hasFrameBlock()) {
+        // remove translation from view matrix
+        glm::mat4 view = glm::mat4(glm::mat3(camera.view));
+        shader.setMat4("view", view);
+        shader.setMat4("projection", camera.projection);
+    }
 
     environment.Bind(0);
     shader.setInt("environmentMap", 0);
 
-    glBindVertexArray(VAO);
+    GLState::bindVertexArray(VAO);
     glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 
     // Restore state
-    glCullFace(prevCullFace);
-    if (!wasCulling) glDisable(GL_CULL_FACE);
+    GLState::cullFace(prevCullFace);
+    GLState::setEnabled(GL_CULL_FACE, wasCulling);
 
-    glDepthMask(GL_TRUE);
-    glDepthFunc(GL_LESS);
+    GLState::depthMask(prevDepthMask);
+    GLState::depthFunc(prevDepthFunc);
 }
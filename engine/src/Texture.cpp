@@ -1,7 +1,35 @@
 #include "engine/Texture.h"
 #include "engine/Shader.h"
+#include "engine/TextureDecoder.h"
+#include "engine/TextureBaker.h"
+#include "engine/GLState.h"
+#include <cstring>
 #include <iostream>
-#include <stb_image.h>
+
+// S3TC and BPTC enums, extensions to glad's 3.3 core header
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+namespace {
+
+	bool hasExtension(const char* name) {
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; ++i) {
+			const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+			if (extension && std::strcmp(extension, name) == 0) return true;
+		}
+		return false;
+	}
+
+}
 
 Texture::Texture(const char* image, const char* texType, GLuint texSlot, GLenum pixelType) {
 	// Assigns the type of the texture ot the texture object
@@ -9,49 +37,24 @@ Texture::Texture(const char* image, const char* texType, GLuint texSlot, GLenum
 	// Remember the slot
 	slot = texSlot;
 
-	// Stores the width, height, and the number of color channels of the image
-	int widthImg, heightImg, numColCh;
-	// Flips the image so it appears right side up
-	stbi_set_flip_vertically_on_load(true);
-	// Reads the image from a file and stores it in bytes
-	unsigned char* bytes = stbi_load(image, &widthImg, &heightImg, &numColCh, 0);
-	if (!bytes) {
+	// Baked levels (cached next to the image) when baking is on, .dds files always
+	BakedTexture baked;
+	if ((TextureBaker::isEnabled() || TextureBaker::isContainer(image))
+		&& TextureBaker::loadOrBake(image, baked, TextureBakeOptions::forType(texType))) {
+		uploadBaked(baked);
+		return;
+	}
+
+	// Reads the image from a file, flipped so it appears right side up
+	TextureRequest request;
+	request.path = image;
+	DecodedImage decoded = TextureDecoder::decode(request);
+	if (!decoded.isValid()) {
 		std::cerr << "Failed to load texture: " << image << std::endl;
 		ID = 0;
 		return;
 	}
-
-	// Auto-pick source/internal format based on channels
-	GLenum format = GL_RGBA;
-	if (numColCh == 3)
-		format = GL_RGB;
-	else if (numColCh == 1)
-		format = GL_RED;
-
-	// Generates an OpenGL texture object
-	glGenTextures(1, &ID);
-	// Assigns the texture to a Texture Unit
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_2D, ID);
-
-	// Configures the type of algorithm that is used to make the image smaller or bigger
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-	// Configures the way the texture repeats
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	// Assigns the image to the OpenGL Texture object
-	glTexImage2D(GL_TEXTURE_2D, 0, format, widthImg, heightImg, 0, format, pixelType, bytes);
-	// Generates MipMaps
-	glGenerateMipmap(GL_TEXTURE_2D);
-
-	// Deletes the image data as it is already in the OpenGL Texture object
-	stbi_image_free(bytes);
-
-	// Unbinds the OpenGL Texture object so that it can't accidentally be modified
-	glBindTexture(GL_TEXTURE_2D, 0);
+	upload(decoded, pixelType);
 }
 
 // Constructor for embedded textures loaded from memory
@@ -61,69 +64,160 @@ Texture::Texture(const unsigned char* data, size_t size, const char* texType, GL
 	// Remember the slot
 	slot = texSlot;
 
-	// Stores the width, height, and the number of color channels of the image
-	int widthImg, heightImg, numColCh;
-	// Flips the image so it appears right side up
-	stbi_set_flip_vertically_on_load(true);
-	// Reads the image loaded from memory
-	unsigned char* bytes = stbi_load_from_memory(data, static_cast<int>(size), &widthImg, &heightImg, &numColCh, 0);
-	if (!bytes) {
+	// Reads the image loaded from memory, flipped so it appears right side up
+	TextureRequest request;
+	request.data = data;
+	request.size = size;
+	DecodedImage decoded = TextureDecoder::decode(request);
+	if (!decoded.isValid()) {
 		std::cerr << "Failed to load embedded texture: " <<  std::endl;
 		ID = 0;
 		return;
 	}
+	upload(decoded, pixelType);
+}
+
+// Constructor for images already decoded (e.g. by TextureDecoder::decodeBatch)
+Texture::Texture(const DecodedImage& image, const char* texType, GLuint texSlot, GLenum pixelType) {
+	type = texType;
+	slot = texSlot;
+	if (!image.isValid()) {
+		ID = 0;
+		return;
+	}
+	upload(image, pixelType);
+}
+
+// Constructor for baked levels (e.g. by TextureBaker::loadOrBake on a worker)
+Texture::Texture(const BakedTexture& baked, const char* texType, GLuint texSlot) {
+	type = texType;
+	slot = texSlot;
+	if (!baked.isValid()) {
+		ID = 0;
+		return;
+	}
+	uploadBaked(baked);
+}
+
+void Texture::upload(const DecodedImage& image, GLenum pixelType) {
+	width = image.width;
+	height = image.height;
+	channels = image.channels;
 
 	// Auto-pick source/internal format based on channels
 	GLenum format = GL_RGBA;
-	if (numColCh == 3)
+	if (channels == 3)
 		format = GL_RGB;
-	else if (numColCh == 1)
+	else if (channels == 1)
 		format = GL_RED;
 
 	// Generates an OpenGL texture object
 	glGenTextures(1, &ID);
 	// Assigns the texture to a Texture Unit
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_2D, ID);
+	GLState::bindTexture(slot, GL_TEXTURE_2D, ID);
 
 	// Configures the type of algorithm that is used to make the image smaller or bigger
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	if (image.fromMemory) {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+	else {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
 
 	// Configures the way the texture repeats
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
 	// Assigns the image to the OpenGL Texture object
-	glTexImage2D(GL_TEXTURE_2D, 0, format, widthImg, heightImg, 0, format, pixelType, bytes);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, pixelType, image.pixels.get());
 	// Generates MipMaps
 	glGenerateMipmap(GL_TEXTURE_2D);
+	// a full mip chain adds roughly a third
+	byteSize = static_cast<size_t>(width) * height * channels;
+	byteSize += byteSize / 3;
 
-	// Deletes the image data as it is already in the OpenGL Texture object
-	stbi_image_free(bytes);
+	// Unbinds the OpenGL Texture object so that it can't accidentally be modified
+	GLState::bindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::uploadBaked(const BakedTexture& baked) {
+	width = baked.width;
+	height = baked.height;
+	channels = baked.format == TextureFormat::BC5 ? 2 : 4;
+	GLenum compressed = compressedFormat(baked.format);
+	if (!compressed && baked.format != TextureFormat::RGBA8)
+		std::cout << "[Texture] Block format not supported, uploading decoded RGBA8\n";
+
+	glGenTextures(1, &ID);
+	GLState::bindTexture(slot, GL_TEXTURE_2D, ID);
+
+	// same sampling as file textures, over the levels that were baked
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(baked.levels.size()) - 1);
+
+	byteSize = 0;
+	for (int level = 0; level < int(baked.levels.size()); ++level) {
+		int w = baked.levelWidth(level), h = baked.levelHeight(level);
+		const std::vector<uint8_t>& data = baked.levels[level];
+		if (compressed) {
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, compressed, w, h, 0, GLsizei(data.size()), data.data());
+			byteSize += data.size();
+			continue;
+		}
+		std::vector<uint8_t> decoded = TextureBaker::decodeLevel(baked, level);
+		glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, w, h, 0,
+			GL_RGBA, GL_UNSIGNED_BYTE, decoded.data());
+		byteSize += decoded.size();
+	}
 
 	// Unbinds the OpenGL Texture object so that it can't accidentally be modified
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::bindTexture(GL_TEXTURE_2D, 0);
 }
 
-void Texture::texUnit(Shader& shader, const char* uniform, GLuint unit) {
-	// Gets the location of the uniform
-	GLuint texUni = glGetUniformLocation(shader.ID, uniform);
+void Texture::texUnit(Shader& shader, const UniformName& uniform, GLuint unit) {
 	// Shader needs to be activated before changing the value of a uniform
+	// (skipped when already current)
 	shader.Activate();
-	// Sets the value of the uniform
-	glUniform1i(texUni, unit);
+	// Sets the value of the uniform through the shader's location cache
+	shader.setInt(uniform, static_cast<int>(unit));
 }
 
 void Texture::Bind() {
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_2D, ID);
+	GLState::bindTexture(slot, GL_TEXTURE_2D, ID);
+}
+
+void Texture::Bind(GLuint unit) {
+	GLState::bindTexture(unit, GL_TEXTURE_2D, ID);
+}
+
+size_t Texture::getByteSize() const {
+	return byteSize;
+}
+
+GLenum Texture::compressedFormat(TextureFormat format) {
+	// looked up once, with the first context
+	static const bool s3tc = hasExtension("GL_EXT_texture_compression_s3tc");
+	static const bool bptc = hasExtension("GL_ARB_texture_compression_bptc");
+	switch (format) {
+	case TextureFormat::BC1: return s3tc ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : 0;
+	case TextureFormat::BC3: return s3tc ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : 0;
+	// RGTC is core since 3.0
+	case TextureFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+	case TextureFormat::BC7: return bptc ? GL_COMPRESSED_RGBA_BPTC_UNORM : 0;
+	default: return 0;
+	}
 }
 
 void Texture::Unbind() {
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::bindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Texture::Delete() {
-	glDeleteTextures(1, &ID);
+	GLState::deleteTexture(ID);
 }
\ No newline at end of file
@@ -0,0 +1,1095 @@
+#include "engine/TextureBaker.h"
+#include "engine/ThreadPool.h"
+#include <stb_image.h>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+namespace fs = std::filesystem;
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ENGINE_TEXTURE_SSE 1
+#endif
+
+namespace {
+
+    // rows of a mip level filtered by one task
+    const int ROWS_PER_TASK = 16;
+
+    bool enabled = false;
+
+    constexpr uint32_t fourCC(char a, char b, char c, char d) {
+        return uint32_t(uint8_t(a)) | uint32_t(uint8_t(b)) << 8 | uint32_t(uint8_t(c)) << 16 | uint32_t(uint8_t(d)) << 24;
+    }
+
+    // DDS layout, see the DirectX "DDS_HEADER" and "DDS_HEADER_DXT10" docs
+    struct DDSPixelFormat {
+        uint32_t size, flags, fourCC, rgbBitCount, rMask, gMask, bMask, aMask;
+    };
+
+    struct DDSHeader {
+        uint32_t size, flags, height, width, pitchOrLinearSize, depth, mipMapCount;
+        uint32_t reserved1[11]; // [0..7] hold the bake fingerprint, see BAKE_TAG
+        DDSPixelFormat format;
+        uint32_t caps, caps2, caps3, caps4, reserved2;
+    };
+
+    struct DDSHeaderDX10 {
+        uint32_t dxgiFormat, resourceDimension, miscFlag, arraySize, miscFlags2;
+    };
+
+    static_assert(sizeof(DDSHeader) == 124, "DDS header is 124 bytes");
+    static_assert(sizeof(DDSHeaderDX10) == 20, "DX10 header is 20 bytes");
+
+    const uint32_t DDS_MAGIC = fourCC('D', 'D', 'S', ' ');
+    const uint32_t DX10 = fourCC('D', 'X', '1', '0');
+    // marks a file written by TextureBaker, followed by version, source state,
+    // options and BAKE_FLAGS
+    const uint32_t BAKE_TAG = fourCC('E', 'B', 'A', 'K');
+    // rows are stored bottom-up, ready to upload without a flip
+    const uint32_t BAKE_BOTTOM_UP = 0x1;
+
+    const uint32_t DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PIXELFORMAT = 0x1000;
+    const uint32_t DDSD_MIPMAPCOUNT = 0x20000, DDSD_LINEARSIZE = 0x80000;
+    const uint32_t DDPF_FOURCC = 0x4;
+    const uint32_t DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000;
+    const uint32_t DIMENSION_TEXTURE2D = 3;
+    // larger files are rejected before anything is allocated
+    const uint32_t MAX_DDS_DIMENSION = 16384;
+
+    // DXGI_FORMAT values, unorm then srgb
+    const uint32_t DXGI_FORMATS[size_t(TextureFormat::Count)][2] = {
+        { 28, 29 }, // R8G8B8A8
+        { 71, 72 }, // BC1
+        { 77, 78 }, // BC3
+        { 83, 83 }, // BC5 has no srgb variant
+        { 98, 99 }, // BC7
+    };
+
+    // BC7 interpolation weights of 4-bit indices (out of 64)
+    const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    double msSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // sRGB <-> linear, decoding by table, encoding by search over the
+    // midpoints of that table so a round trip is exact
+    struct SrgbTables {
+        float toLinear[256];
+        float midpoints[255];
+
+        SrgbTables() {
+            for (int i = 0; i < 256; ++i) {
+                float c = float(i) / 255.0f;
+                toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            for (int i = 0; i < 255; ++i) midpoints[i] = 0.5f * (toLinear[i] + toLinear[i + 1]);
+        }
+
+        uint8_t encode(float linear) const {
+            return uint8_t(std::upper_bound(midpoints, midpoints + 255, linear) - midpoints);
+        }
+    };
+
+    const SrgbTables& srgbTables() {
+        static const SrgbTables tables;
+        return tables;
+    }
+
+    uint8_t toByte(float v) {
+        return uint8_t(std::min(std::max(v * 255.0f + 0.5f, 0.0f), 255.0f));
+    }
+
+    // 2x2 box filter of RGBA floats over rows [firstRow, lastRow) of dst,
+    // odd sizes clamp the last row/column
+    void downsampleRows(const std::vector<float>& src, int srcWidth, int srcHeight,
+        std::vector<float>& dst, int dstWidth, int firstRow, int lastRow, bool normalMap) {
+        for (int y = firstRow; y < lastRow; ++y) {
+            int y0 = std::min(y * 2, srcHeight - 1), y1 = std::min(y * 2 + 1, srcHeight - 1);
+            const float* row0 = src.data() + size_t(y0) * srcWidth * 4;
+            const float* row1 = src.data() + size_t(y1) * srcWidth * 4;
+            float* out = dst.data() + size_t(y) * dstWidth * 4;
+            for (int x = 0; x < dstWidth; ++x, out += 4) {
+                int x0 = std::min(x * 2, srcWidth - 1) * 4, x1 = std::min(x * 2 + 1, srcWidth - 1) * 4;
+#ifdef ENGINE_TEXTURE_SSE
+                __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1)),
+                    _mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1)));
+                _mm_storeu_ps(out, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#else
+                for (int c = 0; c < 4; ++c)
+                    out[c] = 0.25f * (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]);
+#endif
+                if (normalMap) {
+                    // averaged vectors shrink, put them back on the unit sphere
+                    float nx = out[0] * 2.0f - 1.0f, ny = out[1] * 2.0f - 1.0f, nz = out[2] * 2.0f - 1.0f;
+                    float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+                    if (length > 1e-6f) {
+                        float s = 0.5f / length;
+                        out[0] = nx * s + 0.5f;
+                        out[1] = ny * s + 0.5f;
+                        out[2] = nz * s + 0.5f;
+                    }
+                }
+            }
+        }
+    }
+
+    // ---- block codecs ----
+
+    // Endpoints of the principal axis through the pixels (power iteration on
+    // the covariance), channels 3 for RGB or 4 for RGBA
+    void principalEndpoints(const float px[16][4], int channels, float lo[4], float hi[4]) {
+        float mean[4] = {}, minimum[4], maximum[4];
+        for (int c = 0; c < 4; ++c) {
+            minimum[c] = 255.0f;
+            maximum[c] = 0.0f;
+        }
+        for (int i = 0; i < 16; ++i) {
+            for (int c = 0; c < channels; ++c) {
+                mean[c] += px[i][c];
+                minimum[c] = std::min(minimum[c], px[i][c]);
+                maximum[c] = std::max(maximum[c], px[i][c]);
+            }
+        }
+        for (int c = 0; c < channels; ++c) mean[c] /= 16.0f;
+
+        float cov[4][4] = {};
+        for (int i = 0; i < 16; ++i) {
+            float d[4];
+            for (int c = 0; c < channels; ++c) d[c] = px[i][c] - mean[c];
+            for (int a = 0; a < channels; ++a)
+                for (int b = 0; b < channels; ++b) cov[a][b] += d[a] * d[b];
+        }
+
+        float axis[4] = {};
+        float length2 = 0.0f;
+        for (int c = 0; c < channels; ++c) {
+            axis[c] = maximum[c] - minimum[c];
+            length2 += axis[c] * axis[c];
+        }
+        if (length2 == 0.0f) {
+            for (int c = 0; c < channels; ++c) lo[c] = hi[c] = mean[c];
+            return;
+        }
+        for (int iteration = 0; iteration < 8; ++iteration) {
+            float next[4] = {};
+            float norm = 0.0f;
+            for (int a = 0; a < channels; ++a) {
+                for (int b = 0; b < channels; ++b) next[a] += cov[a][b] * axis[b];
+                norm += next[a] * next[a];
+            }
+            if (norm < 1e-12f) break;
+            norm = 1.0f / std::sqrt(norm);
+            for (int c = 0; c < channels; ++c) axis[c] = next[c] * norm;
+        }
+        float axisLength2 = 0.0f;
+        for (int c = 0; c < channels; ++c) axisLength2 += axis[c] * axis[c];
+        float inverse = 1.0f / std::sqrt(axisLength2);
+        for (int c = 0; c < channels; ++c) axis[c] *= inverse;
+
+        float tMin = std::numeric_limits<float>::max(), tMax = -tMin;
+        for (int i = 0; i < 16; ++i) {
+            float t = 0.0f;
+            for (int c = 0; c < channels; ++c) t += (px[i][c] - mean[c]) * axis[c];
+            tMin = std::min(tMin, t);
+            tMax = std::max(tMax, t);
+        }
+        for (int c = 0; c < channels; ++c) {
+            lo[c] = std::min(std::max(mean[c] + axis[c] * tMin, 0.0f), 255.0f);
+            hi[c] = std::min(std::max(mean[c] + axis[c] * tMax, 0.0f), 255.0f);
+        }
+    }
+
+    // Least squares endpoints for fixed indices; weights[index] is the share of e1
+    bool refineEndpoints(const float px[16][4], int channels, const uint8_t indices[16],
+        const float* weights, float e0[4], float e1[4]) {
+        float a = 0.0f, b = 0.0f, c = 0.0f;
+        float r0[4] = {}, r1[4] = {};
+        for (int i = 0; i < 16; ++i) {
+            float t = weights[indices[i]], s = 1.0f - t;
+            a += s * s;
+            b += s * t;
+            c += t * t;
+            for (int ch = 0; ch < channels; ++ch) {
+                r0[ch] += s * px[i][ch];
+                r1[ch] += t * px[i][ch];
+            }
+        }
+        float det = a * c - b * b;
+        if (std::fabs(det) < 1e-6f) return false;
+        float inverse = 1.0f / det;
+        for (int ch = 0; ch < channels; ++ch) {
+            e0[ch] = std::min(std::max((c * r0[ch] - b * r1[ch]) * inverse, 0.0f), 255.0f);
+            e1[ch] = std::min(std::max((a * r1[ch] - b * r0[ch]) * inverse, 0.0f), 255.0f);
+        }
+        return true;
+    }
+
+    uint16_t pack565(const float c[3]) {
+        int r = std::min(std::max(int(c[0] * 31.0f / 255.0f + 0.5f), 0), 31);
+        int g = std::min(std::max(int(c[1] * 63.0f / 255.0f + 0.5f), 0), 63);
+        int b = std::min(std::max(int(c[2] * 31.0f / 255.0f + 0.5f), 0), 31);
+        return uint16_t(r << 11 | g << 5 | b);
+    }
+
+    void unpack565(uint16_t c, int out[4]) {
+        int r = c >> 11 & 31, g = c >> 5 & 63, b = c & 31;
+        out[0] = r << 3 | r >> 2;
+        out[1] = g << 2 | g >> 4;
+        out[2] = b << 3 | b >> 2;
+        out[3] = 255;
+    }
+
+    // BC1 palette in index order; three colors plus transparent black when c0 <= c1
+    void colorPalette(uint16_t c0, uint16_t c1, bool fourColor, int palette[4][4]) {
+        unpack565(c0, palette[0]);
+        unpack565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            if (fourColor) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            } else {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = fourColor ? 255 : 0;
+    }
+
+    // BC1 color block, always in four color mode (BC3 reads it that way too)
+    void encodeColor(const uint8_t rgba[64], uint8_t out[8]) {
+        static const float weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+        float px[16][4];
+        for (int i = 0; i < 16; ++i)
+            for (int c = 0; c < 4; ++c) px[i][c] = float(rgba[i * 4 + c]);
+
+        float e0[4], e1[4];
+        principalEndpoints(px, 3, e1, e0);
+
+        uint16_t best0 = 0, best1 = 0;
+        uint32_t bestIndices = 0;
+        int bestError = std::numeric_limits<int>::max();
+        for (int pass = 0; pass < 2; ++pass) {
+            uint16_t c0 = pack565(e0), c1 = pack565(e1);
+            if (c0 < c1) std::swap(c0, c1);
+            int palette[4][4];
+            colorPalette(c0, c1, true, palette);
+
+            uint8_t picked[16];
+            uint32_t indices = 0;
+            int error = 0;
+            for (int i = 0; i < 16; ++i) {
+                int bestK = 0, bestD = std::numeric_limits<int>::max();
+                // equal endpoints: every index decodes to c0
+                for (int k = 0; k < (c0 == c1 ? 1 : 4); ++k) {
+                    int dr = palette[k][0] - rgba[i * 4], dg = palette[k][1] - rgba[i * 4 + 1], db = palette[k][2] - rgba[i * 4 + 2];
+                    int d = dr * dr + dg * dg + db * db;
+                    if (d < bestD) {
+                        bestD = d;
+                        bestK = k;
+                    }
+                }
+                picked[i] = uint8_t(bestK);
+                indices |= uint32_t(bestK) << (2 * i);
+                error += bestD;
+            }
+            if (error < bestError) {
+                bestError = error;
+                best0 = c0;
+                best1 = c1;
+                bestIndices = indices;
+            }
+            if (c0 == c1 || error == 0) break;
+            // endpoints that fit the chosen indices best, then one more round
+            float u0[3], u1[3];
+            for (int c = 0; c < 3; ++c) {
+                u0[c] = float(palette[0][c]);
+                u1[c] = float(palette[1][c]);
+            }
+            if (!refineEndpoints(px, 3, picked, weights, u0, u1)) break;
+            std::copy(u0, u0 + 3, e0);
+            std::copy(u1, u1 + 3, e1);
+        }
+        out[0] = uint8_t(best0);
+        out[1] = uint8_t(best0 >> 8);
+        out[2] = uint8_t(best1);
+        out[3] = uint8_t(best1 >> 8);
+        for (int i = 0; i < 4; ++i) out[4 + i] = uint8_t(bestIndices >> (8 * i));
+    }
+
+    void decodeColor(const uint8_t block[8], bool forceFourColor, uint8_t rgba[64]) {
+        uint16_t c0 = uint16_t(block[0] | block[1] << 8), c1 = uint16_t(block[2] | block[3] << 8);
+        uint32_t indices = uint32_t(block[4]) | uint32_t(block[5]) << 8 | uint32_t(block[6]) << 16 | uint32_t(block[7]) << 24;
+        int palette[4][4];
+        colorPalette(c0, c1, forceFourColor || c0 > c1, palette);
+        for (int i = 0; i < 16; ++i) {
+            const int* p = palette[indices >> (2 * i) & 3];
+            for (int c = 0; c < 4; ++c) rgba[i * 4 + c] = uint8_t(p[c]);
+        }
+    }
+
+    // BC4 palette: eight values when a0 > a1, else six plus 0 and 255
+    void singlePalette(int a0, int a1, int palette[8]) {
+        palette[0] = a0;
+        palette[1] = a1;
+        if (a0 > a1) {
+            for (int i = 2; i < 8; ++i) palette[i] = ((8 - i) * a0 + (i - 1) * a1 + 3) / 7;
+        } else {
+            for (int i = 2; i < 6; ++i) palette[i] = ((6 - i) * a0 + (i - 1) * a1 + 2) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    // One channel (BC4 block), values[i * stride]
+    void encodeSingle(const uint8_t* values, int stride, uint8_t out[8]) {
+        int lo = 255, hi = 0;
+        for (int i = 0; i < 16; ++i) {
+            lo = std::min(lo, int(values[i * stride]));
+            hi = std::max(hi, int(values[i * stride]));
+        }
+        std::memset(out, 0, 8);
+        out[0] = uint8_t(hi);
+        out[1] = uint8_t(lo);
+        if (lo == hi) return;
+
+        int palette[8];
+        singlePalette(hi, lo, palette);
+        uint64_t bits = 0;
+        for (int i = 0; i < 16; ++i) {
+            int v = values[i * stride], bestK = 0, bestD = 256;
+            for (int k = 0; k < 8; ++k) {
+                int d = std::abs(palette[k] - v);
+                if (d < bestD) {
+                    bestD = d;
+                    bestK = k;
+                }
+            }
+            bits |= uint64_t(bestK) << (3 * i);
+        }
+        for (int i = 0; i < 6; ++i) out[2 + i] = uint8_t(bits >> (8 * i));
+    }
+
+    void decodeSingle(const uint8_t block[8], uint8_t* values, int stride) {
+        int palette[8];
+        singlePalette(block[0], block[1], palette);
+        uint64_t bits = 0;
+        for (int i = 0; i < 6; ++i) bits |= uint64_t(block[2 + i]) << (8 * i);
+        for (int i = 0; i < 16; ++i) values[i * stride] = uint8_t(palette[bits >> (3 * i) & 7]);
+    }
+
+    struct BitWriter {
+        uint8_t* out;
+        int position = 0;
+        void put(uint32_t value, int bits) {
+            for (int i = 0; i < bits; ++i, ++position)
+                if (value >> i & 1u) out[position >> 3] |= uint8_t(1u << (position & 7));
+        }
+    };
+
+    struct BitReader {
+        const uint8_t* in;
+        int position = 0;
+        uint32_t get(int bits) {
+            uint32_t value = 0;
+            for (int i = 0; i < bits; ++i, ++position)
+                value |= uint32_t(in[position >> 3] >> (position & 7) & 1u) << i;
+            return value;
+        }
+    };
+
+    // 7-bit endpoint plus p-bit (shared by the channels) closest to e
+    void quantizeBC7(const float e[4], int q[4], int& pBit) {
+        float bestError = std::numeric_limits<float>::max();
+        for (int p = 0; p < 2; ++p) {
+            int candidate[4];
+            float error = 0.0f;
+            for (int c = 0; c < 4; ++c) {
+                candidate[c] = std::min(std::max(int((e[c] - float(p)) * 0.5f + 0.5f), 0), 127);
+                float d = float(candidate[c] * 2 + p) - e[c];
+                error += d * d;
+            }
+            if (error < bestError) {
+                bestError = error;
+                pBit = p;
+                std::copy(candidate, candidate + 4, q);
+            }
+        }
+    }
+
+    // BC7 mode 6: one subset, RGBA endpoints, 4-bit indices
+    void encodeBC7(const uint8_t rgba[64], uint8_t out[16]) {
+        float weights[16];
+        for (int i = 0; i < 16; ++i) weights[i] = float(BC7_WEIGHTS[i]) / 64.0f;
+
+        float px[16][4];
+        for (int i = 0; i < 16; ++i)
+            for (int c = 0; c < 4; ++c) px[i][c] = float(rgba[i * 4 + c]);
+        float e0[4], e1[4];
+        principalEndpoints(px, 4, e0, e1);
+
+        int bestQ0[4] = {}, bestQ1[4] = {}, bestP0 = 0, bestP1 = 0;
+        uint8_t bestIndices[16] = {};
+        int bestError = std::numeric_limits<int>::max();
+        for (int pass = 0; pass < 2; ++pass) {
+            int q0[4], q1[4], p0, p1;
+            quantizeBC7(e0, q0, p0);
+            quantizeBC7(e1, q1, p1);
+            int palette[16][4];
+            for (int k = 0; k < 16; ++k) {
+                for (int c = 0; c < 4; ++c) {
+                    int a = q0[c] << 1 | p0, b = q1[c] << 1 | p1;
+                    palette[k][c] = ((64 - BC7_WEIGHTS[k]) * a + BC7_WEIGHTS[k] * b + 32) >> 6;
+                }
+            }
+            uint8_t picked[16];
+            int error = 0;
+            for (int i = 0; i < 16; ++i) {
+                int bestK = 0, bestD = std::numeric_limits<int>::max();
+                for (int k = 0; k < 16; ++k) {
+                    int d = 0;
+                    for (int c = 0; c < 4; ++c) {
+                        int diff = palette[k][c] - rgba[i * 4 + c];
+                        d += diff * diff;
+                    }
+                    if (d < bestD) {
+                        bestD = d;
+                        bestK = k;
+                    }
+                }
+                picked[i] = uint8_t(bestK);
+                error += bestD;
+            }
+            if (error < bestError) {
+                bestError = error;
+                std::copy(q0, q0 + 4, bestQ0);
+                std::copy(q1, q1 + 4, bestQ1);
+                bestP0 = p0;
+                bestP1 = p1;
+                std::copy(picked, picked + 16, bestIndices);
+            }
+            if (error == 0 || !refineEndpoints(px, 4, picked, weights, e0, e1)) break;
+        }
+
+        // the anchor index is stored without its top bit: swap the endpoints when it is set
+        if (bestIndices[0] >= 8) {
+            std::swap(bestQ0, bestQ1);
+            std::swap(bestP0, bestP1);
+            for (auto& index : bestIndices) index = uint8_t(15 - index);
+        }
+
+        std::memset(out, 0, 16);
+        BitWriter bits{ out };
+        bits.put(1u << 6, 7);
+        for (int c = 0; c < 4; ++c) {
+            bits.put(uint32_t(bestQ0[c]), 7);
+            bits.put(uint32_t(bestQ1[c]), 7);
+        }
+        bits.put(uint32_t(bestP0), 1);
+        bits.put(uint32_t(bestP1), 1);
+        for (int i = 0; i < 16; ++i) bits.put(bestIndices[i], i == 0 ? 3 : 4);
+    }
+
+    // Mode 6 only, the one encodeBC7 writes; other modes decode to zeros
+    void decodeBC7(const uint8_t block[16], uint8_t rgba[64]) {
+        std::memset(rgba, 0, 64);
+        if ((block[0] & 0x7F) != 0x40) return;
+        BitReader bits{ block };
+        bits.get(7);
+        int q[2][4];
+        for (int c = 0; c < 4; ++c) {
+            q[0][c] = int(bits.get(7));
+            q[1][c] = int(bits.get(7));
+        }
+        int p0 = int(bits.get(1)), p1 = int(bits.get(1));
+        for (int i = 0; i < 16; ++i) {
+            int w = BC7_WEIGHTS[bits.get(i == 0 ? 3 : 4)];
+            for (int c = 0; c < 4; ++c) {
+                int a = q[0][c] << 1 | p0, b = q[1][c] << 1 | p1;
+                rgba[i * 4 + c] = uint8_t(((64 - w) * a + w * b + 32) >> 6);
+            }
+        }
+    }
+
+    // ---- levels ----
+
+    size_t levelBytes(TextureFormat format, int width, int height) {
+        if (format == TextureFormat::RGBA8) return size_t(width) * height * 4;
+        return size_t((width + 3) / 4) * ((height + 3) / 4) * TextureBaker::blockBytes(format);
+    }
+
+    std::vector<uint8_t> encodeLevel(const std::vector<uint8_t>& rgba, int width, int height, TextureFormat format) {
+        if (format == TextureFormat::RGBA8) return rgba;
+        const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        const size_t size = TextureBaker::blockBytes(format);
+        std::vector<uint8_t> out(size_t(blocksX) * blocksY * size);
+        // one row of blocks per task
+        ThreadPool::shared().parallelFor(size_t(blocksY), [&](size_t by) {
+            uint8_t block[64];
+            for (int bx = 0; bx < blocksX; ++bx) {
+                for (int i = 0; i < 16; ++i) {
+                    int x = std::min(bx * 4 + (i & 3), width - 1);
+                    int y = std::min(int(by) * 4 + (i >> 2), height - 1);
+                    std::memcpy(block + i * 4, rgba.data() + (size_t(y) * width + x) * 4, 4);
+                }
+                TextureBaker::encodeBlock(format, block, out.data() + (by * blocksX + bx) * size);
+            }
+        });
+        return out;
+    }
+
+    // ---- orientation ----
+    // DDS rows are top-down, every other image in the engine is bottom-up.
+    // Files from other tools are flipped block by block on load, nothing is
+    // decoded. src[r] is the block row moved to row r.
+
+    // BC1 color block: 2-bit indices, one byte per row
+    void flipBC1Rows(uint8_t* block, const int src[4]) {
+        uint8_t rows[4];
+        std::memcpy(rows, block + 4, 4);
+        for (int r = 0; r < 4; ++r) block[4 + r] = rows[src[r]];
+    }
+
+    // BC4 block (BC3 alpha, either BC5 channel): 3-bit indices, 12 bits per row
+    void flipBC4Rows(uint8_t* block, const int src[4]) {
+        uint64_t bits = 0, flipped = 0;
+        for (int i = 0; i < 6; ++i) bits |= uint64_t(block[2 + i]) << (8 * i);
+        for (int r = 0; r < 4; ++r) flipped |= (bits >> (12 * src[r]) & 0xFFFu) << (12 * r);
+        for (int i = 0; i < 6; ++i) block[2 + i] = uint8_t(flipped >> (8 * i));
+    }
+
+    bool isBC7Mode6(const uint8_t* block) {
+        return (block[0] & 0x7F) == 0x40;
+    }
+
+    // BC7 mode 6, decoded into endpoints and indices and written back with the
+    // index rows moved. The weights are symmetric, so swapping the endpoints when
+    // the new anchor needs its top bit keeps every texel exact.
+    bool flipBC7Rows(uint8_t* block, const int src[4]) {
+        if (!isBC7Mode6(block)) return false;
+        BitReader bits{ block };
+        bits.get(7);
+        uint32_t q[2][4], p[2];
+        for (int c = 0; c < 4; ++c) {
+            q[0][c] = bits.get(7);
+            q[1][c] = bits.get(7);
+        }
+        p[0] = bits.get(1);
+        p[1] = bits.get(1);
+        uint8_t indices[16], flipped[16];
+        for (int i = 0; i < 16; ++i) indices[i] = uint8_t(bits.get(i == 0 ? 3 : 4));
+        for (int i = 0; i < 16; ++i) flipped[i] = indices[src[i >> 2] * 4 + (i & 3)];
+        if (flipped[0] >= 8) {
+            std::swap(q[0], q[1]);
+            std::swap(p[0], p[1]);
+            for (auto& index : flipped) index = uint8_t(15 - index);
+        }
+
+        std::memset(block, 0, 16);
+        BitWriter out{ block };
+        out.put(1u << 6, 7);
+        for (int c = 0; c < 4; ++c) {
+            out.put(q[0][c], 7);
+            out.put(q[1][c], 7);
+        }
+        out.put(p[0], 1);
+        out.put(p[1], 1);
+        for (int i = 0; i < 16; ++i) out.put(flipped[i], i == 0 ? 3 : 4);
+        return true;
+    }
+
+    // Vertical flip of one level in place. False for BC7 blocks in modes other
+    // than 6 (the only one parsed here) and for truncated data.
+    bool flipLevel(TextureFormat format, std::vector<uint8_t>& data, int width, int height) {
+        if (data.size() < levelBytes(format, width, height)) return false;
+        if (format == TextureFormat::RGBA8) {
+            const size_t rowBytes = size_t(width) * 4;
+            for (int y = 0; y < height / 2; ++y)
+                std::swap_ranges(data.begin() + y * rowBytes, data.begin() + (y + 1) * rowBytes,
+                    data.begin() + (height - 1 - y) * rowBytes);
+            return true;
+        }
+
+        // whole block rows swap and the rows inside each block reverse; a level
+        // shorter than a block only flips its valid rows. Taller levels whose
+        // height is not a multiple of 4 (odd mip tails of external files) end
+        // up with the block padding at the bottom, off by up to 3 texel rows.
+        const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        const size_t size = TextureBaker::blockBytes(format);
+        int src[4] = { 3, 2, 1, 0 };
+        if (height < 4)
+            for (int r = 0; r < 4; ++r) src[r] = r < height ? height - 1 - r : r;
+        const size_t rowBytes = size_t(blocksX) * size;
+        for (int by = 0; by < blocksY / 2; ++by)
+            std::swap_ranges(data.begin() + by * rowBytes, data.begin() + (by + 1) * rowBytes,
+                data.begin() + (blocksY - 1 - by) * rowBytes);
+        for (size_t b = 0; b < size_t(blocksX) * blocksY; ++b) {
+            uint8_t* block = data.data() + b * size;
+            switch (format) {
+            case TextureFormat::BC1:
+                flipBC1Rows(block, src);
+                break;
+            case TextureFormat::BC3:
+                flipBC4Rows(block, src);
+                flipBC1Rows(block + 8, src);
+                break;
+            case TextureFormat::BC5:
+                flipBC4Rows(block, src);
+                flipBC4Rows(block + 8, src);
+                break;
+            case TextureFormat::BC7:
+                if (!flipBC7Rows(block, src)) return false;
+                break;
+            default:
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void toRGBA(const uint8_t* pixels, size_t count, int channels, uint8_t* out) {
+        for (size_t i = 0; i < count; ++i, out += 4) {
+            const uint8_t* p = pixels + i * channels;
+            switch (channels) {
+            case 1: out[0] = out[1] = out[2] = p[0]; out[3] = 255; break;
+            case 2: out[0] = out[1] = out[2] = p[0]; out[3] = p[1]; break;
+            case 3: out[0] = p[0]; out[1] = p[1]; out[2] = p[2]; out[3] = 255; break;
+            default: std::memcpy(out, p, 4); break;
+            }
+        }
+    }
+
+    bool sourceState(const std::string& path, uint64_t& size, int64_t& time) {
+        std::error_code ec;
+        size = fs::file_size(path, ec);
+        if (ec) return false;
+        auto t = fs::last_write_time(path, ec);
+        if (ec) return false;
+        time = static_cast<int64_t>(t.time_since_epoch().count());
+        return true;
+    }
+
+    uint32_t optionsKey(const TextureBakeOptions& options) {
+        return uint32_t(options.format) | uint32_t(options.srgb) << 8 | uint32_t(options.normalMap) << 9
+            | uint32_t(options.mipmaps) << 10;
+    }
+
+} // namespace
+
+TextureBakeOptions TextureBakeOptions::forType(const char* texType) {
+    TextureBakeOptions options;
+    std::string type = texType ? texType : "";
+    if (type == "normal") {
+        options.format = TextureFormat::BC5;
+        options.srgb = false;
+        options.normalMap = true;
+    } else {
+        options.srgb = type == "diffuse";
+    }
+    return options;
+}
+
+size_t BakedTexture::getByteSize() const {
+    size_t bytes = 0;
+    for (const auto& level : levels) bytes += level.size();
+    return bytes;
+}
+
+void TextureBaker::setEnabled(bool on) {
+    enabled = on;
+}
+
+bool TextureBaker::isEnabled() {
+    return enabled;
+}
+
+std::vector<std::vector<uint8_t>> TextureBaker::generateMips(const uint8_t* rgba, int width, int height,
+    const TextureBakeOptions& options) {
+    std::vector<std::vector<uint8_t>> levels;
+    if (!rgba || width <= 0 || height <= 0) return levels;
+    const size_t count = size_t(width) * height;
+    levels.emplace_back(rgba, rgba + count * 4);
+    if (!options.mipmaps || (width == 1 && height == 1)) return levels;
+
+    // filtered in floats, linear light for color so dark texels do not win
+    const bool linearLight = options.srgb && !options.normalMap;
+    const SrgbTables& srgb = srgbTables();
+    std::vector<float> current(count * 4);
+    for (size_t i = 0; i < count * 4; ++i) {
+        bool color = linearLight && (i & 3) != 3;
+        current[i] = color ? srgb.toLinear[rgba[i]] : float(rgba[i]) / 255.0f;
+    }
+
+    int w = width, h = height;
+    std::vector<float> next;
+    while (w > 1 || h > 1) {
+        int nw = std::max(1, w / 2), nh = std::max(1, h / 2);
+        next.assign(size_t(nw) * nh * 4, 0.0f);
+        std::vector<uint8_t> bytes(next.size());
+        const int bands = (nh + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+        ThreadPool::shared().parallelFor(size_t(bands), [&](size_t band) {
+            int firstRow = int(band) * ROWS_PER_TASK;
+            int lastRow = std::min(firstRow + ROWS_PER_TASK, nh);
+            downsampleRows(current, w, h, next, nw, firstRow, lastRow, options.normalMap);
+            for (size_t i = size_t(firstRow) * nw * 4; i < size_t(lastRow) * nw * 4; ++i) {
+                bool color = linearLight && (i & 3) != 3;
+                bytes[i] = color ? srgb.encode(next[i]) : toByte(next[i]);
+            }
+        });
+        levels.push_back(std::move(bytes));
+        current.swap(next);
+        w = nw;
+        h = nh;
+    }
+    return levels;
+}
+
+BakedTexture TextureBaker::bake(const uint8_t* pixels, int width, int height, int channels,
+    const TextureBakeOptions& options) {
+    BakedTexture baked;
+    if (!pixels || width <= 0 || height <= 0 || channels < 1 || channels > 4
+        || options.format >= TextureFormat::Count) return baked;
+
+    std::vector<uint8_t> rgba;
+    const uint8_t* source = pixels;
+    if (channels != 4) {
+        rgba.resize(size_t(width) * height * 4);
+        toRGBA(pixels, size_t(width) * height, channels, rgba.data());
+        source = rgba.data();
+    }
+
+    baked.format = options.format;
+    baked.srgb = options.srgb && !options.normalMap && options.format != TextureFormat::BC5;
+    baked.width = width;
+    baked.height = height;
+    std::vector<std::vector<uint8_t>> mips = generateMips(source, width, height, options);
+    baked.levels.resize(mips.size());
+    for (size_t l = 0; l < mips.size(); ++l)
+        baked.levels[l] = encodeLevel(mips[l], baked.levelWidth(int(l)), baked.levelHeight(int(l)), options.format);
+    return baked;
+}
+
+bool TextureBaker::bakeFile(const std::string& path, BakedTexture& out, const TextureBakeOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    // flipped like TextureDecoder's default, with the thread-local flag
+    int width, height, channels;
+    stbi_set_flip_vertically_on_load_thread(1);
+    unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    if (!data) {
+        std::cerr << "[TextureBaker] Failed to load " << path << ": " << stbi_failure_reason() << "\n";
+        return false;
+    }
+    out = bake(data, width, height, 4, options);
+    stbi_image_free(data);
+    std::cout << "[TextureBaker] Baked " << path << " (" << width << "x" << height << ", "
+        << out.levels.size() << " levels) in " << msSince(start) << " ms\n";
+    return out.isValid();
+}
+
+void TextureBaker::encodeBlock(TextureFormat format, const uint8_t rgba[64], uint8_t* out) {
+    switch (format) {
+    case TextureFormat::BC1:
+        encodeColor(rgba, out);
+        break;
+    case TextureFormat::BC3:
+        encodeSingle(rgba + 3, 4, out);
+        encodeColor(rgba, out + 8);
+        break;
+    case TextureFormat::BC5:
+        encodeSingle(rgba, 4, out);
+        encodeSingle(rgba + 1, 4, out + 8);
+        break;
+    case TextureFormat::BC7:
+        encodeBC7(rgba, out);
+        break;
+    default:
+        std::memcpy(out, rgba, 64);
+        break;
+    }
+}
+
+void TextureBaker::decodeBlock(TextureFormat format, const uint8_t* block, uint8_t rgba[64]) {
+    switch (format) {
+    case TextureFormat::BC1:
+        decodeColor(block, false, rgba);
+        break;
+    case TextureFormat::BC3:
+        decodeColor(block + 8, true, rgba);
+        decodeSingle(block, rgba + 3, 4);
+        break;
+    case TextureFormat::BC5:
+        decodeSingle(block, rgba, 4);
+        decodeSingle(block + 8, rgba + 1, 4);
+        for (int i = 0; i < 16; ++i) {
+            rgba[i * 4 + 2] = 0;
+            rgba[i * 4 + 3] = 255;
+        }
+        break;
+    case TextureFormat::BC7:
+        decodeBC7(block, rgba);
+        break;
+    default:
+        std::memcpy(rgba, block, 64);
+        break;
+    }
+}
+
+size_t TextureBaker::blockBytes(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::BC1: return 8;
+    case TextureFormat::BC3:
+    case TextureFormat::BC5:
+    case TextureFormat::BC7: return 16;
+    default: return 64;
+    }
+}
+
+std::vector<uint8_t> TextureBaker::decodeLevel(const BakedTexture& texture, int level) {
+    if (level < 0 || level >= int(texture.levels.size())) return {};
+    const int width = texture.levelWidth(level), height = texture.levelHeight(level);
+    const std::vector<uint8_t>& data = texture.levels[level];
+    if (texture.format == TextureFormat::RGBA8) return data;
+
+    std::vector<uint8_t> rgba(size_t(width) * height * 4);
+    const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    const size_t size = blockBytes(texture.format);
+    if (data.size() < size_t(blocksX) * blocksY * size) return {};
+    ThreadPool::shared().parallelFor(size_t(blocksY), [&](size_t by) {
+        uint8_t block[64];
+        for (int bx = 0; bx < blocksX; ++bx) {
+            decodeBlock(texture.format, data.data() + (by * blocksX + bx) * size, block);
+            for (int i = 0; i < 16; ++i) {
+                int x = bx * 4 + (i & 3), y = int(by) * 4 + (i >> 2);
+                if (x < width && y < height)
+                    std::memcpy(rgba.data() + (size_t(y) * width + x) * 4, block + i * 4, 4);
+            }
+        }
+    });
+    return rgba;
+}
+
+double TextureBaker::measurePSNR(const BakedTexture& texture, const uint8_t* rgba) {
+    std::vector<uint8_t> decoded = decodeLevel(texture, 0);
+    if (decoded.empty() || !rgba) return 0.0;
+    const int channels = texture.format == TextureFormat::BC1 ? 3 : (texture.format == TextureFormat::BC5 ? 2 : 4);
+    double sum = 0.0;
+    const size_t count = size_t(texture.width) * texture.height;
+    for (size_t i = 0; i < count; ++i) {
+        for (int c = 0; c < channels; ++c) {
+            double d = double(decoded[i * 4 + c]) - double(rgba[i * 4 + c]);
+            sum += d * d;
+        }
+    }
+    double mse = sum / double(count * channels);
+    if (mse == 0.0) return std::numeric_limits<double>::infinity();
+    return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+std::string TextureBaker::cachePathFor(const std::string& path) {
+    return path + ".dds";
+}
+
+bool TextureBaker::isContainer(const std::string& path) {
+    std::string extension = fs::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+    return extension == ".dds";
+}
+
+bool TextureBaker::writeDDS(const std::string& ddsPath, const BakedTexture& texture,
+    const std::string& sourcePath, const TextureBakeOptions& options) {
+    if (!texture.isValid() || texture.format >= TextureFormat::Count) return false;
+
+    DDSHeader header{};
+    header.size = sizeof(DDSHeader);
+    header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+    header.height = uint32_t(texture.height);
+    header.width = uint32_t(texture.width);
+    header.pitchOrLinearSize = uint32_t(texture.levels[0].size());
+    header.mipMapCount = uint32_t(texture.levels.size());
+    header.format.size = sizeof(DDSPixelFormat);
+    header.format.flags = DDPF_FOURCC;
+    header.format.fourCC = DX10;
+    header.caps = DDSCAPS_TEXTURE | (texture.levels.size() > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+    header.reserved1[0] = BAKE_TAG;
+    header.reserved1[1] = VERSION;
+    header.reserved1[7] = BAKE_BOTTOM_UP;
+    if (!sourcePath.empty()) {
+        uint64_t size = 0;
+        int64_t time = 0;
+        if (!sourceState(sourcePath, size, time)) return false;
+        header.reserved1[2] = uint32_t(size);
+        header.reserved1[3] = uint32_t(size >> 32);
+        header.reserved1[4] = uint32_t(uint64_t(time));
+        header.reserved1[5] = uint32_t(uint64_t(time) >> 32);
+        header.reserved1[6] = optionsKey(options);
+    }
+
+    DDSHeaderDX10 dx10{};
+    dx10.dxgiFormat = DXGI_FORMATS[size_t(texture.format)][texture.srgb ? 1 : 0];
+    dx10.resourceDimension = DIMENSION_TEXTURE2D;
+    dx10.arraySize = 1;
+
+    // write to a temporary file and swap it in, so readers never see a partial file
+    std::string tmpPath = ddsPath + ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(DDS_MAGIC));
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(&dx10), sizeof(dx10));
+        for (const auto& level : texture.levels)
+            out.write(reinterpret_cast<const char*>(level.data()), std::streamsize(level.size()));
+        if (!out) {
+            out.close();
+            fs::remove(tmpPath, ec);
+            return false;
+        }
+    }
+    fs::rename(tmpPath, ddsPath, ec);
+    if (ec) {
+        // some platforms refuse to rename over an existing file
+        fs::remove(ddsPath, ec);
+        fs::rename(tmpPath, ddsPath, ec);
+    }
+    return !ec;
+}
+
+bool TextureBaker::readDDS(const std::string& ddsPath, BakedTexture& out,
+    const std::string& sourcePath, const TextureBakeOptions& options) {
+    std::ifstream in(ddsPath, std::ios::binary);
+    uint32_t magic = 0;
+    DDSHeader header{};
+    if (!in || !in.read(reinterpret_cast<char*>(&magic), sizeof(magic))
+        || !in.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || magic != DDS_MAGIC || header.size != sizeof(DDSHeader) || header.width == 0 || header.height == 0
+        || header.width > MAX_DDS_DIMENSION || header.height > MAX_DDS_DIMENSION)
+        return false;
+
+    if (!sourcePath.empty()) {
+        uint64_t size = 0;
+        int64_t time = 0;
+        if (!sourceState(sourcePath, size, time)) return false;
+        if (header.reserved1[0] != BAKE_TAG || header.reserved1[1] != VERSION
+            || header.reserved1[2] != uint32_t(size) || header.reserved1[3] != uint32_t(size >> 32)
+            || header.reserved1[4] != uint32_t(uint64_t(time)) || header.reserved1[5] != uint32_t(uint64_t(time) >> 32)
+            || header.reserved1[6] != optionsKey(options))
+            return false;
+    }
+
+    BakedTexture texture;
+    texture.width = int(header.width);
+    texture.height = int(header.height);
+    bool known = false;
+    if (header.format.fourCC == DX10) {
+        DDSHeaderDX10 dx10{};
+        if (!in.read(reinterpret_cast<char*>(&dx10), sizeof(dx10)) || dx10.arraySize > 1) return false;
+        for (size_t f = 0; f < size_t(TextureFormat::Count) && !known; ++f) {
+            for (int s = 0; s < 2 && !known; ++s) {
+                if (DXGI_FORMATS[f][s] != dx10.dxgiFormat) continue;
+                texture.format = TextureFormat(f);
+                texture.srgb = s == 1;
+                known = true;
+            }
+        }
+    } else if (header.format.flags & DDPF_FOURCC) {
+        // legacy files from other tools
+        const uint32_t code = header.format.fourCC;
+        known = true;
+        if (code == fourCC('D', 'X', 'T', '1')) texture.format = TextureFormat::BC1;
+        else if (code == fourCC('D', 'X', 'T', '5')) texture.format = TextureFormat::BC3;
+        else if (code == fourCC('A', 'T', 'I', '2') || code == fourCC('B', 'C', '5', 'U')) texture.format = TextureFormat::BC5;
+        else known = false;
+    }
+    if (!known) {
+        std::cerr << "[TextureBaker] Unsupported DDS format in " << ddsPath << "\n";
+        return false;
+    }
+
+    // a full chain at most, and every level has to be in the file before
+    // anything is allocated
+    int maxLevels = 1;
+    while ((std::max(texture.width, texture.height) >> maxLevels) > 0) ++maxLevels;
+    if (header.mipMapCount > uint32_t(maxLevels)) return false;
+    const int levels = std::max(1, int(header.mipMapCount));
+    uint64_t total = 0;
+    for (int l = 0; l < levels; ++l)
+        total += levelBytes(texture.format, texture.levelWidth(l), texture.levelHeight(l));
+    std::error_code ec;
+    const uint64_t fileSize = fs::file_size(ddsPath, ec);
+    const std::streamoff offset = in.tellg();
+    if (ec || offset < 0 || total > fileSize - uint64_t(offset)) return false;
+
+    // our own files are already bottom-up, other tools write top-down
+    const bool bottomUp = header.reserved1[0] == BAKE_TAG && header.reserved1[1] == VERSION
+        && (header.reserved1[7] & BAKE_BOTTOM_UP) != 0;
+    texture.levels.resize(size_t(levels));
+    for (int l = 0; l < levels; ++l) {
+        texture.levels[l].resize(levelBytes(texture.format, texture.levelWidth(l), texture.levelHeight(l)));
+        if (!in.read(reinterpret_cast<char*>(texture.levels[l].data()), std::streamsize(texture.levels[l].size())))
+            return false;
+        if (bottomUp) continue;
+        if (!flipLevel(texture.format, texture.levels[l], texture.levelWidth(l), texture.levelHeight(l))) {
+            std::cerr << "[TextureBaker] Cannot flip " << ddsPath << " (BC7 modes other than 6 are not decoded)\n";
+            return false;
+        }
+    }
+    out = std::move(texture);
+    return true;
+}
+
+bool TextureBaker::loadOrBake(const std::string& path, BakedTexture& out, const TextureBakeOptions& options) {
+    if (isContainer(path)) return readDDS(path, out);
+
+    std::string cachePath = cachePathFor(path);
+    if (readDDS(cachePath, out, path, options)) return true;
+    if (!bakeFile(path, out, options)) return false;
+    if (!writeDDS(cachePath, out, path, options))
+        std::cerr << "[TextureBaker] Could not write " << cachePath << "\n";
+    return true;
+}
+
+TextureBakeBenchmark TextureBaker::benchmark(int size, unsigned seed) {
+    TextureBakeBenchmark result;
+    result.size = size = std::max(4, size);
+
+    // gradients, stripes, hard edges and a little noise
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> noise(-6, 6);
+    std::vector<uint8_t> image(size_t(size) * size * 4);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            float u = float(x) / float(size), v = float(y) / float(size);
+            uint8_t* p = image.data() + (size_t(y) * size + x) * 4;
+            float stripes = 0.5f + 0.5f * std::sin(u * 40.0f + v * 13.0f);
+            bool edge = ((x / 32) + (y / 32)) % 2 == 0;
+            p[0] = uint8_t(std::min(std::max(int(u * 255.0f) + noise(rng), 0), 255));
+            p[1] = uint8_t(std::min(std::max(int(stripes * 200.0f) + noise(rng), 0), 255));
+            p[2] = uint8_t(edge ? 220 : 40);
+            p[3] = uint8_t(v * 255.0f);
+        }
+    }
+
+    TextureBakeOptions options;
+    auto start = std::chrono::steady_clock::now();
+    generateMips(image.data(), size, size, options);
+    result.mipMs = msSince(start);
+
+    for (size_t f = 0; f < size_t(TextureFormat::Count); ++f) {
+        options.format = TextureFormat(f);
+        start = std::chrono::steady_clock::now();
+        BakedTexture baked = bake(image.data(), size, size, 4, options);
+        result.encodeMs[f] = msSince(start);
+        result.psnr[f] = measurePSNR(baked, image.data());
+        result.bytes[f] = baked.getByteSize();
+    }
+    return result;
+}
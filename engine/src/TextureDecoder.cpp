@@ -0,0 +1,44 @@
+#include "engine/TextureDecoder.h"
+#include "engine/ThreadPool.h"
+#include <iostream>
+#include <stb_image.h>
+
+DecodedImage TextureDecoder::decode(const TextureRequest& request) {
+    DecodedImage image;
+    image.fromMemory = request.data != nullptr;
+
+    // thread-local flip state, unlike stbi_set_flip_vertically_on_load
+    stbi_set_flip_vertically_on_load_thread(request.flipVertically ? 1 : 0);
+
+    unsigned char* bytes = nullptr;
+    if (request.data) {
+        bytes = stbi_load_from_memory(request.data, static_cast<int>(request.size),
+            &image.width, &image.height, &image.channels, 0);
+    }
+    else {
+        bytes = stbi_load(request.path.c_str(),
+            &image.width, &image.height, &image.channels, 0);
+    }
+
+    if (!bytes) {
+        std::cerr << "Failed to decode texture: "
+            << (request.data ? "<memory>" : request.path) << "\n";
+        image.width = image.height = image.channels = 0;
+        return image;
+    }
+    image.pixels = std::unique_ptr<unsigned char, void (*)(void*)>(bytes, stbi_image_free);
+    return image;
+}
+
+std::vector<DecodedImage> TextureDecoder::decodeBatch(const std::vector<TextureRequest>& requests,
+    ThreadPool& pool) {
+    std::vector<DecodedImage> images(requests.size());
+    pool.parallelFor(requests.size(), [&](size_t i) {
+        images[i] = decode(requests[i]);
+    });
+    return images;
+}
+
+std::vector<DecodedImage> TextureDecoder::decodeBatch(const std::vector<TextureRequest>& requests) {
+    return decodeBatch(requests, ThreadPool::shared());
+}
@@ -0,0 +1,243 @@
+#include "engine/TextureRegistry.h"
+#include "engine/TextureDecoder.h"
+#include "engine/TextureBaker.h"
+#include "engine/ThreadPool.h"
+#include <filesystem>
+#include <cstdio>
+namespace fs = std::filesystem;
+
+// canonical path so "a/../tex.png" and "tex.png" share one entry
+static std::string canonicalKey(const std::string& path) {
+    std::error_code ec;
+    fs::path canonical = fs::weakly_canonical(fs::path(path), ec);
+    return ec ? path : canonical.generic_string();
+}
+
+// 64-bit FNV-1a of the encoded bytes
+static std::string contentKey(const unsigned char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    char buf[48];
+    std::snprintf(buf, sizeof(buf), "embedded:%016llx:%zu",
+        static_cast<unsigned long long>(hash), size);
+    return buf;
+}
+
+TextureRegistry& TextureRegistry::instance() {
+    static TextureRegistry registry;
+    return registry;
+}
+
+TextureRegistry::~TextureRegistry() {
+    // static destruction runs after the context is gone; names die with it
+    for (auto& e : entries)
+        if (e.second.texture.use_count() == 1) e.second.texture->ID = 0;
+    for (auto& texture : retired)
+        if (texture.use_count() == 1) texture->ID = 0;
+}
+
+std::string TextureRegistry::keyFor(const TextureLoad& load) {
+    // the same image used as a different map type gets its own entry
+    if (load.data) return std::string(load.type) + "|" + contentKey(load.data, load.size);
+    return std::string(load.type) + "|" + canonicalKey(load.path);
+}
+
+std::shared_ptr<Texture> TextureRegistry::load(const std::string& path, const char* type, GLuint slot) {
+    TextureLoad request;
+    request.path = path;
+    request.type = type;
+    std::string key = keyFor(request);
+    if (auto tex = find(key)) return tex;
+
+    auto tex = std::make_shared<Texture>(path.c_str(), type, slot, GL_UNSIGNED_BYTE);
+    if (tex->ID == 0) return tex; // failed loads are not cached
+    insert(key, tex);
+    return tex;
+}
+
+std::shared_ptr<Texture> TextureRegistry::loadFromMemory(const unsigned char* data, size_t size,
+    const char* type, GLuint slot) {
+    TextureLoad request;
+    request.data = data;
+    request.size = size;
+    request.type = type;
+    std::string key = keyFor(request);
+    if (auto tex = find(key)) return tex;
+
+    auto tex = std::make_shared<Texture>(data, size, type, slot, GL_UNSIGNED_BYTE);
+    if (tex->ID == 0) return tex;
+    insert(key, tex);
+    return tex;
+}
+
+std::vector<std::shared_ptr<Texture>> TextureRegistry::loadBatch(const std::vector<TextureLoad>& loads) {
+    std::vector<std::shared_ptr<Texture>> results(loads.size());
+
+    // split into hits and unique misses
+    std::unordered_map<std::string, size_t> missIndex;
+    std::vector<std::vector<size_t>> missTargets;
+    std::vector<TextureRequest> requests;
+    std::vector<const TextureLoad*> missLoads;
+    std::vector<std::string> missKeys;
+    for (size_t i = 0; i < loads.size(); ++i) {
+        const TextureLoad& l = loads[i];
+        if (!l.data && l.path.empty()) continue;
+
+        std::string key = keyFor(l);
+        auto pending = missIndex.find(key);
+        if (pending != missIndex.end()) {
+            missTargets[pending->second].push_back(i);
+            continue;
+        }
+        if ((results[i] = find(key))) continue;
+
+        missIndex.emplace(key, requests.size());
+        missTargets.push_back({ i });
+        TextureRequest r;
+        r.path = l.path;
+        r.data = l.data;
+        r.size = l.size;
+        requests.push_back(r);
+        missLoads.push_back(&l);
+        missKeys.push_back(std::move(key));
+    }
+
+    // with baking on, files load (or bake) their cached levels on workers instead
+    std::vector<BakedTexture> baked(requests.size());
+    if (TextureBaker::isEnabled()) {
+        ThreadPool::shared().parallelFor(requests.size(), [&](size_t m) {
+            if (!requests[m].path.empty())
+                TextureBaker::loadOrBake(requests[m].path, baked[m], TextureBakeOptions::forType(missLoads[m]->type));
+        });
+    }
+
+    // decode the rest on workers, then upload in one tight loop
+    std::vector<TextureRequest> pending;
+    std::vector<size_t> pendingIndex;
+    for (size_t m = 0; m < requests.size(); ++m) {
+        if (baked[m].isValid()) continue;
+        pending.push_back(requests[m]);
+        pendingIndex.push_back(m);
+    }
+    std::vector<DecodedImage> decoded = TextureDecoder::decodeBatch(pending);
+    std::vector<DecodedImage> images(requests.size());
+    for (size_t i = 0; i < decoded.size(); ++i) images[pendingIndex[i]] = std::move(decoded[i]);
+    for (size_t m = 0; m < images.size(); ++m) {
+        const TextureLoad& l = *missLoads[m];
+        auto tex = baked[m].isValid()
+            ? std::make_shared<Texture>(baked[m], l.type, l.slot)
+            : std::make_shared<Texture>(images[m], l.type, l.slot, GL_UNSIGNED_BYTE);
+        images[m].pixels.reset();
+        baked[m] = BakedTexture();
+        if (tex->ID != 0) insert(missKeys[m], tex);
+        for (size_t target : missTargets[m]) results[target] = tex;
+    }
+    return results;
+}
+
+std::shared_ptr<Texture> TextureRegistry::find(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        ++stats.misses;
+        return nullptr;
+    }
+    ++stats.hits;
+    it->second.lastUse = ++useCounter;
+    return it->second.texture;
+}
+
+void TextureRegistry::insert(const std::string& key, const std::shared_ptr<Texture>& texture) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry& e = entries[key];
+    // a concurrent load of the same key may have won, keep the newest
+    if (e.texture) {
+        stats.residentBytes -= e.bytes;
+        --stats.residentCount;
+    }
+    e.texture = texture;
+    e.bytes = texture->getByteSize();
+    e.lastUse = ++useCounter;
+    stats.residentBytes += e.bytes;
+    ++stats.residentCount;
+
+    if (budget != 0) evict(budget);
+}
+
+void TextureRegistry::evict(size_t targetBytes) {
+    // caller holds the lock
+    while (stats.residentBytes > targetBytes) {
+        auto victim = entries.end();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            // only the registry holds it
+            if (it->second.texture.use_count() != 1) continue;
+            if (victim == entries.end() || it->second.lastUse < victim->second.lastUse)
+                victim = it;
+        }
+        if (victim == entries.end()) return; // everything left is in use
+
+        stats.residentBytes -= victim->second.bytes;
+        --stats.residentCount;
+        ++stats.evictions;
+        // may be a worker's upload context, deleted later by flushEvictions
+        retired.push_back(std::move(victim->second.texture));
+        entries.erase(victim);
+    }
+}
+
+void TextureRegistry::setBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    budget = bytes;
+    if (budget != 0) evict(budget);
+}
+
+size_t TextureRegistry::getBudget() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return budget;
+}
+
+void TextureRegistry::trim() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (budget != 0) evict(budget);
+}
+
+void TextureRegistry::purgeUnused() {
+    std::lock_guard<std::mutex> lock(mutex);
+    evict(0);
+}
+
+void TextureRegistry::flushEvictions() {
+    std::vector<std::shared_ptr<Texture>> doomed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        doomed.swap(retired);
+    }
+    // released outside the lock, the last reference deletes the GL texture
+}
+
+void TextureRegistry::shutdown() {
+    std::unordered_map<std::string, Entry> dropped;
+    std::vector<std::shared_ptr<Texture>> doomed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        dropped.swap(entries);
+        doomed.swap(retired);
+        stats.residentBytes = 0;
+        stats.residentCount = 0;
+    }
+}
+
+TextureStats TextureRegistry::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void TextureRegistry::resetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.hits = 0;
+    stats.misses = 0;
+    stats.evictions = 0;
+}
@@ -0,0 +1,102 @@
+#include "engine/ThreadPool.h"
+#include <atomic>
+#include <memory>
+#include <exception>
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0) threadCount = 1;
+    }
+    workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) return;
+    if (count == 1 || workers.empty()) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    // shared so helpers that start after the loop finished still see valid state
+    struct State {
+        std::atomic<size_t> next{ 0 };
+        std::atomic<size_t> done{ 0 };
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+        size_t count = 0;
+        std::function<void(size_t)> fn;
+    };
+    auto state = std::make_shared<State>();
+    state->count = count;
+    state->fn = fn;
+
+    auto run = [](const std::shared_ptr<State>& s) {
+        size_t completed = 0;
+        for (size_t i = s->next++; i < s->count; i = s->next++) {
+            try {
+                s->fn(i);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(s->mutex);
+                if (!s->error) s->error = std::current_exception();
+            }
+            ++completed;
+        }
+        if (completed > 0 && (s->done += completed) == s->count) {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            s->finished.notify_all();
+        }
+    };
+
+    size_t helpers = std::min<size_t>(workers.size(), count - 1);
+    for (size_t h = 0; h < helpers; ++h) {
+        submit([state, run]() { run(state); });
+    }
+    run(state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&]() { return state->done == state->count; });
+    if (state->error) std::rethrow_exception(state->error);
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
@@ -0,0 +1,146 @@
+#include "engine/UniformBuffer.h"
+#include "engine/GLState.h"
+#include <algorithm>
+
+namespace {
+
+    const GLsizeiptr FRAME_SIZE = sizeof(FrameUniforms);
+    // ring of object blocks, a few hundred draws between orphans
+    const GLsizeiptr OBJECT_RING_SIZE = 256 * 1024;
+    // GL 3.3 guarantees 36 binding points
+    const GLuint MAX_BINDINGS = 36;
+
+    // what each binding point holds, so repeated binds of the same range are skipped
+    struct BindingRange {
+        GLuint buffer = 0;
+        GLintptr offset = -1; // -1 for the whole buffer
+        GLsizeiptr size = 0;
+    };
+    thread_local BindingRange bindings[MAX_BINDINGS];
+
+    // cache entry of a binding point, points past the table are never cached
+    BindingRange& slot(GLuint binding) {
+        thread_local BindingRange untracked;
+        if (binding < MAX_BINDINGS) return bindings[binding];
+        untracked = BindingRange();
+        return untracked;
+    }
+
+    std::unique_ptr<UniformBuffer>& sharedFrame() {
+        static std::unique_ptr<UniformBuffer> buffer;
+        return buffer;
+    }
+
+    std::unique_ptr<UniformBuffer>& sharedObjects() {
+        static std::unique_ptr<UniformBuffer> buffer;
+        return buffer;
+    }
+
+} // namespace
+
+UniformBuffer::UniformBuffer(GLsizeiptr bufferSize, GLuint bindingPoint)
+    : size(bufferSize), binding(bindingPoint) {
+    glGenBuffers(1, &ID);
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, ID);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+}
+
+UniformBuffer::~UniformBuffer() {
+    if (ID == 0) return;
+    for (auto& b : bindings)
+        if (b.buffer == ID) b = BindingRange();
+    GLState::deleteBuffer(ID);
+}
+
+void UniformBuffer::update(const void* data, GLsizeiptr bytes, GLintptr offset) {
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, ID);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, bytes, data);
+    ++stats.uploads;
+    stats.bytes += size_t(bytes);
+
+    BindingRange& b = slot(binding);
+    if (b.buffer != ID || b.offset != -1) {
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, ID);
+        b.buffer = ID;
+        b.offset = -1;
+    }
+}
+
+GLintptr UniformBuffer::stream(const void* data, GLsizeiptr bytes) {
+    GLintptr offset = streamBatch(data, bytes, 1);
+    bindRange(offset, bytes);
+    return offset;
+}
+
+GLintptr UniformBuffer::streamBatch(const void* data, GLsizeiptr blockSize, size_t count) {
+    if (count == 0) return head;
+    GLsizeiptr stride = alignedSize(blockSize);
+    GLsizeiptr bytes = stride * GLsizeiptr(count - 1) + blockSize;
+    if (bytes > size) {
+        orphan(std::max(bytes, size * 2));
+    }
+    else if (head + bytes > size) {
+        // wrap: fresh storage, draws still reading the old blocks keep theirs
+        orphan(size);
+    }
+
+    GLintptr offset = head;
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, ID);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, bytes, data);
+    ++stats.uploads;
+    stats.bytes += size_t(bytes);
+    head = offset + alignedSize(bytes);
+    return offset;
+}
+
+void UniformBuffer::bindRange(GLintptr offset, GLsizeiptr bytes) {
+    BindingRange& b = slot(binding);
+    if (b.buffer == ID && b.offset == offset && b.size == bytes) return;
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, ID, offset, bytes);
+    b.buffer = ID;
+    b.offset = offset;
+    b.size = bytes;
+    ++stats.rangeBinds;
+}
+
+void UniformBuffer::orphan(GLsizeiptr newSize) {
+    size = newSize;
+    head = 0;
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, ID);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    // ranges bound from the old storage must be bound again
+    for (auto& b : bindings)
+        if (b.buffer == ID) b = BindingRange();
+    ++stats.orphans;
+}
+
+GLsizeiptr UniformBuffer::alignedSize(GLsizeiptr bytes) {
+    static GLint alignment = 0;
+    if (alignment == 0) {
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        if (alignment <= 0) alignment = 256;
+    }
+    return (bytes + alignment - 1) / alignment * alignment;
+}
+
+UniformBuffer& UniformBuffer::frame() {
+    auto& buffer = sharedFrame();
+    if (!buffer) buffer = std::make_unique<UniformBuffer>(FRAME_SIZE, FRAME_BINDING);
+    return *buffer;
+}
+
+UniformBuffer& UniformBuffer::objects() {
+    auto& buffer = sharedObjects();
+    if (!buffer) buffer = std::make_unique<UniformBuffer>(OBJECT_RING_SIZE, OBJECT_BINDING);
+    return *buffer;
+}
+
+void UniformBuffer::streamObject(const glm::mat4& model) {
+    ObjectUniforms block = ObjectUniforms::fromModel(model);
+    objects().stream(&block, sizeof(block));
+}
+
+void UniformBuffer::destroyShared() {
+    sharedFrame().reset();
+    sharedObjects().reset();
+}
@@ -0,0 +1,108 @@
+#include "engine/UniformTable.h"
+#include <chrono>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+
+    const size_t INITIAL_SLOTS = 32;
+
+} // namespace
+
+const GLint* UniformTable::find(uint64_t hash) const {
+    if (entries.empty()) return nullptr;
+    hash = slotHash(hash);
+    const size_t mask = entries.size() - 1;
+    for (size_t i = size_t(hash) & mask;; i = (i + 1) & mask) {
+        const Entry& e = entries[i];
+        if (e.hash == hash) return &e.location;
+        if (e.hash == 0) return nullptr;
+    }
+}
+
+void UniformTable::insert(const UniformName& name, GLint location) {
+    if ((count + 1) * 2 > entries.size()) grow();
+    uint64_t hash = slotHash(name.hash);
+    const size_t mask = entries.size() - 1;
+    size_t i = size_t(hash) & mask;
+    for (; entries[i].hash != 0; i = (i + 1) & mask) {
+        if (entries[i].hash != hash) continue;
+        if (names[i] != name.name)
+            std::cerr << "[UniformTable] Hash collision between " << names[i] << " and " << name.name << "\n";
+        entries[i].location = location;
+        return;
+    }
+    entries[i].hash = hash;
+    entries[i].location = location;
+    names[i] = name.name;
+    ++count;
+}
+
+void UniformTable::clear() {
+    entries.clear();
+    names.clear();
+    count = 0;
+}
+
+void UniformTable::grow() {
+    std::vector<Entry> oldEntries = std::move(entries);
+    std::vector<std::string> oldNames = std::move(names);
+    size_t slots = oldEntries.empty() ? INITIAL_SLOTS : oldEntries.size() * 2;
+    entries.assign(slots, Entry());
+    names.assign(slots, std::string());
+    count = 0;
+    for (size_t i = 0; i < oldEntries.size(); ++i) {
+        if (oldEntries[i].hash == 0) continue;
+        // stored hashes are already non-zero, slotHash keeps them
+        insert(UniformName(oldEntries[i].hash, oldNames[i].c_str()), oldEntries[i].location);
+    }
+}
+
+UniformLookupBenchmark UniformTable::benchmark(size_t nameCount, size_t lookups) {
+    using Clock = std::chrono::steady_clock;
+    auto nsPerLookup = [lookups](Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<double, std::nano>(b - a).count() / double(lookups);
+    };
+
+    std::vector<std::string> names;
+    for (size_t i = 0; i < nameCount; ++i) names.push_back("material.diffuse" + std::to_string(i));
+    // the literal path looks up "model" among the others
+    names.push_back("model");
+
+    std::unordered_map<std::string, GLint> stringMap;
+    UniformTable table;
+    std::vector<UniformHandle> handles;
+    for (size_t i = 0; i < names.size(); ++i) {
+        stringMap[names[i]] = GLint(i);
+        table.insert(names[i], GLint(i));
+        handles.push_back(UniformHandle(GLint(i)));
+    }
+
+    UniformLookupBenchmark result;
+    result.names = names.size();
+    // the sum keeps the lookups from being optimized away
+    volatile GLint sink = 0;
+    GLint sum = 0;
+
+    // callers passing a literal to a std::string API build a string per call
+    auto start = Clock::now();
+    for (size_t i = 0; i < lookups; ++i) sum += stringMap.find(std::string(names[i % names.size()].c_str()))->second;
+    result.stringMapNs = nsPerLookup(start, Clock::now());
+
+    start = Clock::now();
+    for (size_t i = 0; i < lookups; ++i) sum += *table.find(hashUniformName(names[i % names.size()].c_str()));
+    result.tableNs = nsPerLookup(start, Clock::now());
+
+    constexpr UniformName model("model");
+    start = Clock::now();
+    for (size_t i = 0; i < lookups; ++i) sum += *table.find(model.hash) + GLint(i & 1);
+    result.literalNs = nsPerLookup(start, Clock::now());
+
+    start = Clock::now();
+    for (size_t i = 0; i < lookups; ++i) sum += handles[i % handles.size()].location;
+    result.handleNs = nsPerLookup(start, Clock::now());
+
+    sink = sum;
+    (void)sink;
+    return result;
+}
@@ -1,5 +1,6 @@
 #include "engine/VAO.h"
 #include "engine/VBO.h"
+#include "engine/GLState.h"
 
 // Constructor that generates a VAO ID
 VAO::VAO() {
@@ -8,23 +9,31 @@ VAO::VAO() {
 
 // Links a VBO Attribute to the VAO using a certain layout for float attributes
 void VAO::LinkVBO(VBO& VBO, GLuint layout, GLint numComponents, GLsizei stride, const void* offset) {
+	// the array buffer binding is not VAO state, leaving it bound is harmless
 	VBO.Bind();
 	glVertexAttribPointer(layout, numComponents, GL_FLOAT, GL_FALSE, stride, offset);
 	glEnableVertexAttribArray(layout);
-	VBO.Unbind();
+}
+
+// Links a VBO Attribute of any component type to the VAO
+void VAO::LinkAttrib(VBO& VBO, GLuint layout, GLint numComponents, GLenum type,
+	GLboolean normalized, GLsizei stride, const void* offset) {
+	VBO.Bind();
+	glVertexAttribPointer(layout, numComponents, type, normalized, stride, offset);
+	glEnableVertexAttribArray(layout);
 }
 
 // Binds the VAO
 void VAO::Bind() {
-	glBindVertexArray(ID);
+	GLState::bindVertexArray(ID);
 }
 
 // Unbinds the VAO
 void VAO::Unbind() {
-	glBindVertexArray(0);
+	GLState::bindVertexArray(0);
 }
 
 // Deletes the VAO
 void VAO::Delete() {
-	glDeleteVertexArrays(1, &ID);
+	GLState::deleteVertexArray(ID);
 }
\ No newline at end of file
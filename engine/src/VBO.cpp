@@ -1,23 +1,32 @@
 #include "engine/VBO.h"
+#include "engine/GLState.h"
 
 // Constructor that generates a Vertex Buffer Object and links it to vertices
-VBO::VBO(const std::vector<Vertex>& vertices) {
+VBO::VBO(const std::vector<Vertex>& vertices)
+	: VBO(vertices.data(), vertices.size()) {}
+
+// Constructor that uploads vertices from any contiguous memory
+VBO::VBO(const Vertex* vertices, size_t count)
+	: VBO(static_cast<const void*>(vertices), count * sizeof(Vertex)) {}
+
+// Constructor that uploads raw vertex bytes
+VBO::VBO(const void* data, size_t bytes) {
 	glGenBuffers(1, &ID);
-	glBindBuffer(GL_ARRAY_BUFFER, ID);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, ID);
+	glBufferData(GL_ARRAY_BUFFER, bytes, data, GL_STATIC_DRAW);
 }
 
 // Binds the VBO
 void VBO::Bind() {
-	glBindBuffer(GL_ARRAY_BUFFER, ID);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, ID);
 }
 
 // Unbinds the VBO
 void VBO::Unbind() {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 // Deletes the VBO
 void VBO::Delete() {
-	glDeleteBuffers(1, &ID);
+	GLState::deleteBuffer(ID);
 }
\ No newline at end of file
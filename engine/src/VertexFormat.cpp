@@ -0,0 +1,164 @@
+#include "engine/VertexFormat.h"
+#include "engine/VAO.h"
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+    // Byte offsets of each attribute inside one vertex
+    struct Offsets {
+        size_t position, normal, color, uv, stride;
+    };
+
+    Offsets offsetsFor(const VertexFormat& f) {
+        Offsets o{};
+        if (f.isStandard()) {
+            o.position = 0;
+            o.normal = 3 * sizeof(float);
+            o.color = 6 * sizeof(float);
+            o.uv = 9 * sizeof(float);
+            o.stride = sizeof(Vertex);
+            return o;
+        }
+        size_t cursor = 0;
+        o.position = cursor;
+        cursor += f.quantizePositions ? 4 * sizeof(uint16_t) : 3 * sizeof(float);
+        o.normal = cursor;
+        cursor += f.packNormals ? sizeof(uint32_t) : 3 * sizeof(float);
+        o.color = cursor;
+        if (f.includeColor) cursor += sizeof(uint32_t);
+        o.uv = cursor;
+        cursor += f.uv == UVEncoding::Float ? 2 * sizeof(float) : 2 * sizeof(uint16_t);
+        o.stride = cursor;
+        return o;
+    }
+
+    // signed 10-bit x/y/z, w = 0, matching GL_INT_2_10_10_10_REV
+    uint32_t packNormal1010102(const glm::vec3& n) {
+        auto pack = [](float v) -> uint32_t {
+            int i = static_cast<int>(std::round(glm::clamp(v, -1.0f, 1.0f) * 511.0f));
+            return static_cast<uint32_t>(i) & 0x3FFu;
+        };
+        return pack(n.x) | (pack(n.y) << 10) | (pack(n.z) << 20);
+    }
+
+    template <typename T>
+    void put(unsigned char* dst, const T& value) {
+        std::memcpy(dst, &value, sizeof(T));
+    }
+
+} // namespace
+
+VertexFormat VertexFormat::compact() {
+    VertexFormat f;
+    f.packNormals = true;
+    f.uv = UVEncoding::Half;
+    f.includeColor = false;
+    return f;
+}
+
+VertexFormat VertexFormat::compactQuantized() {
+    VertexFormat f = compact();
+    f.quantizePositions = true;
+    return f;
+}
+
+bool VertexFormat::isStandard() const {
+    return !quantizePositions && !packNormals && uv == UVEncoding::Float && includeColor;
+}
+
+GLsizei VertexFormat::stride() const {
+    return static_cast<GLsizei>(offsetsFor(*this).stride);
+}
+
+std::vector<unsigned char> VertexFormat::encode(const Vertex* vertices, size_t count,
+    const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+    glm::vec3& quantMin, float& quantScale) const {
+    const Offsets o = offsetsFor(*this);
+    std::vector<unsigned char> out(count * o.stride);
+
+    // one scale for all axes keeps the dequantization a uniform scale
+    quantMin = boundsMin;
+    glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+    quantScale = std::max(std::max(extent.x, extent.y), extent.z);
+    float invScale = quantScale > 0.0f ? 1.0f / quantScale : 0.0f;
+
+    for (size_t i = 0; i < count; ++i) {
+        const Vertex& v = vertices[i];
+        unsigned char* dst = out.data() + i * o.stride;
+
+        if (isStandard()) {
+            put(dst, v);
+            continue;
+        }
+
+        if (quantizePositions) {
+            glm::vec3 p = (v.position - quantMin) * invScale;
+            uint16_t q[4] = {
+                glm::packUnorm1x16(p.x), glm::packUnorm1x16(p.y), glm::packUnorm1x16(p.z), 0 };
+            std::memcpy(dst + o.position, q, sizeof(q));
+        }
+        else {
+            put(dst + o.position, v.position);
+        }
+
+        if (packNormals) put(dst + o.normal, packNormal1010102(v.normal));
+        else put(dst + o.normal, v.normal);
+
+        if (includeColor) put(dst + o.color, glm::packUnorm4x8(glm::vec4(v.color, 1.0f)));
+
+        if (uv == UVEncoding::Float) {
+            put(dst + o.uv, v.texUV);
+        }
+        else if (uv == UVEncoding::Half) {
+            uint16_t h[2] = { glm::packHalf1x16(v.texUV.x), glm::packHalf1x16(v.texUV.y) };
+            std::memcpy(dst + o.uv, h, sizeof(h));
+        }
+        else {
+            uint16_t u[2] = { glm::packUnorm1x16(v.texUV.x), glm::packUnorm1x16(v.texUV.y) };
+            std::memcpy(dst + o.uv, u, sizeof(u));
+        }
+    }
+
+    if (!quantizePositions) {
+        quantMin = glm::vec3(0.0f);
+        quantScale = 1.0f;
+    }
+    return out;
+}
+
+void VertexFormat::link(VAO& vao, VBO& vbo) const {
+    const Offsets o = offsetsFor(*this);
+    const GLsizei s = static_cast<GLsizei>(o.stride);
+
+    // position
+    if (quantizePositions)
+        vao.LinkAttrib(vbo, 0, 3, GL_UNSIGNED_SHORT, GL_TRUE, s, (void*)o.position);
+    else
+        vao.LinkAttrib(vbo, 0, 3, GL_FLOAT, GL_FALSE, s, (void*)o.position);
+
+    // normal (packed normals must be read as 4 components)
+    if (packNormals)
+        vao.LinkAttrib(vbo, 1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, s, (void*)o.normal);
+    else
+        vao.LinkAttrib(vbo, 1, 3, GL_FLOAT, GL_FALSE, s, (void*)o.normal);
+
+    // color
+    if (isStandard())
+        vao.LinkAttrib(vbo, 2, 3, GL_FLOAT, GL_FALSE, s, (void*)o.color);
+    else if (includeColor)
+        vao.LinkAttrib(vbo, 2, 4, GL_UNSIGNED_BYTE, GL_TRUE, s, (void*)o.color);
+    else
+        glDisableVertexAttribArray(2);
+
+    // texture coordinates
+    if (uv == UVEncoding::Float)
+        vao.LinkAttrib(vbo, 3, 2, GL_FLOAT, GL_FALSE, s, (void*)o.uv);
+    else if (uv == UVEncoding::Half)
+        vao.LinkAttrib(vbo, 3, 2, GL_HALF_FLOAT, GL_FALSE, s, (void*)o.uv);
+    else
+        vao.LinkAttrib(vbo, 3, 2, GL_UNSIGNED_SHORT, GL_TRUE, s, (void*)o.uv);
+}